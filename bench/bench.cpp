@@ -0,0 +1,412 @@
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <glsl/glsl.h>
+#include "bench.h"
+
+using namespace glsl;
+using namespace glsl::bench;
+
+namespace {
+
+constexpr size_t Count = 1024;
+
+template<class T>
+const char* type_name() {
+    if constexpr (std::is_same_v<T, float>) {
+        return "float";
+    } else if constexpr (std::is_same_v<T, double>) {
+        return "double";
+    } else {
+        return "int";
+    }
+}
+
+/**
+ * Pseudo-random values inside the domain of every builtin: (0.1, 0.9) or odd integers in [-47, 47].
+ */
+template<class T>
+T value(size_t i) {
+    if constexpr (std::is_integral_v<T>) {
+        return T(2 * ((i * 7919u) % 48u)) - T(47);
+    } else {
+        return T(0.1) + T(0.8) * T((i * 7919u) % 1000u) / T(1000);
+    }
+}
+
+template<class T, size_t N>
+std::vector<Vector<T, N>> vectors(size_t seed) {
+    std::vector<Vector<T, N>> result(Count);
+    for (size_t i = 0; i < Count; ++i) {
+        Vector<T, N>::foreachIndex([&](size_t k) {
+            result[i][k] = value<T>(seed + i * N + k);
+        });
+    }
+    return result;
+}
+
+template<class T, size_t N>
+std::vector<Matrix<T, N, N>> matrices(size_t seed) {
+    std::vector<Matrix<T, N, N>> result(Count);
+    for (size_t i = 0; i < Count; ++i) {
+        Matrix<T, N, N>::foreachColumn([&](size_t c) {
+            Vector<T, N>::foreachIndex([&](size_t r) {
+                result[i][c][r] = value<T>(seed + i * N * N + c * N + r) + (c == r ? T(2) : T(0));
+            });
+        });
+    }
+    return result;
+}
+
+/**
+ * Registers out[i] = func(a[i], ...) over Count elements.
+ */
+template<class Out, class Func, class... In>
+void add_map(Registry& registry, const std::string& name, const char* type, Func func, const std::vector<In>&... in) {
+    auto out = std::make_shared<std::vector<Out>>(Count);
+    registry.add(name, type, Count, [=, ...in = in]() {
+        for (size_t i = 0; i < Count; ++i) {
+            (*out)[i] = func(in[i]...);
+        }
+        do_not_optimize(*out->data());
+    });
+}
+
+template<class T>
+void add_construction(Registry& registry) {
+    const char* type = type_name<T>();
+    auto s = vectors<T, 1>(1);
+    auto v2 = vectors<T, 2>(2);
+    auto v3 = vectors<T, 3>(3);
+
+    add_map<Vector<T, 2>>(registry, "vec2(s)", type, [](const auto& a) { return Vector<T, 2>(a[0]); }, s);
+    add_map<Vector<T, 3>>(registry, "vec3(x,y,z)", type, [](const auto& a) { return Vector<T, 3>(a[0], a[1], a[2]); }, v3);
+    add_map<Vector<T, 4>>(registry, "vec4(vec3,s)", type, [](const auto& a, const auto& b) { return Vector<T, 4>(a, b[0]); }, v3, s);
+    add_map<Vector<T, 4>>(registry, "vec4(vec2,vec2)", type, [](const auto& a) { return Vector<T, 4>(a, a); }, v2);
+    add_map<Matrix<T, 4, 4>>(registry, "mat4(s)", type, [](const auto& a) { return Matrix<T, 4, 4>(a[0]); }, s);
+}
+
+template<class T>
+void add_swizzle(Registry& registry) {
+    const char* type = type_name<T>();
+    auto v4 = vectors<T, 4>(4);
+
+    add_map<Vector<T, 3>>(registry, "swizzle.read(zyx)", type, [](const auto& a) { return Vector<T, 3>(a.zyx); }, v4);
+    add_map<Vector<T, 4>>(registry, "swizzle.read(wzyx)", type, [](const auto& a) { return Vector<T, 4>(a.wzyx); }, v4);
+    add_map<Vector<T, 4>>(registry, "swizzle.write(xy=yx)", type, [](const auto& a) {
+        Vector<T, 4> r(a);
+        r.xy = a.yx;
+        return r;
+    }, v4);
+}
+
+template<class T>
+void add_arithmetic(Registry& registry) {
+    const char* type = type_name<T>();
+    auto a = vectors<T, 4>(5), b = vectors<T, 4>(6);
+
+    add_map<Vector<T, 4>>(registry, "vec4+vec4", type, [](const auto& x, const auto& y) { return x + y; }, a, b);
+    add_map<Vector<T, 4>>(registry, "vec4-vec4", type, [](const auto& x, const auto& y) { return x - y; }, a, b);
+    add_map<Vector<T, 4>>(registry, "vec4*vec4", type, [](const auto& x, const auto& y) { return x * y; }, a, b);
+    add_map<Vector<T, 4>>(registry, "vec4*s", type, [](const auto& x, const auto& y) { return x * y[0]; }, a, b);
+}
+
+template<class T>
+void add_builtins(Registry& registry) {
+    const char* type = type_name<T>();
+    auto a = vectors<T, 4>(7), b = vectors<T, 4>(8), c = vectors<T, 4>(9);
+
+    auto add = [&](const char* name, auto func, auto... in) {
+        using Out = decltype(func(in[0]...));
+        add_map<Out>(registry, name, type, func, in...);
+    };
+
+#define FUNC1(name) add(#name, [](const auto& x) { return name(x); }, a)
+#define FUNC2(name) add(#name, [](const auto& x, const auto& y) { return name(x, y); }, a, b)
+#define FUNC3(name) add(#name, [](const auto& x, const auto& y, const auto& z) { return name(x, y, z); }, a, b, c)
+
+    FUNC1(abs);
+    FUNC1(sign);
+    FUNC2(max);
+    FUNC2(min);
+    FUNC3(clamp);
+    FUNC2(mod);
+    FUNC2(step);
+    FUNC2(equal);
+    FUNC2(notEqual);
+    FUNC2(greaterThan);
+    FUNC2(greaterThanEqual);
+    FUNC2(lessThan);
+    FUNC2(lessThanEqual);
+
+    if constexpr (std::is_floating_point_v<T>) {
+        FUNC1(acos);
+        FUNC1(asin);
+        FUNC1(cos);
+        FUNC1(sin);
+        FUNC1(tan);
+        FUNC1(degrees);
+        FUNC1(radians);
+        FUNC1(ceil);
+        FUNC1(exp);
+        FUNC1(exp2);
+        FUNC1(floor);
+        FUNC1(fract);
+        FUNC1(isinf);
+        FUNC1(isnan);
+        FUNC1(log);
+        FUNC1(log2);
+        FUNC2(pow);
+        FUNC1(round);
+        FUNC3(smoothstep);
+        FUNC1(sqrt);
+        FUNC1(inversesqrt);
+        FUNC1(trunc);
+        FUNC3(faceforward);
+        FUNC3(mix);
+        FUNC2(dot);
+        FUNC1(length);
+        FUNC2(distance);
+        FUNC1(normalize);
+        FUNC2(reflect);
+    }
+
+#undef FUNC1
+#undef FUNC2
+#undef FUNC3
+}
+
+/**
+ * The builtins with approximate lowp/mediump versions, on float vectors of the given trait.
+ */
+template<template<class, size_t> class Trait>
+void add_precision(Registry& registry, const char* type) {
+    auto convert = [](const std::vector<vec4>& in) {
+        return std::vector<Vector<float, 4, Trait>>(in.begin(), in.end());
+    };
+    auto a = convert(vectors<float, 4>(7)), b = convert(vectors<float, 4>(8));
+
+    add_map<Vector<float, 4, Trait>>(registry, "sin", type, [](const auto& x) { return sin(x); }, a);
+    add_map<Vector<float, 4, Trait>>(registry, "cos", type, [](const auto& x) { return cos(x); }, a);
+    add_map<Vector<float, 4, Trait>>(registry, "exp", type, [](const auto& x) { return exp(x); }, a);
+    add_map<Vector<float, 4, Trait>>(registry, "log", type, [](const auto& x) { return log(x); }, a);
+    add_map<Vector<float, 4, Trait>>(registry, "pow", type, [](const auto& x, const auto& y) { return pow(x, y); }, a, b);
+    add_map<Vector<float, 4, Trait>>(registry, "inversesqrt", type, [](const auto& x) { return inversesqrt(x); }, a);
+    add_map<Vector<float, 4, Trait>>(registry, "normalize", type, [](const auto& x) { return normalize(x); }, a);
+}
+
+template<class T, size_t N>
+void add_matrix(Registry& registry) {
+    const char* type = type_name<T>();
+    auto m = matrices<T, N>(10), k = matrices<T, N>(11);
+    auto v = vectors<T, N>(12);
+
+    const std::string suffix = "mat" + std::to_string(N);
+
+    // Integer elimination for 4x4 and larger divides by truncated pivots.
+    if constexpr (std::is_floating_point_v<T> || N < 4) {
+        add_map<T>(registry, "determinant(" + suffix + ")", type,
+                   [](const auto& x) { return determinant(x); }, m);
+    }
+    add_map<Matrix<T, N, N>>(registry, suffix + "*" + suffix, type,
+                             [](const auto& x, const auto& y) { return x * y; }, m, k);
+    add_map<Vector<T, N>>(registry, suffix + "*vec" + std::to_string(N), type,
+                          [](const auto& x, const auto& y) { return x * y; }, m, v);
+    add_map<Matrix<T, N, N>>(registry, "transpose(" + suffix + ")", type,
+                             [](const auto& x) { return transpose(x); }, m);
+
+    if constexpr (std::is_floating_point_v<T>) {
+        add_map<Matrix<T, N, N>>(registry, "inverse(" + suffix + ")", type,
+                                 [](const auto& x) { return inverse(x); }, m);
+    }
+}
+
+/**
+ * Bulk span kernels over Count elements, GLSL_ISA selects the instruction set they dispatch to.
+ */
+template<class T>
+void add_bulk(Registry& registry) {
+    const char* type = type_name<T>();
+    auto m = matrices<T, 4>(10)[0];
+    auto p = vectors<T, 3>(13);
+    auto v = vectors<T, 4>(14);
+
+    auto points = std::make_shared<std::vector<Vector<T, 3>>>(Count);
+    registry.add("transform_points", type, Count, [=]() {
+        transform_points(p, m, *points);
+        do_not_optimize(*points->data());
+    });
+    auto clip = std::make_shared<std::vector<Vector<T, 4>>>(Count);
+    registry.add("project_points", type, Count, [=]() {
+        project_points(p, m, *clip);
+        do_not_optimize(*clip->data());
+    });
+    auto out = std::make_shared<std::vector<Vector<T, 4>>>(Count);
+    registry.add("transform", type, Count, [=]() {
+        transform(v, m, *out);
+        do_not_optimize(*out->data());
+    });
+    auto values = std::make_shared<std::vector<T>>(Count);
+    registry.add("simplex(vec3)", type, Count, [=]() {
+        simplex<Vector<T, 3>>(p, *values);
+        do_not_optimize(*values->data());
+    });
+    registry.add("perlin(vec3)", type, Count, [=]() {
+        perlin<Vector<T, 3>>(p, *values);
+        do_not_optimize(*values->data());
+    });
+    auto tex = std::make_shared<Texture2D<Vector<T, 4>>>(256, 256);
+    tex->generateMipmap();
+    std::vector<Vector<float, 2>> uv(Count);
+    for (size_t i = 0; i < Count; ++i)
+        uv[i] = Vector<float, 2>(float(p[i].x), float(p[i].y));
+    registry.add("textureLod(vec2)", type, Count, [=]() {
+        textureLod(*tex, uv, 2.5f, *out);
+        do_not_optimize(*out->data());
+    });
+}
+
+/**
+ * Hand-written float[4] loops, the reference the library is compared against.
+ */
+void add_baseline(Registry& registry) {
+    using raw4 = std::array<float, 4>;
+    using raw16 = std::array<float, 16>;
+
+    auto convert = [](const auto& in) {
+        std::vector<raw4> out(in.size());
+        std::memcpy(out.data(), in.data(), in.size() * sizeof(raw4));
+        return out;
+    };
+
+    auto a = convert(vectors<float, 4>(5)), b = convert(vectors<float, 4>(6));
+    std::vector<raw16> m(Count);
+    auto mats = matrices<float, 4>(10);
+    std::memcpy(m.data(), mats.data(), Count * sizeof(raw16));
+
+    add_map<raw4>(registry, "vec4+vec4", "float[4]", [](const raw4& x, const raw4& y) {
+        raw4 r;
+        for (size_t i = 0; i < 4; ++i) r[i] = x[i] + y[i];
+        return r;
+    }, a, b);
+    add_map<raw4>(registry, "vec4*vec4", "float[4]", [](const raw4& x, const raw4& y) {
+        raw4 r;
+        for (size_t i = 0; i < 4; ++i) r[i] = x[i] * y[i];
+        return r;
+    }, a, b);
+    add_map<float>(registry, "dot", "float[4]", [](const raw4& x, const raw4& y) {
+        return x[0] * y[0] + x[1] * y[1] + x[2] * y[2] + x[3] * y[3];
+    }, a, b);
+    add_map<raw4>(registry, "normalize", "float[4]", [](const raw4& x) {
+        float s = 1.0f / std::sqrt(x[0] * x[0] + x[1] * x[1] + x[2] * x[2] + x[3] * x[3]);
+        return raw4{ x[0] * s, x[1] * s, x[2] * s, x[3] * s };
+    }, a);
+    add_map<raw4>(registry, "sin", "float[4]", [](const raw4& x) {
+        return raw4{ std::sin(x[0]), std::sin(x[1]), std::sin(x[2]), std::sin(x[3]) };
+    }, a);
+    add_map<raw4>(registry, "exp", "float[4]", [](const raw4& x) {
+        return raw4{ std::exp(x[0]), std::exp(x[1]), std::exp(x[2]), std::exp(x[3]) };
+    }, a);
+    add_map<raw4>(registry, "pow", "float[4]", [](const raw4& x, const raw4& y) {
+        return raw4{ std::pow(x[0], y[0]), std::pow(x[1], y[1]), std::pow(x[2], y[2]), std::pow(x[3], y[3]) };
+    }, a, b);
+    add_map<raw4>(registry, "mat4*vec4", "float[4]", [](const raw16& x, const raw4& y) {
+        raw4 r{};
+        for (size_t c = 0; c < 4; ++c)
+            for (size_t i = 0; i < 4; ++i) r[i] += x[c * 4 + i] * y[c];
+        return r;
+    }, m, a);
+    add_map<raw16>(registry, "mat4*mat4", "float[4]", [](const raw16& x, const raw16& y) {
+        raw16 r{};
+        for (size_t k = 0; k < 4; ++k)
+            for (size_t c = 0; c < 4; ++c)
+                for (size_t i = 0; i < 4; ++i) r[k * 4 + i] += x[c * 4 + i] * y[k * 4 + c];
+        return r;
+    }, m, m);
+}
+
+template<class T>
+void add_type(Registry& registry) {
+    add_construction<T>(registry);
+    add_swizzle<T>(registry);
+    add_arithmetic<T>(registry);
+    add_builtins<T>(registry);
+    add_matrix<T, 2>(registry);
+    add_matrix<T, 3>(registry);
+    add_matrix<T, 4>(registry);
+    if constexpr (std::is_floating_point_v<T>) {
+        add_bulk<T>(registry);
+    }
+}
+
+void usage() {
+    std::cerr << "usage: glsl_bench [--format=csv|json] [--filter=<substring>] [--min-time=<seconds>]\n"
+                 "                  [--repeats=<n>] [--output=<file>] [--list]\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string format = "csv", filter, output;
+    double min_time = 0.01;
+    int repeats = 3;
+    bool list = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg = argv[i];
+        auto option = [&](std::string_view name) {
+            return arg.starts_with(name) ? arg.substr(name.size()) : std::string_view();
+        };
+
+        if (auto v = option("--format="); !v.empty()) {
+            format = v;
+        } else if (auto v = option("--filter="); !v.empty()) {
+            filter = v;
+        } else if (auto v = option("--min-time="); !v.empty()) {
+            min_time = std::stod(std::string(v));
+        } else if (auto v = option("--repeats="); !v.empty()) {
+            repeats = std::stoi(std::string(v));
+        } else if (auto v = option("--output="); !v.empty()) {
+            output = v;
+        } else if (arg == "--list") {
+            list = true;
+        } else {
+            usage();
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+
+    if (format != "csv" && format != "json") {
+        usage();
+        return 1;
+    }
+
+    Registry registry;
+    add_type<float>(registry);
+    add_type<double>(registry);
+    add_type<int>(registry);
+    add_precision<MediumpVectorTrait>(registry, "mediump");
+    add_precision<LowpVectorTrait>(registry, "lowp");
+    add_baseline(registry);
+
+    if (list) {
+        for (const auto& c : registry.all())
+            std::cout << c.name << '/' << c.type << '\n';
+        return 0;
+    }
+
+    auto results = registry.run(filter, min_time, repeats);
+
+    std::ofstream file;
+    if (!output.empty())
+        file.open(output);
+    std::ostream& os = output.empty() ? std::cout : file;
+
+    if (format == "json") {
+        write_json(os, results);
+    } else {
+        write_csv(os, results);
+    }
+    return 0;
+}
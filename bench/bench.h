@@ -0,0 +1,109 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace glsl::bench {
+
+template<class T>
+inline void do_not_optimize(T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : "+m"(value) : : "memory");
+#else
+    static volatile const void* sink;
+    sink = &value;
+#endif
+}
+
+struct Case {
+    std::string name;
+    std::string type;
+    size_t ops;                     // operations performed by one call of body
+    std::function<void()> body;
+};
+
+struct Result {
+    std::string name;
+    std::string type;
+    double ns_per_op;
+    double ops_per_sec;
+};
+
+/**
+ * Calls body until min_seconds elapsed, repeats that `repeats` times and keeps the fastest run.
+ */
+inline double measure(const Case& c, double min_seconds, int repeats) {
+    using clock = std::chrono::steady_clock;
+
+    c.body();
+
+    double best = 0;
+    for (int r = 0; r < repeats; ++r) {
+        size_t calls = 0;
+        auto start = clock::now();
+        double elapsed = 0;
+        do {
+            c.body();
+            ++calls;
+            elapsed = std::chrono::duration<double>(clock::now() - start).count();
+        } while (elapsed < min_seconds);
+
+        double ns = elapsed * 1e9 / double(calls * c.ops);
+        best = r == 0 ? ns : std::min(best, ns);
+    }
+    return best;
+}
+
+class Registry {
+public:
+    void add(std::string name, std::string type, size_t ops, std::function<void()> body) {
+        cases.push_back({ std::move(name), std::move(type), ops, std::move(body) });
+    }
+
+    std::vector<Result> run(std::string_view filter, double min_seconds, int repeats) const {
+        std::vector<Result> results;
+        for (const auto& c : cases) {
+            if (!filter.empty() && (c.name + "/" + c.type).find(filter) == std::string::npos)
+                continue;
+            double ns = measure(c, min_seconds, repeats);
+            results.push_back({ c.name, c.type, ns, 1e9 / ns });
+        }
+        return results;
+    }
+
+    const std::vector<Case>& all() const {
+        return cases;
+    }
+
+private:
+    std::vector<Case> cases;
+};
+
+inline void write_csv(std::ostream& os, const std::vector<Result>& results) {
+    os << "name,type,ns_per_op,ops_per_sec\n";
+    for (const auto& r : results) {
+        char line[256];
+        std::snprintf(line, sizeof(line), "%s,%s,%.4f,%.1f\n", r.name.c_str(), r.type.c_str(), r.ns_per_op, r.ops_per_sec);
+        os << line;
+    }
+}
+
+inline void write_json(std::ostream& os, const std::vector<Result>& results) {
+    os << "[\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const auto& r = results[i];
+        char line[256];
+        std::snprintf(line, sizeof(line), R"(  {"name": "%s", "type": "%s", "ns_per_op": %.4f, "ops_per_sec": %.1f})",
+                      r.name.c_str(), r.type.c_str(), r.ns_per_op, r.ops_per_sec);
+        os << line << (i + 1 == results.size() ? "\n" : ",\n");
+    }
+    os << "]\n";
+}
+
+} // namespace glsl::bench
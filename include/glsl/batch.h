@@ -0,0 +1,274 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <ostream>
+#include "details/utils.h"
+#include "details/simd.h"
+
+namespace glsl {
+
+/**
+ * Packet of W scalars evaluated in lockstep ("wide lane").
+ * Used as the scalar of Vector or Matrix it turns every builtin into a structure-of-arrays kernel,
+ * e.g. Vector<Batch<float, 8>, 3> holds eight vec3 values. Comparisons yield Batch<bool, W> masks.
+ */
+template<class T, size_t W>
+struct alignas(std::min<size_t>(std::bit_ceil(sizeof(T) * W), 64)) Batch {
+
+    using BatchItem = T;
+    using Mask = Batch<bool, W>;
+    using Register = details::simd::Register<T, W>;
+
+    static constexpr size_t BatchWidth = W;
+
+    T lanes[W];
+
+public: // CONSTRUCTORS
+
+    constexpr Batch() : lanes{} {}
+
+    constexpr Batch(const Batch&) = default;
+
+    template<class U> requires (std::is_arithmetic_v<U>)
+    constexpr Batch(U scalar) {
+        foreachLane([&](size_t i) {
+            lanes[i] = static_cast<T>(scalar);
+        });
+    }
+
+    template<class... U> requires (W > 1 && sizeof...(U) == W && (std::is_arithmetic_v<U> && ...))
+    constexpr Batch(U... scalars) : lanes{ static_cast<T>(scalars)... } {}
+
+    template<class U> requires (!std::same_as<U, T>)
+    constexpr Batch(const Batch<U, W>& other) {
+        foreachLane([&](size_t i) {
+            lanes[i] = static_cast<T>(other[i]);
+        });
+    }
+
+    constexpr Batch& operator=(const Batch&) = default;
+
+public: // OPERATORS
+
+    constexpr T& operator[](size_t i) {
+        return lanes[i];
+    }
+
+    constexpr const T& operator[](size_t i) const {
+        return lanes[i];
+    }
+
+    constexpr Batch& operator+=(const Batch& v) { return *this = *this + v; }
+
+    constexpr Batch& operator-=(const Batch& v) { return *this = *this - v; }
+
+    constexpr Batch& operator*=(const Batch& v) { return *this = *this * v; }
+
+    constexpr Batch& operator/=(const Batch& v) { return *this = *this / v; }
+
+    constexpr Batch& operator%=(const Batch& v) requires std::integral<T> { return *this = *this % v; }
+
+    constexpr Batch& operator&=(const Batch& v) requires std::integral<T> { return *this = *this & v; }
+
+    constexpr Batch& operator|=(const Batch& v) requires std::integral<T> { return *this = *this | v; }
+
+    constexpr Batch& operator^=(const Batch& v) requires std::integral<T> { return *this = *this ^ v; }
+
+    constexpr Batch operator+() const {
+        return *this;
+    }
+
+    constexpr Batch operator-() const {
+        return Batch(0) - *this;
+    }
+
+    constexpr Batch operator~() const requires std::integral<T> {
+        return map([](T a) { return T(~a); });
+    }
+
+    constexpr Mask operator!() const {
+        Mask result;
+        foreachLane([&](size_t i) {
+            result[i] = !lanes[i];
+        });
+        return result;
+    }
+
+    friend constexpr Batch operator+(const Batch& a, const Batch& b) {
+        return zip<std::plus<>>(a, b);
+    }
+
+    friend constexpr Batch operator-(const Batch& a, const Batch& b) {
+        return zip<std::minus<>>(a, b);
+    }
+
+    friend constexpr Batch operator*(const Batch& a, const Batch& b) {
+        return zip<std::multiplies<>>(a, b);
+    }
+
+    friend constexpr Batch operator/(const Batch& a, const Batch& b) {
+        return zip<std::divides<>>(a, b);
+    }
+
+    friend constexpr Batch operator%(const Batch& a, const Batch& b) requires std::integral<T> {
+        return zip<std::modulus<>>(a, b);
+    }
+
+    friend constexpr Batch operator&(const Batch& a, const Batch& b) requires std::integral<T> {
+        return zip<std::bit_and<>>(a, b);
+    }
+
+    friend constexpr Batch operator|(const Batch& a, const Batch& b) requires std::integral<T> {
+        return zip<std::bit_or<>>(a, b);
+    }
+
+    friend constexpr Batch operator^(const Batch& a, const Batch& b) requires std::integral<T> {
+        return zip<std::bit_xor<>>(a, b);
+    }
+
+    friend constexpr Batch operator<<(const Batch& a, int n) requires std::integral<T> {
+        return a.map([n](T v) { return T(v << n); });
+    }
+
+    friend constexpr Batch operator>>(const Batch& a, int n) requires std::integral<T> {
+        return a.map([n](T v) { return T(v >> n); });
+    }
+
+    friend constexpr Mask operator==(const Batch& a, const Batch& b) { return compare<std::equal_to<>>(a, b); }
+
+    friend constexpr Mask operator!=(const Batch& a, const Batch& b) { return compare<std::not_equal_to<>>(a, b); }
+
+    friend constexpr Mask operator<(const Batch& a, const Batch& b) { return compare<std::less<>>(a, b); }
+
+    friend constexpr Mask operator<=(const Batch& a, const Batch& b) { return compare<std::less_equal<>>(a, b); }
+
+    friend constexpr Mask operator>(const Batch& a, const Batch& b) { return compare<std::greater<>>(a, b); }
+
+    friend constexpr Mask operator>=(const Batch& a, const Batch& b) { return compare<std::greater_equal<>>(a, b); }
+
+    friend std::ostream& operator<<(std::ostream& os, const Batch& obj) {
+        os << '[';
+        obj.foreachLane([&](size_t i) {
+            os << obj[i] << (i == W - 1 ? "" : " ");
+        });
+        return os << ']';
+    }
+
+public: // MATH
+
+    friend Batch sqrt(const Batch& x) {
+        if constexpr (Register::supported) {
+            return fromRegister(Register::sqrt(x.toRegister()));
+        } else {
+            return x.map([](T v) { return T(std::sqrt(v)); });
+        }
+    }
+
+    friend Batch abs(const Batch& x) {
+        return x.map([](T v) { return T(std::abs(v)); });
+    }
+
+    friend Batch floor(const Batch& x) {
+        return x.map([](T v) { return T(std::floor(v)); });
+    }
+
+    friend Batch ceil(const Batch& x) {
+        return x.map([](T v) { return T(std::ceil(v)); });
+    }
+
+    friend Batch trunc(const Batch& x) {
+        return x.map([](T v) { return T(std::trunc(v)); });
+    }
+
+    friend Batch round(const Batch& x) {
+        return x.map([](T v) { return T(std::round(v)); });
+    }
+
+public: // UTILS
+
+    template<class Func>
+    static constexpr void foreachLane(const Func& func) {
+        details::static_foreach<0, W>(func);
+    }
+
+    template<class Func>
+    constexpr auto map(const Func& func) const {
+        Batch<decltype(func(lanes[0])), W> result;
+        foreachLane([&](size_t i) {
+            result[i] = func(lanes[i]);
+        });
+        return result;
+    }
+
+    auto toRegister() const requires Register::supported {
+        return Register::load(lanes);
+    }
+
+    static Batch fromRegister(auto v) requires Register::supported {
+        Batch result;
+        Register::store(result.lanes, v);
+        return result;
+    }
+
+private:
+
+    template<class Op>
+    static constexpr Batch zip(const Batch& a, const Batch& b) {
+        if constexpr (Register::supported && details::simd::packed_op<Op>) {
+            if (!std::is_constant_evaluated())
+                return fromRegister(details::simd::apply<Op, Register>(a.toRegister(), b.toRegister()));
+        }
+        Batch result;
+        foreachLane([&](size_t i) {
+            result[i] = static_cast<T>(Op{}(a[i], b[i]));
+        });
+        return result;
+    }
+
+    template<class Op>
+    static constexpr Mask compare(const Batch& a, const Batch& b) {
+        Mask result;
+        foreachLane([&](size_t i) {
+            result[i] = Op{}(a[i], b[i]);
+        });
+        return result;
+    }
+};
+
+namespace details {
+
+template<class T, size_t W>
+constexpr Batch<T, W> select(const Batch<bool, W>& mask, const Batch<T, W>& a, const Batch<T, W>& b) {
+    Batch<T, W> result;
+    Batch<T, W>::foreachLane([&](size_t i) {
+        result[i] = mask[i] ? a[i] : b[i];
+    });
+    return result;
+}
+
+template<class T>
+constexpr decltype(auto) lane(const T& v, size_t i) {
+    if constexpr (concepts::Batch<T>) {
+        return v[i];
+    } else {
+        return v;
+    }
+}
+
+template<class Func, class... Args>
+constexpr auto lanewise(const Func& func, const Args&... args) {
+    constexpr size_t W = std::max({ traits::batch_trait<Args>::width... });
+    using Scalar = decltype(func(lane(args, 0)...));
+
+    Batch<Scalar, W> out;
+    details::static_foreach<0, W>([&](size_t i) {
+        out[i] = func(lane(args, i)...);
+    });
+    return out;
+}
+
+} // namespace details
+
+} // namespace glsl
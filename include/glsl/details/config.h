@@ -0,0 +1,28 @@
+#pragma once
+
+// The configuration macros and their defaults. Every header that reads one includes this first, so a
+// translation unit sees the same Vector layouts and operators whichever glsl header it includes first.
+
+#ifndef GLSL_VEC_SWIZZLING
+#define GLSL_VEC_SWIZZLING 1
+#endif
+
+#ifndef GLSL_VEC_XYZW
+#define GLSL_VEC_XYZW 1
+#endif
+
+#ifndef GLSL_VEC_RGBA
+#define GLSL_VEC_RGBA 1
+#endif
+
+#ifndef GLSL_VEC_STPQ
+#define GLSL_VEC_STPQ 1
+#endif
+
+#ifndef GLSL_SIMD
+#define GLSL_SIMD 1
+#endif
+
+#ifndef GLSL_EXPR_TEMPLATES
+#define GLSL_EXPR_TEMPLATES 0
+#endif
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdlib>
+#include <string_view>
+#include "simd.h"
+
+// AVX2 and AVX-512 kernels are compiled next to the baseline ones with target pragmas (GCC, Clang on x86-64).
+#if GLSL_SIMD_SSE2 && defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define GLSL_DISPATCH 1
+#endif
+
+// With GLSL_DISPATCH_LIBRARY the wide kernels and the CPU detection live in the glsl_dispatch library
+// (src/dispatch.cpp), translation units including the headers only see their declarations.
+#if GLSL_DISPATCH_LIBRARY && !GLSL_DISPATCH_IMPLEMENTATION
+#define GLSL_DISPATCH_DEFINITIONS 0
+#else
+#define GLSL_DISPATCH_DEFINITIONS 1
+#endif
+
+#if GLSL_DISPATCH_LIBRARY
+#define GLSL_DISPATCH_INLINE
+#else
+#define GLSL_DISPATCH_INLINE inline
+#endif
+
+namespace glsl {
+
+/**
+ * Instruction set of the bulk kernels (transform_points and friends), ordered by width.
+ * sse2 runs the kernels of the build's own target flags, avx2 and avx512 are compiled in regardless of them.
+ */
+enum class Isa {
+    sse2,
+    avx2,
+    avx512,
+};
+
+/**
+ * Widest instruction set the CPU supports, detected once on first use. The GLSL_ISA environment
+ * variable (sse2, avx2 or avx512) lowers it, e.g. to test every path on one machine.
+ */
+GLSL_DISPATCH_INLINE Isa active_isa();
+
+namespace details::dispatch {
+
+// Widest instruction set of the CPU and the one GLSL_ISA asks for, at most detected.
+GLSL_DISPATCH_INLINE Isa detect_isa();
+
+GLSL_DISPATCH_INLINE Isa requested_isa(Isa detected);
+
+#if GLSL_DISPATCH_DEFINITIONS
+
+GLSL_DISPATCH_INLINE Isa detect_isa() {
+#if GLSL_DISPATCH
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+        return Isa::avx512;
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+        return Isa::avx2;
+#endif
+    return Isa::sse2;
+}
+
+GLSL_DISPATCH_INLINE Isa requested_isa(Isa detected) {
+    const char* env = std::getenv("GLSL_ISA");
+    if (!env)
+        return detected;
+
+    std::string_view name = env;
+    Isa requested = name == "sse2" ? Isa::sse2 : name == "avx2" ? Isa::avx2 : detected;
+    return std::min(requested, detected);
+}
+
+#endif // GLSL_DISPATCH_DEFINITIONS
+
+} // namespace details::dispatch
+
+#if GLSL_DISPATCH_DEFINITIONS
+
+GLSL_DISPATCH_INLINE Isa active_isa() {
+    static const Isa isa = details::dispatch::requested_isa(details::dispatch::detect_isa());
+    return isa;
+}
+
+#endif // GLSL_DISPATCH_DEFINITIONS
+
+} // namespace glsl
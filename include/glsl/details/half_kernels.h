@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "dispatch.h"
+
+/**
+ * F16C variants of the binary16 span conversions, picked at run time by the half span kernels through
+ * active_isa(): every CPU with AVX2 also has F16C. Compiled under a target pragma like the transform kernels,
+ * so the build itself can stay at SSE2. They convert whole registers of 8 lanes and return how many they did.
+ */
+
+#if GLSL_DISPATCH && !GLSL_DISPATCH_DEFINITIONS
+
+namespace glsl::details::avx2 {
+
+size_t narrow_half(const float* in, uint16_t* out, size_t count);
+
+size_t widen_half(const uint16_t* in, float* out, size_t count);
+
+} // namespace glsl::details::avx2
+
+#elif GLSL_DISPATCH
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx2,fma,f16c"))), apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target("avx2,fma,f16c")
+#endif
+
+namespace glsl::details::avx2 {
+
+GLSL_DISPATCH_INLINE size_t narrow_half(const float* in, uint16_t* out, size_t count) {
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m128i h0 = _mm256_cvtps_ph(_mm256_loadu_ps(in + i), _MM_FROUND_TO_NEAREST_INT);
+        __m128i h1 = _mm256_cvtps_ph(_mm256_loadu_ps(in + i + 8), _MM_FROUND_TO_NEAREST_INT);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), h0);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i + 8), h1);
+    }
+    for (; i + 8 <= count; i += 8) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm256_cvtps_ph(_mm256_loadu_ps(in + i), _MM_FROUND_TO_NEAREST_INT));
+    }
+    return i;
+}
+
+GLSL_DISPATCH_INLINE size_t widen_half(const uint16_t* in, float* out, size_t count) {
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m256 f0 = _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i)));
+        __m256 f1 = _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i + 8)));
+        _mm256_storeu_ps(out + i, f0);
+        _mm256_storeu_ps(out + i + 8, f1);
+    }
+    for (; i + 8 <= count; i += 8) {
+        _mm256_storeu_ps(out + i, _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i))));
+    }
+    return i;
+}
+
+} // namespace glsl::details::avx2
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
+
+#endif // GLSL_DISPATCH
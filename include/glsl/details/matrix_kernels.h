@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cstddef>
+#include "dispatch.h"
+
+/**
+ * AVX2 inverse of a dmat4 (a column-major array of 16 doubles), 4 doubles per instruction, picked at run time
+ * through active_isa() like the transform kernels, so an SSE2 build (whose registers hold 2 doubles) runs it too.
+ * The products stay inline: dmat4 columns are whole registers of AVX builds, and a call costs SSE2 builds
+ * more than the wider registers save on a single product.
+ */
+
+#if GLSL_DISPATCH && !GLSL_DISPATCH_DEFINITIONS
+
+namespace glsl::details::avx2 {
+
+void inverse4(const double* m, double* out);
+
+} // namespace glsl::details::avx2
+
+#elif GLSL_DISPATCH
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx2,fma"))), apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target("avx2,fma")
+#endif
+
+namespace glsl::details::avx2 {
+
+namespace block {
+
+/**
+ * The 4x4 inverse and determinant by 2x2 blocks, M = | A B |, each block one register in column-major order
+ *                                                    | C D |
+ * (x0 x2 / x1 x3). X# is the adjugate of X, |X| its determinant.
+ */
+using type = __m256d;
+
+inline type low(type x) { return _mm256_permute2f128_pd(x, x, 0x00); }
+inline type high(type x) { return _mm256_permute2f128_pd(x, x, 0x11); }
+
+// X Y: each column of Y weighs the two columns of X.
+inline type mul(type x, type y) {
+    return _mm256_fmadd_pd(high(x), _mm256_permute_pd(y, 0xf), _mm256_mul_pd(low(x), _mm256_movedup_pd(y)));
+}
+
+// (x3, -x1, -x2, x0)
+inline type adjugate(type x) {
+    return _mm256_xor_pd(_mm256_permute4x64_pd(x, 0x27), _mm256_setr_pd(0.0, -0.0, -0.0, 0.0));
+}
+
+// All four lanes of lane I.
+template<int I>
+inline type splat(type x) { return _mm256_permute4x64_pd(x, I * 0x55); }
+
+// tr(X Y) in all lanes.
+inline type trace(type x, type y) {
+    type products = _mm256_mul_pd(x, _mm256_permute4x64_pd(y, 0xd8));
+    products = _mm256_hadd_pd(products, products);
+    return _mm256_add_pd(products, _mm256_permute2f128_pd(products, products, 0x01));
+}
+
+struct Blocks {
+    type a, b, c, d;
+    // |A| |B| |C| |D|
+    type determinants;
+    // A# B and D# C
+    type ab, dc;
+
+    explicit Blocks(const double* m) {
+        type c0 = _mm256_loadu_pd(m), c1 = _mm256_loadu_pd(m + 4);
+        type c2 = _mm256_loadu_pd(m + 8), c3 = _mm256_loadu_pd(m + 12);
+
+        a = _mm256_permute2f128_pd(c0, c1, 0x20);
+        c = _mm256_permute2f128_pd(c0, c1, 0x31);
+        b = _mm256_permute2f128_pd(c2, c3, 0x20);
+        d = _mm256_permute2f128_pd(c2, c3, 0x31);
+
+        determinants = _mm256_fmsub_pd(_mm256_unpacklo_pd(c0, c2), _mm256_unpackhi_pd(c1, c3),
+                                       _mm256_mul_pd(_mm256_unpacklo_pd(c1, c3), _mm256_unpackhi_pd(c0, c2)));
+
+        ab = mul(adjugate(a), b);
+        dc = mul(adjugate(d), c);
+    }
+
+    // |M| = |A| |D| + |B| |C| - tr(A# B D# C), in all lanes.
+    type determinant() const {
+        type ad = _mm256_mul_pd(splat<0>(determinants), splat<3>(determinants));
+        return _mm256_sub_pd(_mm256_fmadd_pd(splat<1>(determinants), splat<2>(determinants), ad), trace(ab, dc));
+    }
+};
+
+} // namespace block
+
+/**
+ * M^-1 = 1 / |M| | X# Y# |  with  X = |D| A - B D# C,    Y = |B| C - D (A# B)#,
+ *                | Z# W# |        Z = |C| B - A (D# C)#, W = |A| D - C A# B.
+ */
+GLSL_DISPATCH_INLINE void inverse4(const double* m, double* out) {
+    using namespace block;
+
+    Blocks blocks(m);
+    type x = _mm256_fmsub_pd(splat<3>(blocks.determinants), blocks.a, mul(blocks.b, blocks.dc));
+    type y = _mm256_fmsub_pd(splat<1>(blocks.determinants), blocks.c, mul(blocks.d, adjugate(blocks.ab)));
+    type z = _mm256_fmsub_pd(splat<2>(blocks.determinants), blocks.b, mul(blocks.a, adjugate(blocks.dc)));
+    type w = _mm256_fmsub_pd(splat<0>(blocks.determinants), blocks.d, mul(blocks.c, blocks.ab));
+
+    type det = blocks.determinant();
+    x = _mm256_div_pd(adjugate(x), det);
+    y = _mm256_div_pd(adjugate(y), det);
+    z = _mm256_div_pd(adjugate(z), det);
+    w = _mm256_div_pd(adjugate(w), det);
+
+    _mm256_storeu_pd(out, _mm256_permute2f128_pd(x, z, 0x20));
+    _mm256_storeu_pd(out + 4, _mm256_permute2f128_pd(x, z, 0x31));
+    _mm256_storeu_pd(out + 8, _mm256_permute2f128_pd(y, w, 0x20));
+    _mm256_storeu_pd(out + 12, _mm256_permute2f128_pd(y, w, 0x31));
+}
+
+} // namespace glsl::details::avx2
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
+
+#endif // GLSL_DISPATCH
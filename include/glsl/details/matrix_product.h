@@ -0,0 +1,257 @@
+#pragma once
+
+#include <array>
+#include <limits>
+#include <ostream>
+#include <tuple>
+#include "vector_expr.h"
+
+namespace glsl {
+
+template<class Scalar, size_t N, size_t M, template<class, size_t> class Trait>
+struct Matrix;
+
+/**
+ * Lazy chain of matrix products, built by Matrix * Matrix with GLSL_EXPR_TEMPLATES. The chain is multiplied in
+ * the association with the fewest scalar multiplications (matrix-chain order over the factor shapes, known at
+ * compile time) when it is converted to a Matrix. A column vector at the end (or a row vector at the front)
+ * closes the chain and evaluates it right away, so proj * view * model * v is three matrix-vector products.
+ *
+ * Like VectorExpr it holds its lvalue factors by reference and must not outlive them.
+ */
+template<class... Factors>
+struct MatrixProduct;
+
+namespace details::product {
+
+#if GLSL_EXPR_TEMPLATES
+constexpr bool lazy = true;
+#else
+constexpr bool lazy = false;
+#endif
+
+template<class T>
+struct is_matrix : std::false_type {};
+
+template<class Scalar, size_t N, size_t M, template<class, size_t> class Trait>
+struct is_matrix<Matrix<Scalar, N, M, Trait>> : std::true_type {};
+
+template<class T>
+struct is_product : std::false_type {};
+
+template<class... Factors>
+struct is_product<MatrixProduct<Factors...>> : std::true_type {};
+
+template<class T>
+concept Factor = is_matrix<std::remove_cvref_t<T>>::value || is_product<std::remove_cvref_t<T>>::value;
+
+template<class T>
+concept Vector = expr::is_vector<std::remove_cvref_t<T>>::value;
+
+// Operands of +, - and / with a chain, and of * (which extends the chain with matrices and vectors).
+template<class T>
+concept Term = !is_product<std::remove_cvref_t<T>>::value;
+
+template<class T>
+concept Scale = !Factor<T> && !Vector<T>;
+
+// First and last matrix of a factor.
+template<class T>
+struct ends {
+    using front = T;
+    using back = T;
+};
+
+template<class... Factors>
+struct ends<MatrixProduct<Factors...>> {
+    using front = std::remove_cvref_t<std::tuple_element_t<0, std::tuple<Factors...>>>;
+    using back = std::remove_cvref_t<std::tuple_element_t<sizeof...(Factors) - 1, std::tuple<Factors...>>>;
+};
+
+template<class T>
+using front_t = typename ends<std::remove_cvref_t<T>>::front;
+
+template<class T>
+using back_t = typename ends<std::remove_cvref_t<T>>::back;
+
+template<class L, class R>
+concept Chains = Factor<L> && Factor<R> &&
+                 std::same_as<typename back_t<L>::MatrixItem, typename front_t<R>::MatrixItem> &&
+                 back_t<L>::MatrixColumns == front_t<R>::MatrixRows;
+
+template<class T, size_t N, size_t M>
+struct resize;
+
+template<class Scalar, size_t N0, size_t M0, template<class, size_t> class Trait, size_t N, size_t M>
+struct resize<Matrix<Scalar, N0, M0, Trait>, N, M> {
+    using type = Matrix<Scalar, N, M, Trait>;
+};
+
+// Rows and columns of a factor, vectors are rows in front and columns elsewhere.
+template<class F, bool First>
+constexpr std::array<size_t, 2> shape() {
+    using T = std::remove_cvref_t<F>;
+    if constexpr (is_matrix<T>::value) {
+        return { T::MatrixRows, T::MatrixColumns };
+    } else if constexpr (First) {
+        return { 1, T::VectorSize };
+    } else {
+        return { T::VectorSize, 1 };
+    }
+}
+
+template<class... Factors, size_t... I>
+constexpr auto dims(std::index_sequence<I...>) {
+    using List = std::tuple<Factors...>;
+    return std::array<size_t, sizeof...(I) + 1>{
+        shape<std::tuple_element_t<0, List>, true>()[0], shape<std::tuple_element_t<I, List>, I == 0>()[1]...
+    };
+}
+
+/**
+ * split[i][j] is the last factor of the left operand in the cheapest association of factors i..j (the
+ * classic O(K^3) matrix-chain table). Ties keep the leftmost split, i.e. the right-to-left association.
+ */
+template<class... Factors>
+constexpr auto order() {
+    constexpr size_t K = sizeof...(Factors);
+    constexpr auto d = dims<Factors...>(std::make_index_sequence<K>());
+
+    std::array<std::array<size_t, K>, K> cost{}, split{};
+    for (size_t len = 1; len < K; ++len) {
+        for (size_t i = 0; i + len < K; ++i) {
+            size_t j = i + len;
+            cost[i][j] = std::numeric_limits<size_t>::max();
+            for (size_t s = i; s < j; ++s) {
+                size_t c = cost[i][s] + cost[s + 1][j] + d[i] * d[s + 1] * d[j + 1];
+                if (c < cost[i][j]) {
+                    cost[i][j] = c;
+                    split[i][j] = s;
+                }
+            }
+        }
+    }
+    return split;
+}
+
+// Factors of an operand as a tuple: lvalues by reference, temporaries by value, chains flattened.
+template<class T>
+constexpr auto factors(T&& v) {
+    if constexpr (is_product<std::remove_cvref_t<T>>::value) {
+        return std::forward<T>(v).factors;
+    } else {
+        return std::tuple<expr::stored_t<T&&>>(std::forward<T>(v));
+    }
+}
+
+template<class... Factors>
+constexpr auto make(std::tuple<Factors...>&& factors) {
+    return MatrixProduct<Factors...>{ std::move(factors) };
+}
+
+template<class A, class B>
+constexpr auto multiply(const A& a, const B& b) {
+    if constexpr (is_matrix<A>::value && is_matrix<B>::value) {
+        return A::product(a, b);
+    } else {
+        return a * b;
+    }
+}
+
+// Factors I..J of a chain multiplied in the cheapest order.
+template<size_t I, size_t J, class... Factors>
+constexpr decltype(auto) evaluate(const std::tuple<Factors...>& factors) {
+    if constexpr (I == J) {
+        return std::get<I>(factors);
+    } else {
+        constexpr size_t S = order<Factors...>()[I][J];
+        return multiply(evaluate<I, S>(factors), evaluate<S + 1, J>(factors));
+    }
+}
+
+template<class... Factors>
+constexpr auto evaluate(const std::tuple<Factors...>& factors) {
+    return evaluate<0, sizeof...(Factors) - 1>(factors);
+}
+
+} // namespace details::product
+
+template<class... Factors>
+struct MatrixProduct {
+
+    using Matrix = typename details::product::resize<details::product::front_t<MatrixProduct>,
+                                                     details::product::front_t<MatrixProduct>::MatrixRows,
+                                                     details::product::back_t<MatrixProduct>::MatrixColumns>::type;
+
+    std::tuple<Factors...> factors;
+
+    constexpr Matrix eval() const {
+        return details::product::evaluate(factors);
+    }
+
+    constexpr operator Matrix() const {
+        return eval();
+    }
+
+    template<class T>
+    constexpr bool operator==(const T& v) const {
+        return eval() == v;
+    }
+
+    template<class T>
+    constexpr bool operator!=(const T& v) const {
+        return eval() != v;
+    }
+
+    // Anything but another product in the chain evaluates it first.
+#define DEF_PRODUCT_OP(op, Operand)                                                                   \
+    template<class T> requires details::product::Operand<T>                                          \
+    friend constexpr auto operator op(const MatrixProduct& p, const T& v) {                           \
+        return p.eval() op v;                                                                         \
+    }                                                                                                 \
+                                                                                                      \
+    template<class T> requires details::product::Operand<T>                                          \
+    friend constexpr auto operator op(const T& v, const MatrixProduct& p) {                           \
+        return v op p.eval();                                                                         \
+    }                                                                                                 \
+                                                                                                      \
+    template<class... Others> requires details::product::Operand<Matrix>                             \
+    friend constexpr auto operator op(const MatrixProduct& p, const MatrixProduct<Others...>& q) {    \
+        return p.eval() op q.eval();                                                                  \
+    }
+
+    DEF_PRODUCT_OP(+, Term)
+    DEF_PRODUCT_OP(-, Term)
+    DEF_PRODUCT_OP(*, Scale)
+    DEF_PRODUCT_OP(/, Term)
+
+#undef DEF_PRODUCT_OP
+
+    friend std::ostream& operator<<(std::ostream& os, const MatrixProduct& obj) {
+        return os << obj.eval();
+    }
+};
+
+template<class L, class R> requires (details::product::lazy && details::product::Chains<L, R>)
+constexpr auto operator*(L&& l, R&& r) {
+    return details::product::make(std::tuple_cat(details::product::factors(std::forward<L>(l)),
+                                                 details::product::factors(std::forward<R>(r))));
+}
+
+template<class P, class V>
+requires (details::product::is_product<std::remove_cvref_t<P>>::value && details::product::Vector<V> &&
+          details::product::back_t<P>::MatrixColumns == std::remove_cvref_t<V>::VectorSize)
+constexpr auto operator*(P&& p, V&& v) {
+    return details::product::evaluate(std::tuple_cat(details::product::factors(std::forward<P>(p)),
+                                                     details::product::factors(std::forward<V>(v))));
+}
+
+template<class V, class P>
+requires (details::product::is_product<std::remove_cvref_t<P>>::value && details::product::Vector<V> &&
+          details::product::front_t<P>::MatrixRows == std::remove_cvref_t<V>::VectorSize)
+constexpr auto operator*(V&& v, P&& p) {
+    return details::product::evaluate(std::tuple_cat(details::product::factors(std::forward<V>(v)),
+                                                     details::product::factors(std::forward<P>(p))));
+}
+
+} // namespace glsl
@@ -0,0 +1,226 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+#include <utility>
+#include "utils.h"
+#include "simd.h"
+
+namespace glsl::details::simd {
+
+template<class Scalar>
+using int_for = std::conditional_t<sizeof(Scalar) == 4, int32_t, int64_t>;
+
+template<class Scalar, size_t Lanes>
+constexpr bool packet_supported = (std::is_floating_point_v<Scalar> && Register<Scalar, Lanes>::supported &&
+                                   IntRegister<int_for<Scalar>, Lanes>::supported) ||
+                                  (std::is_integral_v<Scalar> && IntRegister<Scalar, Lanes>::supported);
+
+template<class Scalar, size_t Lanes>
+struct Packet;
+
+/**
+ * Lane mask of a packet comparison, all bits of a lane are set when the lane compares true.
+ */
+template<class I, size_t Lanes>
+struct PacketMask {
+    using Register = IntRegister<I, Lanes>;
+
+    typename Register::type bits;
+
+    PacketMask operator!() const {
+        return { Register::bitxor_(bits, Register::set1(-1)) };
+    }
+
+    friend PacketMask operator&(const PacketMask& a, const PacketMask& b) {
+        return { Register::bitand_(a.bits, b.bits) };
+    }
+
+    friend PacketMask operator|(const PacketMask& a, const PacketMask& b) {
+        return { Register::bitor_(a.bits, b.bits) };
+    }
+
+    // One bit per lane, lane 0 in bit 0.
+    int movemask() const {
+        using Float = simd::Register<std::conditional_t<sizeof(I) == 4, float, double>, Lanes>;
+        return Float::movemask(Float::from_bits(bits));
+    }
+};
+
+/**
+ * A register-resident Batch: the scalar math kernels are written once against +, -, *, /, comparisons,
+ * select, convert and bitcast and run unchanged on scalars, Batch packets and Packet registers.
+ * Batch keeps its lanes in memory and one bool per mask lane, Packet keeps everything in registers.
+ */
+template<class Scalar, size_t Lanes>
+struct Packet {
+
+    static constexpr bool integral = std::is_integral_v<Scalar>;
+
+    using Register = std::conditional_t<integral, IntRegister<Scalar, Lanes>, simd::Register<Scalar, Lanes>>;
+    using Mask = PacketMask<std::conditional_t<integral, Scalar, int_for<Scalar>>, Lanes>;
+    using BatchItem = Scalar;
+
+    static constexpr size_t BatchWidth = Lanes;
+
+    typename Register::type v;
+
+public: // CONSTRUCTORS
+
+    Packet() = default;
+
+    template<class U> requires (std::is_arithmetic_v<U>)
+    Packet(U scalar) : v(Register::set1(static_cast<Scalar>(scalar))) {}
+
+    template<class U> requires (!std::same_as<U, Scalar> && sizeof(U) == sizeof(Scalar))
+    explicit Packet(const Packet<U, Lanes>& other) {
+        if constexpr (integral) {
+            v = Packet<U, Lanes>::Register::to_int(other.v);
+        } else {
+            v = Register::from_int(other.v);
+        }
+    }
+
+    static Packet load(const Scalar* p) {
+        Packet result;
+        result.v = Register::loadu(p);
+        return result;
+    }
+
+    void store(Scalar* p) const {
+        Register::storeu(p, v);
+    }
+
+    // 16-bit values, zero-extended into the lanes.
+    static Packet load(const uint16_t* p) requires std::same_as<Scalar, int32_t> {
+        Packet result;
+        result.v = Register::loadu16(p);
+        return result;
+    }
+
+    // The low 16 bits of the lanes.
+    void store(uint16_t* p) const requires std::same_as<Scalar, int32_t> {
+        Register::storeu16(p, v);
+    }
+
+    // Rows to columns of the square block of packets p[0..Lanes-1].
+    static void transpose(Packet* p) requires (!integral) {
+        // Packet is its register, the block can be transposed in place.
+        static_assert(sizeof(Packet) == sizeof(typename Register::type));
+        Register::transpose(&p[0].v);
+    }
+
+    Scalar operator[](size_t i) const {
+        Scalar lanes[Lanes];
+        store(lanes);
+        return lanes[i];
+    }
+
+public: // OPERATORS
+
+    Packet operator-() const {
+        return Packet(0) - *this;
+    }
+
+    friend Packet operator+(const Packet& a, const Packet& b) { return make(Register::add(a.v, b.v)); }
+
+    friend Packet operator-(const Packet& a, const Packet& b) { return make(Register::sub(a.v, b.v)); }
+
+    friend Packet operator*(const Packet& a, const Packet& b) requires (!integral) { return make(Register::mul(a.v, b.v)); }
+
+    friend Packet operator/(const Packet& a, const Packet& b) requires (!integral) { return make(Register::div(a.v, b.v)); }
+
+    friend Packet operator&(const Packet& a, const Packet& b) { return make(Register::bitand_(a.v, b.v)); }
+
+    friend Packet operator|(const Packet& a, const Packet& b) { return make(Register::bitor_(a.v, b.v)); }
+
+    friend Packet operator^(const Packet& a, const Packet& b) { return make(Register::bitxor_(a.v, b.v)); }
+
+    friend Packet operator<<(const Packet& a, int n) requires integral { return make(Register::sll(a.v, n)); }
+
+    // Logical shift, the kernels only shift non-negative lanes where it equals the scalar >>.
+    friend Packet operator>>(const Packet& a, int n) requires integral { return make(Register::srl(a.v, n)); }
+
+    friend Mask operator==(const Packet& a, const Packet& b) {
+        if constexpr (integral) {
+            return { Register::cmpeq(a.v, b.v) };
+        } else {
+            return { Register::to_bits(Register::cmpeq(a.v, b.v)) };
+        }
+    }
+
+    friend Mask operator!=(const Packet& a, const Packet& b) {
+        if constexpr (integral) {
+            return !(a == b);
+        } else {
+            return { Register::to_bits(Register::cmpneq(a.v, b.v)) };
+        }
+    }
+
+    friend Mask operator<(const Packet& a, const Packet& b) requires (!integral) { return mask(Register::cmplt(a.v, b.v)); }
+
+    friend Mask operator<=(const Packet& a, const Packet& b) requires (!integral) { return mask(Register::cmple(a.v, b.v)); }
+
+    friend Mask operator>(const Packet& a, const Packet& b) requires (!integral) { return mask(Register::cmpgt(a.v, b.v)); }
+
+    friend Mask operator>=(const Packet& a, const Packet& b) requires (!integral) { return mask(Register::cmpge(a.v, b.v)); }
+
+    friend Packet sqrt(const Packet& a) requires (!integral) { return make(Register::sqrt(a.v)); }
+
+    friend Packet select(const Mask& m, const Packet& a, const Packet& b) {
+        if constexpr (integral) {
+            return make(Register::bitxor_(b.v, Register::bitand_(Register::bitxor_(a.v, b.v), m.bits)));
+        } else {
+            return make(Register::select(Register::from_bits(m.bits), a.v, b.v));
+        }
+    }
+
+private:
+
+    static Packet make(typename Register::type r) {
+        Packet result;
+        result.v = r;
+        return result;
+    }
+
+    static Mask mask(typename Register::type r) {
+        return { Register::to_bits(r) };
+    }
+};
+
+/**
+ * Float lanes as two double packets (lower lanes first) and back.
+ */
+template<size_t Lanes>
+std::pair<Packet<double, Lanes / 2>, Packet<double, Lanes / 2>> widen(const Packet<float, Lanes>& v) {
+    Packet<double, Lanes / 2> lo, hi;
+    lo.v = Register<float, Lanes>::widen_lo(v.v);
+    hi.v = Register<float, Lanes>::widen_hi(v.v);
+    return { lo, hi };
+}
+
+template<size_t Lanes>
+Packet<float, 2 * Lanes> narrow(const Packet<double, Lanes>& lo, const Packet<double, Lanes>& hi) {
+    Packet<float, 2 * Lanes> result;
+    result.v = Register<float, 2 * Lanes>::narrow(lo.v, hi.v);
+    return result;
+}
+
+/**
+ * Float lanes as one double packet of the same width and back, where the double register exists.
+ */
+template<size_t Lanes> requires requires { Register<double, Lanes>::promote; }
+Packet<double, Lanes> promote(const Packet<float, Lanes>& v) {
+    Packet<double, Lanes> result;
+    result.v = Register<double, Lanes>::promote(v.v);
+    return result;
+}
+
+template<size_t Lanes> requires requires { Register<double, Lanes>::demote; }
+Packet<float, Lanes> demote(const Packet<double, Lanes>& v) {
+    Packet<float, Lanes> result;
+    result.v = Register<double, Lanes>::demote(v.v);
+    return result;
+}
+
+} // namespace glsl::details::simd
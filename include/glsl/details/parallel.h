@@ -0,0 +1,164 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdlib>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace glsl {
+
+/**
+ * Threads the bulk generators (noise grids and point sets, run_fragment) split their work across, detected
+ * once on first use from std::thread::hardware_concurrency. The GLSL_THREADS environment variable sets it,
+ * GLSL_THREADS=1 keeps everything on the calling thread.
+ */
+inline unsigned max_threads() {
+    static const unsigned threads = [] {
+        if (const char* env = std::getenv("GLSL_THREADS")) {
+            long requested = std::strtol(env, nullptr, 10);
+            if (requested > 0)
+                return unsigned(std::min(requested, 1024L));
+        }
+        return std::max(std::thread::hardware_concurrency(), 1u);
+    }();
+    return threads;
+}
+
+namespace details::parallel {
+
+/**
+ * max_threads() - 1 workers started on first use and kept until exit, the calling thread being the last one.
+ * run(count, task) hands out task(0) .. task(count - 1) one index at a time to whichever thread is free, so
+ * tasks of uneven cost balance themselves, and returns when all are done. A run issued while another one is
+ * in flight (from a task, or from a second thread) runs on its calling thread alone. Tasks run on workers
+ * must not throw; an exception of the calling thread's share is rethrown once the workers are done.
+ */
+class ThreadPool {
+public:
+    explicit ThreadPool(unsigned threads) {
+        for (unsigned t = 1; t < threads; ++t)
+            workers.emplace_back([this] { work(); });
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard lock(mutex);
+            stop = true;
+        }
+        wake.notify_all();
+        for (auto& worker : workers)
+            worker.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    static ThreadPool& shared() {
+        static ThreadPool pool(max_threads());
+        return pool;
+    }
+
+    size_t threads() const {
+        return workers.size() + 1;
+    }
+
+    template<class Task>
+    void run(size_t count, const Task& task) {
+        // A flag, not a mutex: a nested run from a task on this thread must not re-lock what it holds.
+        if (workers.empty() || count <= 1 || running.exchange(true, std::memory_order_acquire)) {
+            for (size_t i = 0; i < count; ++i)
+                task(i);
+            return;
+        }
+
+        {
+            std::lock_guard lock(mutex);
+            job = &task;
+            invoke = [](const void* f, size_t i) { (*static_cast<const Task*>(f))(i); };
+            next = 0;
+            total = count;
+            pending = workers.size();
+            ++generation;
+        }
+        wake.notify_all();
+
+        std::exception_ptr error;
+        try {
+            drain();
+        } catch (...) {
+            // Nothing is left for the workers, the job has to outlive them all the same.
+            next = count;
+            error = std::current_exception();
+        }
+
+        std::unique_lock lock(mutex);
+        done.wait(lock, [this] { return pending == 0; });
+        lock.unlock();
+        running.store(false, std::memory_order_release);
+        if (error)
+            std::rethrow_exception(error);
+    }
+
+private:
+    std::vector<std::thread> workers;
+    std::atomic<bool> running = false;
+    std::mutex mutex;
+    std::condition_variable wake, done;
+
+    const void* job = nullptr;
+    void (*invoke)(const void*, size_t) = nullptr;
+    std::atomic<size_t> next = 0;
+    size_t total = 0, pending = 0, generation = 0;
+    bool stop = false;
+
+    void drain() {
+        for (size_t i = next++; i < total; i = next++)
+            invoke(job, i);
+    }
+
+    void work() {
+        size_t seen = 0;
+        for (;;) {
+            {
+                std::unique_lock lock(mutex);
+                wake.wait(lock, [&] { return stop || generation != seen; });
+                if (stop)
+                    return;
+                seen = generation;
+            }
+            drain();
+            {
+                std::lock_guard lock(mutex);
+                if (--pending == 0)
+                    done.notify_one();
+            }
+        }
+    }
+};
+
+/**
+ * chunk(begin, end) over [0, count) split into contiguous ranges of at least grain items, one per thread of
+ * the shared pool. Counts below two grains, and a single thread, run inline.
+ */
+template<class Chunk>
+void for_each_chunk(size_t count, size_t grain, const Chunk& chunk) {
+    size_t chunks = std::min<size_t>(max_threads(), count / std::max<size_t>(grain, 1));
+    if (chunks <= 1) {
+        if (count > 0)
+            chunk(size_t(0), count);
+        return;
+    }
+
+    ThreadPool::shared().run(chunks, [&](size_t t) {
+        chunk(count * t / chunks, count * (t + 1) / chunks);
+    });
+}
+
+} // namespace details::parallel
+
+} // namespace glsl
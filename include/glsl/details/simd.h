@@ -0,0 +1,549 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <stdexcept>
+#include "config.h"
+
+#if GLSL_SIMD && (defined(__SSE2__) || defined(_M_X64))
+#include <immintrin.h>
+#define GLSL_SIMD_SSE2 1
+#if defined(__AVX2__)
+#define GLSL_SIMD_AVX2 1
+#endif
+#endif
+
+namespace glsl::details::simd {
+
+template<class Scalar, size_t Lanes>
+struct Register {
+    static constexpr bool supported = false;
+    static constexpr size_t lanes = 0;
+};
+
+template<class Scalar, size_t Lanes>
+struct IntRegister {
+    static constexpr bool supported = false;
+    static constexpr size_t lanes = 0;
+};
+
+#if GLSL_SIMD_SSE2
+
+template<>
+struct Register<float, 4> {
+    using type = __m128;
+
+    static constexpr bool supported = true;
+    static constexpr size_t lanes = 4;
+    static constexpr size_t alignment = 16;
+
+    static type load(const float* p) { return _mm_load_ps(p); }
+    static type loadu(const float* p) { return _mm_loadu_ps(p); }
+    static void store(float* p, type v) { _mm_store_ps(p, v); }
+    static void storeu(float* p, type v) { _mm_storeu_ps(p, v); }
+    static void stream(float* p, type v) { _mm_stream_ps(p, v); }
+    static void fence() { _mm_sfence(); }
+    static type set1(float v) { return _mm_set1_ps(v); }
+    static type zero() { return _mm_setzero_ps(); }
+
+    static type add(type a, type b) { return _mm_add_ps(a, b); }
+    static type sub(type a, type b) { return _mm_sub_ps(a, b); }
+    static type mul(type a, type b) { return _mm_mul_ps(a, b); }
+    static type div(type a, type b) { return _mm_div_ps(a, b); }
+    static type min(type a, type b) { return _mm_min_ps(a, b); }
+    static type max(type a, type b) { return _mm_max_ps(a, b); }
+    static type sqrt(type a) { return _mm_sqrt_ps(a); }
+
+    static type fmadd(type a, type b, type c) {
+#if defined(__FMA__)
+        return _mm_fmadd_ps(a, b, c);
+#else
+        return _mm_add_ps(_mm_mul_ps(a, b), c);
+#endif
+    }
+
+    static type cmpeq(type a, type b) { return _mm_cmpeq_ps(a, b); }
+    static type cmpneq(type a, type b) { return _mm_cmpneq_ps(a, b); }
+    static type cmplt(type a, type b) { return _mm_cmplt_ps(a, b); }
+    static type cmple(type a, type b) { return _mm_cmple_ps(a, b); }
+    static type cmpgt(type a, type b) { return _mm_cmpgt_ps(a, b); }
+    static type cmpge(type a, type b) { return _mm_cmpge_ps(a, b); }
+
+    static type bitand_(type a, type b) { return _mm_and_ps(a, b); }
+    static type bitor_(type a, type b) { return _mm_or_ps(a, b); }
+    static type bitxor_(type a, type b) { return _mm_xor_ps(a, b); }
+
+    using itype = __m128i;
+    static itype to_bits(type v) { return _mm_castps_si128(v); }
+    static type from_bits(itype v) { return _mm_castsi128_ps(v); }
+    static itype to_int(type v) { return _mm_cvttps_epi32(v); }
+    static type from_int(itype v) { return _mm_cvtepi32_ps(v); }
+    static __m128d widen_lo(type v) { return _mm_cvtps_pd(v); }
+    static __m128d widen_hi(type v) { return _mm_cvtps_pd(_mm_movehl_ps(v, v)); }
+    static type narrow(__m128d lo, __m128d hi) { return _mm_movelh_ps(_mm_cvtpd_ps(lo), _mm_cvtpd_ps(hi)); }
+    static type select(type mask, type a, type b) {
+        return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+    }
+    static int movemask(type v) { return _mm_movemask_ps(v); }
+    static float lane0(type v) { return _mm_cvtss_f32(v); }
+
+    static type first(size_t n) {
+        return _mm_castsi128_ps(_mm_cmpgt_epi32(_mm_set1_epi32(int(n)), _mm_setr_epi32(0, 1, 2, 3)));
+    }
+
+    static type hsum(type v) {
+        type t = _mm_add_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+        return _mm_add_ps(t, _mm_shuffle_ps(t, t, _MM_SHUFFLE(1, 0, 3, 2)));
+    }
+
+    // Rows to columns of the 4x4 block r[0..3].
+    static void transpose(type* r) {
+        _MM_TRANSPOSE4_PS(r[0], r[1], r[2], r[3]);
+    }
+
+    // Product of two column-major 2x2 matrices held in one register each.
+    static type mul2x2(type a, type b) {
+        type lo = _mm_movelh_ps(a, a);
+        type hi = _mm_movehl_ps(a, a);
+        return fmadd(hi, _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 3, 1, 1)),
+                     _mm_mul_ps(lo, _mm_shuffle_ps(b, b, _MM_SHUFFLE(2, 2, 0, 0))));
+    }
+};
+
+template<>
+struct Register<double, 2> {
+    using type = __m128d;
+
+    static constexpr bool supported = true;
+    static constexpr size_t lanes = 2;
+    static constexpr size_t alignment = 16;
+
+    static type load(const double* p) { return _mm_load_pd(p); }
+    static type loadu(const double* p) { return _mm_loadu_pd(p); }
+    static void store(double* p, type v) { _mm_store_pd(p, v); }
+    static void storeu(double* p, type v) { _mm_storeu_pd(p, v); }
+    static void stream(double* p, type v) { _mm_stream_pd(p, v); }
+    static void fence() { _mm_sfence(); }
+    static type set1(double v) { return _mm_set1_pd(v); }
+    static type zero() { return _mm_setzero_pd(); }
+
+    static type add(type a, type b) { return _mm_add_pd(a, b); }
+    static type sub(type a, type b) { return _mm_sub_pd(a, b); }
+    static type mul(type a, type b) { return _mm_mul_pd(a, b); }
+    static type div(type a, type b) { return _mm_div_pd(a, b); }
+    static type min(type a, type b) { return _mm_min_pd(a, b); }
+    static type max(type a, type b) { return _mm_max_pd(a, b); }
+    static type sqrt(type a) { return _mm_sqrt_pd(a); }
+
+    static type fmadd(type a, type b, type c) {
+#if defined(__FMA__)
+        return _mm_fmadd_pd(a, b, c);
+#else
+        return _mm_add_pd(_mm_mul_pd(a, b), c);
+#endif
+    }
+
+    static type cmpeq(type a, type b) { return _mm_cmpeq_pd(a, b); }
+    static type cmpneq(type a, type b) { return _mm_cmpneq_pd(a, b); }
+    static type cmplt(type a, type b) { return _mm_cmplt_pd(a, b); }
+    static type cmple(type a, type b) { return _mm_cmple_pd(a, b); }
+    static type cmpgt(type a, type b) { return _mm_cmpgt_pd(a, b); }
+    static type cmpge(type a, type b) { return _mm_cmpge_pd(a, b); }
+
+    static type bitand_(type a, type b) { return _mm_and_pd(a, b); }
+    static type bitor_(type a, type b) { return _mm_or_pd(a, b); }
+    static type bitxor_(type a, type b) { return _mm_xor_pd(a, b); }
+
+    // Integer conversions are limited to |v| < 2^31 (to_int) and |v| < 2^51 (from_int).
+    using itype = __m128i;
+    static itype to_bits(type v) { return _mm_castpd_si128(v); }
+    static type from_bits(itype v) { return _mm_castsi128_pd(v); }
+    static itype to_int(type v) {
+        itype i = _mm_cvttpd_epi32(v);
+        return _mm_unpacklo_epi32(i, _mm_srai_epi32(i, 31));
+    }
+    static type from_int(itype v) {
+        const type magic = _mm_set1_pd(0x1.8p52);
+        return _mm_sub_pd(_mm_castsi128_pd(_mm_add_epi64(v, _mm_castpd_si128(magic))), magic);
+    }
+    static type select(type mask, type a, type b) {
+        return _mm_or_pd(_mm_and_pd(mask, a), _mm_andnot_pd(mask, b));
+    }
+    static int movemask(type v) { return _mm_movemask_pd(v); }
+    static double lane0(type v) { return _mm_cvtsd_f64(v); }
+
+    static type first(size_t n) {
+        return n >= 2 ? _mm_castsi128_pd(_mm_set1_epi32(-1))
+                      : _mm_castsi128_pd(_mm_setr_epi32(n ? -1 : 0, n ? -1 : 0, 0, 0));
+    }
+
+    static type hsum(type v) {
+        return _mm_add_pd(v, _mm_shuffle_pd(v, v, 1));
+    }
+
+    static void transpose(type* r) {
+        type t = _mm_unpacklo_pd(r[0], r[1]);
+        r[1] = _mm_unpackhi_pd(r[0], r[1]);
+        r[0] = t;
+    }
+};
+
+/**
+ * Integer lanes of the same register width, used for the bit-level parts of the math kernels.
+ * Only the operations those kernels need are provided, >> is a logical shift.
+ */
+template<>
+struct IntRegister<int32_t, 4> {
+    using type = __m128i;
+
+    static constexpr bool supported = true;
+    static constexpr size_t lanes = 4;
+
+    static type loadu(const int32_t* p) { return _mm_loadu_si128(reinterpret_cast<const type*>(p)); }
+    static void storeu(int32_t* p, type v) { _mm_storeu_si128(reinterpret_cast<type*>(p), v); }
+    // 16-bit lanes in memory, zero-extended on load and truncated on store.
+    static type loadu16(const uint16_t* p) {
+        return _mm_unpacklo_epi16(_mm_loadl_epi64(reinterpret_cast<const type*>(p)), _mm_setzero_si128());
+    }
+    static void storeu16(uint16_t* p, type v) {
+        // Sign-extended from bit 15, the saturating pack keeps the low halves.
+        v = _mm_srai_epi32(_mm_slli_epi32(v, 16), 16);
+        _mm_storel_epi64(reinterpret_cast<type*>(p), _mm_packs_epi32(v, v));
+    }
+    static type set1(int32_t v) { return _mm_set1_epi32(v); }
+    static type add(type a, type b) { return _mm_add_epi32(a, b); }
+    static type sub(type a, type b) { return _mm_sub_epi32(a, b); }
+    static type bitand_(type a, type b) { return _mm_and_si128(a, b); }
+    static type bitor_(type a, type b) { return _mm_or_si128(a, b); }
+    static type bitxor_(type a, type b) { return _mm_xor_si128(a, b); }
+    static type sll(type a, int n) { return _mm_sll_epi32(a, _mm_cvtsi32_si128(n)); }
+    static type srl(type a, int n) { return _mm_srl_epi32(a, _mm_cvtsi32_si128(n)); }
+    static type cmpeq(type a, type b) { return _mm_cmpeq_epi32(a, b); }
+};
+
+template<>
+struct IntRegister<int64_t, 2> {
+    using type = __m128i;
+
+    static constexpr bool supported = true;
+    static constexpr size_t lanes = 2;
+
+    static type loadu(const int64_t* p) { return _mm_loadu_si128(reinterpret_cast<const type*>(p)); }
+    static void storeu(int64_t* p, type v) { _mm_storeu_si128(reinterpret_cast<type*>(p), v); }
+    static type set1(int64_t v) { return _mm_set1_epi64x(v); }
+    static type add(type a, type b) { return _mm_add_epi64(a, b); }
+    static type sub(type a, type b) { return _mm_sub_epi64(a, b); }
+    static type bitand_(type a, type b) { return _mm_and_si128(a, b); }
+    static type bitor_(type a, type b) { return _mm_or_si128(a, b); }
+    static type bitxor_(type a, type b) { return _mm_xor_si128(a, b); }
+    static type sll(type a, int n) { return _mm_sll_epi64(a, _mm_cvtsi32_si128(n)); }
+    static type srl(type a, int n) { return _mm_srl_epi64(a, _mm_cvtsi32_si128(n)); }
+    static type cmpeq(type a, type b) {
+        type t = _mm_cmpeq_epi32(a, b);
+        return _mm_and_si128(t, _mm_shuffle_epi32(t, _MM_SHUFFLE(2, 3, 0, 1)));
+    }
+};
+
+#endif // GLSL_SIMD_SSE2
+
+#if GLSL_SIMD_AVX2
+
+template<>
+struct Register<float, 8> {
+    using type = __m256;
+
+    static constexpr bool supported = true;
+    static constexpr size_t lanes = 8;
+    static constexpr size_t alignment = 32;
+
+    static type load(const float* p) { return _mm256_load_ps(p); }
+    static type loadu(const float* p) { return _mm256_loadu_ps(p); }
+    static void store(float* p, type v) { _mm256_store_ps(p, v); }
+    static void storeu(float* p, type v) { _mm256_storeu_ps(p, v); }
+    static void stream(float* p, type v) { _mm256_stream_ps(p, v); }
+    static void fence() { _mm_sfence(); }
+    static type set1(float v) { return _mm256_set1_ps(v); }
+    static type zero() { return _mm256_setzero_ps(); }
+
+    static type add(type a, type b) { return _mm256_add_ps(a, b); }
+    static type sub(type a, type b) { return _mm256_sub_ps(a, b); }
+    static type mul(type a, type b) { return _mm256_mul_ps(a, b); }
+    static type div(type a, type b) { return _mm256_div_ps(a, b); }
+    static type min(type a, type b) { return _mm256_min_ps(a, b); }
+    static type max(type a, type b) { return _mm256_max_ps(a, b); }
+    static type sqrt(type a) { return _mm256_sqrt_ps(a); }
+
+    static type fmadd(type a, type b, type c) {
+#if defined(__FMA__)
+        return _mm256_fmadd_ps(a, b, c);
+#else
+        return _mm256_add_ps(_mm256_mul_ps(a, b), c);
+#endif
+    }
+
+    static type cmpeq(type a, type b) { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+    static type cmpneq(type a, type b) { return _mm256_cmp_ps(a, b, _CMP_NEQ_UQ); }
+    static type cmplt(type a, type b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+    static type cmple(type a, type b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+    static type cmpgt(type a, type b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+    static type cmpge(type a, type b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+
+    static type bitand_(type a, type b) { return _mm256_and_ps(a, b); }
+    static type bitor_(type a, type b) { return _mm256_or_ps(a, b); }
+    static type bitxor_(type a, type b) { return _mm256_xor_ps(a, b); }
+
+    using itype = __m256i;
+    static itype to_bits(type v) { return _mm256_castps_si256(v); }
+    static type from_bits(itype v) { return _mm256_castsi256_ps(v); }
+    static itype to_int(type v) { return _mm256_cvttps_epi32(v); }
+    static type from_int(itype v) { return _mm256_cvtepi32_ps(v); }
+    static __m256d widen_lo(type v) { return _mm256_cvtps_pd(_mm256_castps256_ps128(v)); }
+    static __m256d widen_hi(type v) { return _mm256_cvtps_pd(_mm256_extractf128_ps(v, 1)); }
+    static type narrow(__m256d lo, __m256d hi) {
+        return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm256_cvtpd_ps(lo)), _mm256_cvtpd_ps(hi), 1);
+    }
+    static type select(type mask, type a, type b) { return _mm256_blendv_ps(b, a, mask); }
+    static int movemask(type v) { return _mm256_movemask_ps(v); }
+    static float lane0(type v) { return _mm256_cvtss_f32(v); }
+
+    static type first(size_t n) {
+        return _mm256_castsi256_ps(_mm256_cmpgt_epi32(_mm256_set1_epi32(int(n)),
+                                                      _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)));
+    }
+
+    static type hsum(type v) {
+        type t = _mm256_add_ps(v, _mm256_permute_ps(v, _MM_SHUFFLE(2, 3, 0, 1)));
+        t = _mm256_add_ps(t, _mm256_permute_ps(t, _MM_SHUFFLE(1, 0, 3, 2)));
+        return _mm256_add_ps(t, _mm256_permute2f128_ps(t, t, 1));
+    }
+
+    // Rows to columns of the 8x8 block r[0..7]: 2x2 blocks within the lanes, 4x4 within the halves, then the halves.
+    static void transpose(type* r) {
+        type t0 = _mm256_unpacklo_ps(r[0], r[1]), t1 = _mm256_unpackhi_ps(r[0], r[1]);
+        type t2 = _mm256_unpacklo_ps(r[2], r[3]), t3 = _mm256_unpackhi_ps(r[2], r[3]);
+        type t4 = _mm256_unpacklo_ps(r[4], r[5]), t5 = _mm256_unpackhi_ps(r[4], r[5]);
+        type t6 = _mm256_unpacklo_ps(r[6], r[7]), t7 = _mm256_unpackhi_ps(r[6], r[7]);
+        type u0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0)), u1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+        type u2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0)), u3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+        type u4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0)), u5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+        type u6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0)), u7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+        r[0] = _mm256_permute2f128_ps(u0, u4, 0x20);
+        r[1] = _mm256_permute2f128_ps(u1, u5, 0x20);
+        r[2] = _mm256_permute2f128_ps(u2, u6, 0x20);
+        r[3] = _mm256_permute2f128_ps(u3, u7, 0x20);
+        r[4] = _mm256_permute2f128_ps(u0, u4, 0x31);
+        r[5] = _mm256_permute2f128_ps(u1, u5, 0x31);
+        r[6] = _mm256_permute2f128_ps(u2, u6, 0x31);
+        r[7] = _mm256_permute2f128_ps(u3, u7, 0x31);
+    }
+};
+
+template<>
+struct Register<double, 4> {
+    using type = __m256d;
+
+    static constexpr bool supported = true;
+    static constexpr size_t lanes = 4;
+    static constexpr size_t alignment = 32;
+
+    static type load(const double* p) { return _mm256_load_pd(p); }
+    static type loadu(const double* p) { return _mm256_loadu_pd(p); }
+    static void store(double* p, type v) { _mm256_store_pd(p, v); }
+    static void storeu(double* p, type v) { _mm256_storeu_pd(p, v); }
+    static void stream(double* p, type v) { _mm256_stream_pd(p, v); }
+    static void fence() { _mm_sfence(); }
+    static type set1(double v) { return _mm256_set1_pd(v); }
+    static type zero() { return _mm256_setzero_pd(); }
+    static type promote(__m128 v) { return _mm256_cvtps_pd(v); }
+    static __m128 demote(type v) { return _mm256_cvtpd_ps(v); }
+
+    static type add(type a, type b) { return _mm256_add_pd(a, b); }
+    static type sub(type a, type b) { return _mm256_sub_pd(a, b); }
+    static type mul(type a, type b) { return _mm256_mul_pd(a, b); }
+    static type div(type a, type b) { return _mm256_div_pd(a, b); }
+    static type min(type a, type b) { return _mm256_min_pd(a, b); }
+    static type max(type a, type b) { return _mm256_max_pd(a, b); }
+    static type sqrt(type a) { return _mm256_sqrt_pd(a); }
+
+    static type fmadd(type a, type b, type c) {
+#if defined(__FMA__)
+        return _mm256_fmadd_pd(a, b, c);
+#else
+        return _mm256_add_pd(_mm256_mul_pd(a, b), c);
+#endif
+    }
+
+    static type cmpeq(type a, type b) { return _mm256_cmp_pd(a, b, _CMP_EQ_OQ); }
+    static type cmpneq(type a, type b) { return _mm256_cmp_pd(a, b, _CMP_NEQ_UQ); }
+    static type cmplt(type a, type b) { return _mm256_cmp_pd(a, b, _CMP_LT_OQ); }
+    static type cmple(type a, type b) { return _mm256_cmp_pd(a, b, _CMP_LE_OQ); }
+    static type cmpgt(type a, type b) { return _mm256_cmp_pd(a, b, _CMP_GT_OQ); }
+    static type cmpge(type a, type b) { return _mm256_cmp_pd(a, b, _CMP_GE_OQ); }
+
+    static type bitand_(type a, type b) { return _mm256_and_pd(a, b); }
+    static type bitor_(type a, type b) { return _mm256_or_pd(a, b); }
+    static type bitxor_(type a, type b) { return _mm256_xor_pd(a, b); }
+
+    // Integer conversions are limited to |v| < 2^31 (to_int) and |v| < 2^51 (from_int).
+    using itype = __m256i;
+    static itype to_bits(type v) { return _mm256_castpd_si256(v); }
+    static type from_bits(itype v) { return _mm256_castsi256_pd(v); }
+    static itype to_int(type v) { return _mm256_cvtepi32_epi64(_mm256_cvttpd_epi32(v)); }
+    static type from_int(itype v) {
+        const type magic = _mm256_set1_pd(0x1.8p52);
+        return _mm256_sub_pd(_mm256_castsi256_pd(_mm256_add_epi64(v, _mm256_castpd_si256(magic))), magic);
+    }
+    static type select(type mask, type a, type b) { return _mm256_blendv_pd(b, a, mask); }
+    static int movemask(type v) { return _mm256_movemask_pd(v); }
+    static double lane0(type v) { return _mm256_cvtsd_f64(v); }
+
+    static type first(size_t n) {
+        return _mm256_castsi256_pd(_mm256_cmpgt_epi64(_mm256_set1_epi64x(int64_t(n)),
+                                                      _mm256_setr_epi64x(0, 1, 2, 3)));
+    }
+
+    static type hsum(type v) {
+        type t = _mm256_add_pd(v, _mm256_permute_pd(v, 0b0101));
+        return _mm256_add_pd(t, _mm256_permute2f128_pd(t, t, 1));
+    }
+
+    static void transpose(type* r) {
+        type t0 = _mm256_unpacklo_pd(r[0], r[1]), t1 = _mm256_unpackhi_pd(r[0], r[1]);
+        type t2 = _mm256_unpacklo_pd(r[2], r[3]), t3 = _mm256_unpackhi_pd(r[2], r[3]);
+        r[0] = _mm256_permute2f128_pd(t0, t2, 0x20);
+        r[1] = _mm256_permute2f128_pd(t1, t3, 0x20);
+        r[2] = _mm256_permute2f128_pd(t0, t2, 0x31);
+        r[3] = _mm256_permute2f128_pd(t1, t3, 0x31);
+    }
+};
+
+template<>
+struct IntRegister<int32_t, 8> {
+    using type = __m256i;
+
+    static constexpr bool supported = true;
+    static constexpr size_t lanes = 8;
+
+    static type loadu(const int32_t* p) { return _mm256_loadu_si256(reinterpret_cast<const type*>(p)); }
+    static void storeu(int32_t* p, type v) { _mm256_storeu_si256(reinterpret_cast<type*>(p), v); }
+    static type loadu16(const uint16_t* p) { return _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))); }
+    static void storeu16(uint16_t* p, type v) {
+        v = _mm256_srai_epi32(_mm256_slli_epi32(v, 16), 16);
+        v = _mm256_permute4x64_epi64(_mm256_packs_epi32(v, v), _MM_SHUFFLE(3, 1, 2, 0));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(p), _mm256_castsi256_si128(v));
+    }
+    static type set1(int32_t v) { return _mm256_set1_epi32(v); }
+    static type add(type a, type b) { return _mm256_add_epi32(a, b); }
+    static type sub(type a, type b) { return _mm256_sub_epi32(a, b); }
+    static type bitand_(type a, type b) { return _mm256_and_si256(a, b); }
+    static type bitor_(type a, type b) { return _mm256_or_si256(a, b); }
+    static type bitxor_(type a, type b) { return _mm256_xor_si256(a, b); }
+    static type sll(type a, int n) { return _mm256_sll_epi32(a, _mm_cvtsi32_si128(n)); }
+    static type srl(type a, int n) { return _mm256_srl_epi32(a, _mm_cvtsi32_si128(n)); }
+    static type cmpeq(type a, type b) { return _mm256_cmpeq_epi32(a, b); }
+};
+
+template<>
+struct IntRegister<int64_t, 4> {
+    using type = __m256i;
+
+    static constexpr bool supported = true;
+    static constexpr size_t lanes = 4;
+
+    static type loadu(const int64_t* p) { return _mm256_loadu_si256(reinterpret_cast<const type*>(p)); }
+    static void storeu(int64_t* p, type v) { _mm256_storeu_si256(reinterpret_cast<type*>(p), v); }
+    static type set1(int64_t v) { return _mm256_set1_epi64x(v); }
+    static type add(type a, type b) { return _mm256_add_epi64(a, b); }
+    static type sub(type a, type b) { return _mm256_sub_epi64(a, b); }
+    static type bitand_(type a, type b) { return _mm256_and_si256(a, b); }
+    static type bitor_(type a, type b) { return _mm256_or_si256(a, b); }
+    static type bitxor_(type a, type b) { return _mm256_xor_si256(a, b); }
+    static type sll(type a, int n) { return _mm256_sll_epi64(a, _mm_cvtsi32_si128(n)); }
+    static type srl(type a, int n) { return _mm256_srl_epi64(a, _mm_cvtsi32_si128(n)); }
+    static type cmpeq(type a, type b) { return _mm256_cmpeq_epi64(a, b); }
+};
+
+#endif // GLSL_SIMD_AVX2
+
+template<class Scalar, size_t Size>
+constexpr size_t register_lanes() {
+    if constexpr (Size <= 2 && 2 * sizeof(Scalar) >= 16) {
+        return Register<Scalar, 2>::supported ? 2 : 0;
+    } else if constexpr (Size <= 4 && 4 * sizeof(Scalar) >= 16) {
+        return Register<Scalar, 4>::supported ? 4 : 0;
+    } else if constexpr (Size <= 8 && 8 * sizeof(Scalar) >= 16) {
+        return Register<Scalar, 8>::supported ? 8 : 0;
+    } else {
+        return 0;
+    }
+}
+
+template<class Scalar, size_t Size>
+using RegisterFor = Register<Scalar, register_lanes<Scalar, Size>()>;
+
+template<class Op>
+constexpr bool packed_op = std::same_as<Op, std::plus<>> || std::same_as<Op, std::minus<>> ||
+                           std::same_as<Op, std::multiplies<>> || std::same_as<Op, std::divides<>>;
+
+template<class Op, class Reg>
+typename Reg::type apply(typename Reg::type a, typename Reg::type b) {
+    if constexpr (std::same_as<Op, std::plus<>>) {
+        return Reg::add(a, b);
+    } else if constexpr (std::same_as<Op, std::minus<>>) {
+        return Reg::sub(a, b);
+    } else if constexpr (std::same_as<Op, std::multiplies<>>) {
+        return Reg::mul(a, b);
+    } else {
+        static_assert(std::same_as<Op, std::divides<>>);
+        return Reg::div(a, b);
+    }
+}
+
+/**
+ * Vector storage padded to a whole register and aligned for packed loads.
+ * Lanes past Size are not part of the vector and may hold any value.
+ */
+template<class Scalar, size_t Size, class Reg = RegisterFor<Scalar, Size>>
+struct alignas(Reg::alignment) Storage {
+    Scalar lanes[Reg::lanes];
+
+    constexpr Scalar& operator[](size_t i) { return lanes[i]; }
+
+    constexpr const Scalar& operator[](size_t i) const { return lanes[i]; }
+
+    Scalar& at(size_t i) { return i < Size ? lanes[i] : throw std::out_of_range("glsl::simd::Storage"); }
+
+    const Scalar& at(size_t i) const { return const_cast<Storage&>(*this).at(i); }
+
+    typename Reg::type load() const { return Reg::load(lanes); }
+
+    void store(typename Reg::type v) { Reg::store(lanes, v); }
+
+    constexpr Scalar* begin() { return lanes; }
+
+    constexpr Scalar* end() { return lanes + Size; }
+
+    constexpr const Scalar* begin() const { return lanes; }
+
+    constexpr const Scalar* end() const { return lanes + Size; }
+
+    constexpr const Scalar* cbegin() const { return begin(); }
+
+    constexpr const Scalar* cend() const { return end(); }
+
+    constexpr auto rbegin() { return std::reverse_iterator(end()); }
+
+    constexpr auto rend() { return std::reverse_iterator(begin()); }
+
+    constexpr auto rbegin() const { return std::reverse_iterator(end()); }
+
+    constexpr auto rend() const { return std::reverse_iterator(begin()); }
+
+    constexpr auto crbegin() const { return rbegin(); }
+
+    constexpr auto crend() const { return rend(); }
+};
+
+} // namespace glsl::details::simd
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include "utils.h"
+#include "packet.h"
+
+namespace glsl::details::soa {
+
+// Elements per packet of the span kernels, the widest register of the build.
+template<class T>
+constexpr size_t lanes = simd::packet_supported<T, 8> ? 8 :
+                         simd::packet_supported<T, 4> ? 4 :
+                         simd::packet_supported<T, 2> ? 2 : 1;
+
+/**
+ * Size scalars per element, Stride apart, starting at p: the components of a span of quaternions, vectors
+ * or matrices. gather reads the components of as many consecutive elements as a packet has lanes, one
+ * packet per component (AoS to SoA), scatter writes them back. Scalars stand for packets of one lane.
+ */
+template<class T, size_t Size, size_t Stride>
+struct Stream {
+    T* p;
+
+    template<class P>
+    static constexpr size_t width = std::is_arithmetic_v<P> ? 1 : P::BatchWidth;
+
+    // Components moved through register transposes, as many as a packet has lanes at a time.
+    template<class P>
+    static constexpr size_t transposed = std::is_arithmetic_v<P> || P::integral ? 0 : Size / width<P> * width<P>;
+
+    template<class P>
+    std::array<P, Size> gather(size_t i) const {
+        std::array<P, Size> result;
+        if constexpr (std::is_arithmetic_v<P>) {
+            static_foreach<0, Size>([&](size_t k) {
+                result[k] = p[i * Stride + k];
+            });
+        } else if constexpr (Stride == 1) {
+            // Contiguous scalars are a packet already.
+            result[0] = P::load(p + i);
+        } else {
+            constexpr size_t W = width<P>;
+            if constexpr (transposed<P> > 0) {
+                static_foreach<0, transposed<P> / W>([&](size_t g) {
+                    P rows[W];
+                    static_foreach<0, W>([&](size_t j) {
+                        rows[j] = P::load(p + (i + j) * Stride + g * W);
+                    });
+                    P::transpose(rows);
+                    static_foreach<0, W>([&](size_t k) {
+                        result[g * W + k] = rows[k];
+                    });
+                });
+            }
+            // The rest lane by lane, all of them before the first packet load: a load right behind the narrow
+            // stores of its lanes would stall on store forwarding.
+            constexpr size_t Rest = Size - transposed<P>;
+            if constexpr (Rest > 0) {
+                std::remove_const_t<T> lanes[Rest][W];
+                static_foreach<0, W>([&](size_t j) {
+                    static_foreach<0, Rest>([&](size_t k) {
+                        lanes[k][j] = p[(i + j) * Stride + transposed<P> + k];
+                    });
+                });
+                static_foreach<0, Rest>([&](size_t k) {
+                    result[transposed<P> + k] = P::load(lanes[k]);
+                });
+            }
+        }
+        return result;
+    }
+
+    template<class P>
+    void scatter(size_t i, const std::array<P, Size>& values) const {
+        if constexpr (std::is_arithmetic_v<P>) {
+            static_foreach<0, Size>([&](size_t k) {
+                p[i * Stride + k] = values[k];
+            });
+        } else if constexpr (Stride == 1) {
+            values[0].store(p + i);
+        } else {
+            constexpr size_t W = width<P>;
+            if constexpr (transposed<P> > 0) {
+                static_foreach<0, transposed<P> / W>([&](size_t g) {
+                    P rows[W];
+                    static_foreach<0, W>([&](size_t k) {
+                        rows[k] = values[g * W + k];
+                    });
+                    P::transpose(rows);
+                    static_foreach<0, W>([&](size_t j) {
+                        rows[j].store(p + (i + j) * Stride + g * W);
+                    });
+                });
+            }
+            static_foreach<transposed<P>, Size>([&](size_t k) {
+                T lanes[W];
+                values[k].store(lanes);
+                static_foreach<0, W>([&](size_t j) {
+                    p[(i + j) * Stride + k] = lanes[j];
+                });
+            });
+        }
+    }
+};
+
+template<size_t Size, class T, class E>
+Stream<T, Size, sizeof(E) / sizeof(std::remove_const_t<T>)> stream(T* first, E*) {
+    static_assert(sizeof(E) % sizeof(T) == 0);
+    return { first };
+}
+
+/**
+ * block<S>(i) on count elements: on Lanes elements at a time with S a simd::Packet, on the rest one by one
+ * with S = T.
+ */
+template<class T, size_t Lanes = lanes<T>, class Block>
+void for_each_block(size_t count, const Block& block) {
+    size_t i = 0;
+    if constexpr (Lanes > 1) {
+        using P = simd::Packet<T, Lanes>;
+        for (; i + P::BatchWidth <= count; i += P::BatchWidth)
+            block.template operator()<P>(i);
+    }
+    for (; i < count; ++i)
+        block.template operator()<T>(i);
+}
+
+/**
+ * out = kernel(in...) on count elements, Lanes at a time on simd::Packet components and the rest on scalars.
+ */
+template<class T, size_t Lanes = lanes<T>, class Kernel, class Out, class... In>
+void for_each(size_t count, const Kernel& kernel, const Out& out, const In&... in) {
+    for_each_block<T, Lanes>(count, [&]<class S>(size_t i) {
+        out.scatter(i, kernel(in.template gather<S>(i)...));
+    });
+}
+
+/**
+ * Lanes of T that also transpose the components of elements of Size scalars in whole registers, when narrower.
+ */
+template<class T, size_t Size>
+constexpr size_t lanes_for = Size < lanes<T> && Size % 4 == 0 && simd::packet_supported<T, 4> ? 4 : lanes<T>;
+
+/**
+ * Flags of the elements from i on, where the comparison mask of their S components (a bool for a scalar)
+ * is set; flags may be null. Returns how many are set.
+ */
+template<class S, class Mask>
+size_t store_mask(const Mask& mask, bool* flags, size_t i) {
+    if constexpr (std::is_arithmetic_v<S>) {
+        if (flags)
+            flags[i] = mask;
+        return mask ? 1 : 0;
+    } else {
+        auto bits = static_cast<unsigned>(mask.movemask());
+        if (flags) {
+            static_foreach<0, S::BatchWidth>([&](size_t j) {
+                flags[i + j] = (bits >> j) & 1u;
+            });
+        }
+        return size_t(std::popcount(bits));
+    }
+}
+
+} // namespace glsl::details::soa
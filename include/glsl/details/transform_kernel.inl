@@ -0,0 +1,34 @@
+// Body of the wide transform kernels, included once per instruction set by transform_kernels.h inside a
+// namespace that defines Wide<T> and a target pragma that enables its instructions.
+
+/**
+ * Transforms count vectors of InSize scalars by the column-major 4x4 matrix m like transform_packed, but
+ * Wide<T>::elements vectors per register. Returns the number of vectors done, the rest is left to the caller.
+ */
+template<class T, size_t InSize, size_t OutSize, int W>
+size_t transform(const T* in, const T* m, T* out, size_t count) {
+    using Reg = Wide<T>;
+    using type = typename Reg::type;
+
+    const type c0 = Reg::column(m), c1 = Reg::column(m + 4), c2 = Reg::column(m + 8), c3 = Reg::column(m + 12);
+
+    const bool stream = OutSize == 4 && count * OutSize * sizeof(T) > GLSL_STREAM_THRESHOLD &&
+                        reinterpret_cast<uintptr_t>(out) % sizeof(type) == 0;
+
+    size_t i = 0;
+    for (; i + Reg::elements <= count; i += Reg::elements) {
+        auto v = Reg::template load<InSize>(in + i * InSize);
+        type r = Reg::fmadd(c2, Reg::template splat<2>(v),
+                            Reg::fmadd(c1, Reg::template splat<1>(v), Reg::mul(c0, Reg::template splat<0>(v))));
+        if constexpr (InSize == 4) {
+            r = Reg::fmadd(c3, Reg::template splat<3>(v), r);
+        } else if constexpr (W == 1) {
+            r = Reg::add(r, c3);
+        }
+        Reg::template store<OutSize>(out + i * OutSize, r, stream);
+    }
+
+    if (stream)
+        _mm_sfence();
+    return i;
+}
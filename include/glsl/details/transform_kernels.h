@@ -0,0 +1,235 @@
+#pragma once
+
+#include <cstdint>
+#include "dispatch.h"
+
+#ifndef GLSL_STREAM_THRESHOLD
+#define GLSL_STREAM_THRESHOLD (4u << 20)
+#endif
+
+/**
+ * AVX2 and AVX-512 variants of the bulk transform kernel, picked at run time by transform_span through
+ * active_isa(). Each variant is compiled under a target pragma, so the build itself can stay at SSE2.
+ */
+
+#if GLSL_DISPATCH && !GLSL_DISPATCH_DEFINITIONS
+
+// Instantiated by the glsl_dispatch library. The definitions must not follow a declaration outside of
+// their target pragma, so these are only seen where the definitions are not.
+namespace glsl::details::avx2 {
+
+template<class T, size_t InSize, size_t OutSize, int W>
+size_t transform(const T* in, const T* m, T* out, size_t count);
+
+} // namespace glsl::details::avx2
+
+namespace glsl::details::avx512 {
+
+template<class T, size_t InSize, size_t OutSize, int W>
+size_t transform(const T* in, const T* m, T* out, size_t count);
+
+} // namespace glsl::details::avx512
+
+#elif GLSL_DISPATCH
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx2,fma"))), apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target("avx2,fma")
+#endif
+
+namespace glsl::details::avx2 {
+
+template<class T>
+struct Wide;
+
+// Two vec4 per register, one in each 128-bit half.
+template<>
+struct Wide<float> {
+    using type = __m256;
+
+    static constexpr size_t elements = 2;
+
+    static type column(const float* m) { return _mm256_broadcast_ps(reinterpret_cast<const __m128*>(m)); }
+
+    static type mul(type a, type b) { return _mm256_mul_ps(a, b); }
+    static type add(type a, type b) { return _mm256_add_ps(a, b); }
+    static type fmadd(type a, type b, type c) { return _mm256_fmadd_ps(a, b, c); }
+
+    static __m128i first3() { return _mm_setr_epi32(-1, -1, -1, 0); }
+
+    // The 4 scalars of the first vec3 end with the x of the second one, which is part of the block.
+    template<size_t N>
+    static type load(const float* p) {
+        if constexpr (N == 4) {
+            return _mm256_loadu_ps(p);
+        } else {
+            return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(p)), _mm_maskload_ps(p + 3, first3()), 1);
+        }
+    }
+
+    template<int J>
+    static type splat(type v) { return _mm256_permute_ps(v, J * 0x55); }
+
+    template<size_t N>
+    static void store(float* p, type r, bool stream) {
+        if constexpr (N == 4) {
+            if (stream) {
+                _mm256_stream_ps(p, r);
+            } else {
+                _mm256_storeu_ps(p, r);
+            }
+        } else {
+            _mm_storeu_ps(p, _mm256_castps256_ps128(r));
+            _mm_maskstore_ps(p + 3, first3(), _mm256_extractf128_ps(r, 1));
+        }
+    }
+};
+
+// One dvec4 per register, the components are broadcast straight from memory.
+template<>
+struct Wide<double> {
+    using type = __m256d;
+
+    static constexpr size_t elements = 1;
+
+    static type column(const double* m) { return _mm256_loadu_pd(m); }
+
+    static type mul(type a, type b) { return _mm256_mul_pd(a, b); }
+    static type add(type a, type b) { return _mm256_add_pd(a, b); }
+    static type fmadd(type a, type b, type c) { return _mm256_fmadd_pd(a, b, c); }
+
+    template<size_t N>
+    static const double* load(const double* p) { return p; }
+
+    template<int J>
+    static type splat(const double* p) { return _mm256_broadcast_sd(p + J); }
+
+    template<size_t N>
+    static void store(double* p, type r, bool stream) {
+        if constexpr (N == 4) {
+            if (stream) {
+                _mm256_stream_pd(p, r);
+            } else {
+                _mm256_storeu_pd(p, r);
+            }
+        } else {
+            _mm256_maskstore_pd(p, _mm256_setr_epi64x(-1, -1, -1, 0), r);
+        }
+    }
+};
+
+#include "transform_kernel.inl"
+
+} // namespace glsl::details::avx2
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#pragma clang attribute push(__attribute__((target("avx512f"))), apply_to = function)
+#else
+#pragma GCC pop_options
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+#endif
+
+namespace glsl::details::avx512 {
+
+template<class T>
+struct Wide;
+
+// Four vec4 per register, one in each 128-bit lane. vec3 blocks are spread to and packed from the lanes
+// with a permute around a masked load/store of the 12 scalars. The shuffles take the zero-masking forms
+// with a full mask, their plain forms trip -Wuninitialized inside the GCC 12 headers at -O0.
+template<>
+struct Wide<float> {
+    using type = __m512;
+
+    static constexpr size_t elements = 4;
+    static constexpr __mmask16 all = 0xffff;
+
+    static type column(const float* m) { return _mm512_maskz_broadcast_f32x4(all, _mm_loadu_ps(m)); }
+
+    static type mul(type a, type b) { return _mm512_mul_ps(a, b); }
+    static type add(type a, type b) { return _mm512_add_ps(a, b); }
+    static type fmadd(type a, type b, type c) { return _mm512_fmadd_ps(a, b, c); }
+
+    template<size_t N>
+    static type load(const float* p) {
+        if constexpr (N == 4) {
+            return _mm512_loadu_ps(p);
+        } else {
+            const __m512i spread = _mm512_setr_epi32(0, 1, 2, 2, 3, 4, 5, 5, 6, 7, 8, 8, 9, 10, 11, 11);
+            return _mm512_maskz_permutexvar_ps(all, spread, _mm512_maskz_loadu_ps(0x0fff, p));
+        }
+    }
+
+    template<int J>
+    static type splat(type v) { return _mm512_maskz_permute_ps(all, v, J * 0x55); }
+
+    template<size_t N>
+    static void store(float* p, type r, bool stream) {
+        if constexpr (N == 4) {
+            if (stream) {
+                _mm512_stream_ps(p, r);
+            } else {
+                _mm512_storeu_ps(p, r);
+            }
+        } else {
+            const __m512i pack = _mm512_setr_epi32(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, 0, 0, 0, 0);
+            _mm512_mask_storeu_ps(p, 0x0fff, _mm512_maskz_permutexvar_ps(all, pack, r));
+        }
+    }
+};
+
+// Two dvec4 per register, one in each 256-bit half.
+template<>
+struct Wide<double> {
+    using type = __m512d;
+
+    static constexpr size_t elements = 2;
+    static constexpr __mmask8 all = 0xff;
+
+    static type column(const double* m) { return _mm512_maskz_broadcast_f64x4(all, _mm256_loadu_pd(m)); }
+
+    static type mul(type a, type b) { return _mm512_mul_pd(a, b); }
+    static type add(type a, type b) { return _mm512_add_pd(a, b); }
+    static type fmadd(type a, type b, type c) { return _mm512_fmadd_pd(a, b, c); }
+
+    template<size_t N>
+    static type load(const double* p) {
+        if constexpr (N == 4) {
+            return _mm512_loadu_pd(p);
+        } else {
+            return _mm512_maskz_permutexvar_pd(all, _mm512_setr_epi64(0, 1, 2, 2, 3, 4, 5, 5), _mm512_maskz_loadu_pd(0x3f, p));
+        }
+    }
+
+    template<int J>
+    static type splat(type v) { return _mm512_maskz_permutex_pd(all, v, J * 0x55); }
+
+    template<size_t N>
+    static void store(double* p, type r, bool stream) {
+        if constexpr (N == 4) {
+            if (stream) {
+                _mm512_stream_pd(p, r);
+            } else {
+                _mm512_storeu_pd(p, r);
+            }
+        } else {
+            _mm512_mask_storeu_pd(p, 0x3f, _mm512_maskz_permutexvar_pd(all, _mm512_setr_epi64(0, 1, 2, 4, 5, 6, 0, 0), r));
+        }
+    }
+};
+
+#include "transform_kernel.inl"
+
+} // namespace glsl::details::avx512
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
+
+#endif // GLSL_DISPATCH
@@ -1,7 +1,9 @@
 #pragma once
 
+#include <cmath>
 #include <type_traits>
 #include <concepts>
+#include "config.h"
 
 namespace glsl {
 
@@ -64,7 +66,23 @@ concept MatrixQuadN = requires {
 };
 
 template<typename T>
-concept Scalar = std::is_scalar_v<T>;
+concept Batch = requires {
+    typename T::BatchItem;
+    { T::BatchWidth } -> std::convertible_to<std::size_t>;
+};
+
+// Storage scalars (half, bfloat16) converting to a wider arithmetic type for every operation.
+template<typename T>
+concept Widening = requires {
+    typename T::WidenedType;
+    requires std::is_arithmetic_v<typename T::WidenedType>;
+};
+
+template<typename T>
+concept Scalar = std::is_scalar_v<T> || Batch<T> || Widening<T>;
+
+template<typename T>
+concept Mask = std::same_as<T, bool> || (Batch<T> && std::same_as<typename T::BatchItem, bool>);
 
 } // namespace concepts
 
@@ -130,6 +148,23 @@ struct first {
     using type = T1;
 };
 
+template<class T>
+struct batch_trait {
+    using item = T;
+
+    static constexpr size_t width = 1;
+};
+
+template<concepts::Batch T>
+struct batch_trait<T> {
+    using item = typename T::BatchItem;
+
+    static constexpr size_t width = T::BatchWidth;
+};
+
+template<class T>
+using batch_item_t = typename batch_trait<T>::item;
+
 } // namespace traits
 
 namespace concepts {
@@ -161,6 +196,24 @@ constexpr void static_foreach(const Action& action) {
     }
 }
 
+template<class T>
+constexpr T select(bool mask, const T& a, const T& b) {
+    return mask ? a : b;
+}
+
+// a * b + c with a single rounding where the target has an fma instruction (FP_FAST_FMA), a * b + c otherwise
+// and in constant evaluation. Forced inline, GCC stops inlining longer chains once they hold std::fma calls.
+template<class T> requires std::is_arithmetic_v<T>
+[[gnu::always_inline]] constexpr T fma(T a, T b, T c) {
+    if constexpr (std::is_floating_point_v<T>) {
+#if defined(FP_FAST_FMA) && defined(FP_FAST_FMAF)
+        if (!std::is_constant_evaluated())
+            return std::fma(a, b, c);
+#endif
+    }
+    return T(a * b + c);
+}
+
 template<class T, class Func>
 constexpr void vector_foreach(const Func& func) {
     details::static_foreach<0, traits::vector_trait<T>::size>(func);
@@ -0,0 +1,226 @@
+#pragma once
+
+#include <functional>
+#include <ostream>
+#include "utils.h"
+
+namespace glsl {
+
+template<class Scalar, size_t Size, template<class, size_t> class Trait>
+struct Vector;
+
+template<class Trait, size_t... Indices>
+struct VectorProxy;
+
+/**
+ * Lazy vector arithmetic, enabled with GLSL_EXPR_TEMPLATES. +, -, * and / on Vector and VectorProxy
+ * operands build a VectorExpr tree instead of a temporary per operator; the tree is a read-only vector
+ * that is evaluated lane by lane, in one loop, when a Vector is constructed or assigned from it.
+ * a * b + c, a * b - c, c + a * b and c - a * b are contracted to fma on floating point lanes.
+ *
+ * Vector lvalues are held by reference, so an expression must not outlive its operands (do not keep one
+ * in an auto variable past them). Temporaries, swizzles and scalars are held by value, which also makes
+ * v = v.zyx + u safe. Vectors with packed register kernels (SimdVectorTrait) or Batch items stay eager.
+ * Expressions have no swizzles, select from the evaluated vector: vec3(a + b).xy.
+ */
+template<class Op, class L, class R>
+struct VectorExpr;
+
+namespace details::expr {
+
+template<class T>
+struct is_vector : std::false_type {};
+
+template<class Scalar, size_t Size, template<class, size_t> class Trait>
+struct is_vector<Vector<Scalar, Size, Trait>> : std::true_type {};
+
+template<class T>
+struct is_proxy : std::false_type {};
+
+template<class Trait, size_t... Indices>
+struct is_proxy<VectorProxy<Trait, Indices...>> : std::true_type {};
+
+template<class T>
+struct is_expr : std::false_type {};
+
+template<class Op, class L, class R>
+struct is_expr<VectorExpr<Op, L, R>> : std::true_type {};
+
+#if GLSL_EXPR_TEMPLATES
+template<class Trait>
+constexpr bool lazy_trait = !requires { requires Trait::Packed; };
+#else
+template<class Trait>
+constexpr bool lazy_trait = false;
+#endif
+
+template<class T>
+constexpr bool lazy_vector = [] {
+    if constexpr (is_vector<T>::value || is_proxy<T>::value) {
+        return lazy_trait<typename T::template VectorFactory<typename T::VectorItem, T::VectorSize>::TraitType> &&
+               !concepts::Batch<typename T::VectorItem> && !concepts::Widening<typename T::VectorItem>;
+    } else {
+        return false;
+    }
+}();
+
+template<class T>
+concept Expression = is_expr<std::remove_cvref_t<T>>::value;
+
+template<class T, class U>
+concept Mixed = !std::same_as<T, U> && (Expression<T> || Expression<U>);
+
+// Vector-shaped operand of a lazy operator.
+template<class T>
+concept Lazy = Expression<T> || lazy_vector<std::remove_cvref_t<T>>;
+
+// Concrete Vector an operand evaluates to, the type itself for scalars.
+template<class T>
+struct shape {
+    using type = T;
+};
+
+template<class T> requires (is_proxy<T>::value || is_expr<T>::value)
+struct shape<T> {
+    using type = typename T::Vector;
+};
+
+template<class T>
+using shape_t = typename shape<std::remove_cvref_t<T>>::type;
+
+template<class T, class V>
+concept SuitedFor = concepts::SuitedScalarFor<std::remove_cvref_t<T>, V> || concepts::SuitedVectorFor<shape_t<T>, V>;
+
+// Proxies are left operands of their own operators, which evaluate them first.
+template<class L, class R>
+concept Operands = !is_proxy<std::remove_cvref_t<L>>::value &&
+                   ((Lazy<L> && SuitedFor<R, shape_t<L>>) || (Lazy<R> && SuitedFor<L, shape_t<R>>));
+
+// Vector lvalues by reference, everything else by value.
+template<class T>
+using stored_t = std::conditional_t<std::is_lvalue_reference_v<T> && is_vector<std::remove_cvref_t<T>>::value,
+                                    const std::remove_cvref_t<T>&, std::remove_cvref_t<T>>;
+
+template<class T>
+constexpr decltype(auto) evaluate(const T& v) {
+    if constexpr (Expression<T>) {
+        return v.eval();
+    } else {
+        return v;
+    }
+}
+
+template<class Op, class L, class R>
+constexpr auto make(L&& l, R&& r) {
+    return VectorExpr<Op, stored_t<L&&>, stored_t<R&&>>{ std::forward<L>(l), std::forward<R>(r) };
+}
+
+} // namespace details::expr
+
+template<class Op, class L, class R>
+struct VectorExpr {
+
+    using Vector = std::conditional_t<!details::expr::Lazy<R>, details::expr::shape_t<L>,
+                   std::conditional_t<!details::expr::Lazy<L>, details::expr::shape_t<R>,
+                                      traits::vector_common_t<details::expr::shape_t<L>, details::expr::shape_t<R>>>>;
+
+    using VectorItem = typename Vector::VectorItem;
+
+    template<class Scalar_, size_t Size_>
+    using VectorFactory = typename Vector::template VectorFactory<Scalar_, Size_>;
+
+    static constexpr size_t VectorSize = Vector::VectorSize;
+
+    L lhs;
+    R rhs;
+
+    // Forced inline like lane() and details::fma(), GCC stops inlining nested trees once their lanes hold fma calls.
+    [[gnu::always_inline]] constexpr auto operator[](size_t i) const {
+        using namespace details::expr;
+        constexpr bool additive = std::same_as<Op, std::plus<>> || std::same_as<Op, std::minus<>>;
+        if constexpr (std::is_floating_point_v<VectorItem> && additive && contracts<L>) {
+            // (a * b) + c, (a * b) - c
+            auto c = VectorItem(lane(rhs, i));
+            return details::fma(VectorItem(lane(lhs.lhs, i)), VectorItem(lane(lhs.rhs, i)),
+                                std::same_as<Op, std::plus<>> ? c : -c);
+        } else if constexpr (std::is_floating_point_v<VectorItem> && additive && contracts<R>) {
+            // c + (a * b), c - (a * b)
+            auto a = VectorItem(lane(rhs.lhs, i));
+            return details::fma(std::same_as<Op, std::plus<>> ? a : -a, VectorItem(lane(rhs.rhs, i)),
+                                VectorItem(lane(lhs, i)));
+        } else {
+            return Op{}(lane(lhs, i), lane(rhs, i));
+        }
+    }
+
+    constexpr Vector eval() const {
+        return Vector(*this);
+    }
+
+    template<class T>
+    constexpr bool operator==(const T& v) const {
+        return eval() == v;
+    }
+
+    template<class T>
+    constexpr bool operator!=(const T& v) const {
+        return eval() != v;
+    }
+
+    friend std::ostream& operator<<(std::ostream& os, const VectorExpr& obj) {
+        return os << obj.eval();
+    }
+
+private:
+
+    // Lane i of a vector operand of this shape, scalars (and vectors of a lower space) are broadcast.
+    template<class T>
+    [[gnu::always_inline]] static constexpr decltype(auto) lane(const T& v, size_t i) {
+        if constexpr (details::expr::Lazy<T> || details::expr::is_proxy<T>::value) {
+            if constexpr (traits::vector_trait<details::expr::shape_t<T>>::space == traits::vector_trait<Vector>::space) {
+                return v[i];
+            } else {
+                return (v);
+            }
+        } else {
+            return (v);
+        }
+    }
+
+    // A lane-aligned product operand that can be fused into the sum.
+    template<class T>
+    static constexpr bool contracts = [] {
+        if constexpr (details::expr::is_expr<T>::value) {
+            return std::same_as<typename T::OpType, std::multiplies<>> &&
+                   traits::vector_trait<typename T::Vector>::space == traits::vector_trait<Vector>::space;
+        } else {
+            return false;
+        }
+    }();
+
+public:
+
+    using OpType = Op;
+};
+
+template<class L, class R> requires details::expr::Operands<L, R>
+constexpr auto operator+(L&& l, R&& r) {
+    return details::expr::make<std::plus<>>(std::forward<L>(l), std::forward<R>(r));
+}
+
+template<class L, class R> requires details::expr::Operands<L, R>
+constexpr auto operator-(L&& l, R&& r) {
+    return details::expr::make<std::minus<>>(std::forward<L>(l), std::forward<R>(r));
+}
+
+template<class L, class R> requires details::expr::Operands<L, R>
+constexpr auto operator*(L&& l, R&& r) {
+    return details::expr::make<std::multiplies<>>(std::forward<L>(l), std::forward<R>(r));
+}
+
+template<class L, class R> requires details::expr::Operands<L, R>
+constexpr auto operator/(L&& l, R&& r) {
+    return details::expr::make<std::divides<>>(std::forward<L>(l), std::forward<R>(r));
+}
+
+} // namespace glsl
@@ -0,0 +1,692 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <numbers>
+#include <utility>
+#include "utils.h"
+#include "packet.h"
+
+namespace glsl::details::vmath {
+
+/**
+ * Full precision sin, cos, tan, asin, acos, exp, exp2, log, log2 and pow on whole simd::Packet registers,
+ * DEF_VEC_FUNC_PACKED routes float and double vectors here instead of calling the std:: function per lane.
+ * The kernels follow fdlibm/cephes (argument reduction, minimax polynomial, exact reconstruction) and are
+ * written once for scalars and packets, selects replace branches.
+ *
+ * Maximum error against the exact result, measured over the domain:
+ *
+ *                      float     double
+ *   sin, cos           1.5 ulp   1.5 ulp      |x| <= 1e6
+ *   tan                3 ulp     2.5 ulp      |x| <= 1e6
+ *   asin               2.5 ulp   2.5 ulp
+ *   acos               1.5 ulp   1.5 ulp
+ *   exp, exp2          1 ulp     1 ulp        subnormal results included
+ *   log, log2          1 ulp     1 ulp
+ *   pow                1 ulp     1.5 ulp      x > 0
+ *
+ * Float trig arguments beyond trig_limit_single and float pow are evaluated on double lanes.
+ * Double vectors and pow are only routed here in AVX builds, see the kernel profitable traits.
+ * Lanes outside the fast domain (huge or non-finite trig arguments, pow with x <= 0 or non-finite
+ * arguments) are recomputed with the std:: function, so special values match <cmath>.
+ */
+template<class T>
+concept Real = std::floating_point<traits::batch_item_t<T>>;
+
+template<class T>
+using item_t = traits::batch_item_t<T>;
+
+template<class T, class U>
+struct rebind {
+    using type = U;
+};
+
+template<class T, size_t W, class U>
+struct rebind<simd::Packet<T, W>, U> {
+    using type = simd::Packet<U, W>;
+};
+
+template<class T, class U>
+using rebind_t = typename rebind<T, U>::type;
+
+// Integer scalar or packet of the width of T.
+template<class T>
+using int_t = rebind_t<T, simd::int_for<item_t<T>>>;
+
+template<class U, class T>
+constexpr rebind_t<T, U> convert(const T& v) {
+    return rebind_t<T, U>(v);
+}
+
+template<class U, class T>
+constexpr rebind_t<T, U> bitcast(const T& v) {
+    return std::bit_cast<rebind_t<T, U>>(v);
+}
+
+template<class T>
+constexpr bool single = sizeof(item_t<T>) == 4;
+
+template<class T>
+constexpr int mantissa_bits = std::numeric_limits<item_t<T>>::digits - 1;
+
+template<class T>
+constexpr int exponent_bias = std::numeric_limits<item_t<T>>::max_exponent - 1;
+
+/**
+ * 2^n for integers n inside the normal exponent range.
+ */
+template<Real T, class I>
+T pow2i(const I& n) {
+    return bitcast<item_t<T>>(I(n + I(exponent_bias<T>)) << mantissa_bits<T>);
+}
+
+/**
+ * y * 2^k for integral k, 2^k is applied in two halves so subnormal and near-overflow results round once.
+ */
+template<Real T>
+T scale(const T& y, const T& k);
+
+/**
+ * Rounds to the nearest integer by pushing the fraction out of the mantissa, exact for |x| < 2^(mantissa_bits - 1).
+ */
+template<Real T>
+T round_nearest(const T& x) {
+    constexpr double shifter = 1.5 * double(uint64_t(1) << mantissa_bits<T>);
+    return (x + T(shifter)) - T(shifter);
+}
+
+template<class T>
+constexpr T horner(const T&, double c) {
+    return T(c);
+}
+
+template<class T, class... C>
+constexpr T horner(const T& x, double c, C... cs) {
+    return T(c) + x * horner(x, cs...);
+}
+
+// x^N for N a power of two.
+template<size_t N, class T>
+T power(const T& x) {
+    if constexpr (N == 1) {
+        return x;
+    } else {
+        T h = power<N / 2>(x);
+        return h * h;
+    }
+}
+
+template<size_t First, size_t Count, class T, size_t N>
+T estrin(const T& x, const std::array<double, N>& c) {
+    if constexpr (Count == 1) {
+        return T(c[First]);
+    } else {
+        constexpr size_t half = std::bit_floor(Count - 1);
+        return estrin<First, half>(x, c) + power<half>(x) * estrin<First + half, Count - half>(x, c);
+    }
+}
+
+/**
+ * The polynomial of horner evaluated with Estrin's scheme: the low and high halves of the terms are
+ * evaluated independently and joined with a power of x, the dependency chain grows with log2 of the degree.
+ */
+template<class T, class... C>
+T estrin(const T& x, C... cs) {
+    return estrin<0, sizeof...(C)>(x, std::array<double, sizeof...(C)>{ double(cs)... });
+}
+
+template<Real T>
+T fabs(const T& x) {
+    using Bits = item_t<int_t<T>>;
+    return bitcast<item_t<T>>(bitcast<Bits>(x) & int_t<T>(std::numeric_limits<Bits>::max()));
+}
+
+// |magnitude| with the sign of sign, magnitude must be non-negative.
+template<Real T>
+T copysign(const T& magnitude, const T& sign) {
+    using Bits = item_t<int_t<T>>;
+    return bitcast<item_t<T>>(bitcast<Bits>(magnitude) | (bitcast<Bits>(sign) & int_t<T>(std::numeric_limits<Bits>::min())));
+}
+
+// x with the low Bits mantissa bits cleared.
+template<int Bits, Real T>
+T clear_low(const T& x) {
+    using I = int_t<T>;
+    return bitcast<item_t<T>>(bitcast<item_t<I>>(x) & I(~((item_t<I>(1) << Bits) - 1)));
+}
+
+template<Real T>
+T square_root(const T& x) {
+    using std::sqrt;
+    return sqrt(x);
+}
+
+// a + b = s + e exactly.
+template<Real T>
+T two_sum(const T& a, const T& b, T& e) {
+    T s = a + b;
+    T bb = s - a;
+    e = (a - (s - bb)) + (b - bb);
+    return s;
+}
+
+// a * b = p + e, exact up to the rounding of the smallest partial product.
+template<Real T>
+T two_prod(const T& a, const T& b, T& e) {
+    constexpr int half = (mantissa_bits<T> + 2) / 2;
+    T ah = clear_low<half>(a), al = a - ah;
+    T bh = clear_low<half>(b), bl = b - bh;
+    T p = a * b;
+    e = ((ah * bh - p) + ah * bl + al * bh) + al * bl;
+    return p;
+}
+
+template<class M>
+int lane_bits(const M& mask) {
+    if constexpr (std::same_as<M, bool>) {
+        return mask ? 1 : 0;
+    } else {
+        return mask.movemask();
+    }
+}
+
+template<class T, class Func, class... Args>
+T patch_lanes(int bits, const T& result, const Func& func, const Args&... args) {
+    if constexpr (std::is_arithmetic_v<T>) {
+        return T(func(args...));
+    } else {
+        constexpr size_t W = traits::batch_trait<T>::width;
+        item_t<T> out[W], in[sizeof...(Args) + 1][W];
+        result.store(out);
+        size_t n = 0;
+        (args.store(in[n++]), ...);
+
+        for (size_t i = 0; i < W; ++i) {
+            if ((bits >> i) & 1) {
+                out[i] = [&]<size_t... K>(std::index_sequence<K...>) {
+                    return item_t<T>(func(in[K][i]...));
+                }(std::index_sequence_for<Args...>());
+            }
+        }
+        return T::load(out);
+    }
+}
+
+/**
+ * Recomputes the lanes selected by mask with the scalar func, used for inputs outside a kernel's fast domain.
+ */
+template<class T, class M, class Func, class... Args>
+T patch(const M& mask, const T& result, const Func& func, const Args&... args) {
+    int bits = lane_bits(mask);
+    if (bits == 0) [[likely]]
+        return result;
+    return patch_lanes(bits, result, func, args...);
+}
+
+/**
+ * func evaluated on the float lanes of x in double, the result is rounded to float once.
+ */
+template<class Func, Real T, class... Rest>
+T in_double(const Func& func, const T& x, const Rest&... rest) {
+    if constexpr (std::is_arithmetic_v<T>) {
+        return T(func(double(x), double(rest)...));
+    } else if constexpr (requires { simd::promote(x); }) {
+        return simd::demote(func(simd::promote(x), simd::promote(rest)...));
+    } else {
+        auto [lo, hi] = simd::widen(x);
+        if constexpr (sizeof...(Rest) == 0) {
+            return simd::narrow(func(lo), func(hi));
+        } else {
+            auto [rlo, rhi] = simd::widen(rest...);
+            return simd::narrow(func(lo, rlo), func(hi, rhi));
+        }
+    }
+}
+
+// Largest |x| the trig kernels reduce themselves, larger double arguments are patched with std::.
+constexpr double trig_limit = 1e6;
+
+// Float arguments up to this bound are reduced in float, a packet holding a larger one runs in double.
+constexpr double trig_limit_single = 128;
+
+/**
+ * r = x - q * pi/2 with r in [-pi/4, pi/4], pi/2 is split in three parts so k * part stays exact
+ * (for |x| below 8192 in float and trig_limit in double).
+ */
+template<Real T>
+T reduce_half_pi(const T& x, int_t<T>& q) {
+    T k = round_nearest(x * T(2 / std::numbers::pi));
+    q = convert<item_t<int_t<T>>>(k);
+    if constexpr (single<T>) {
+        return ((x - k * T(1.5703125)) - k * T(4.837512969970703125e-4)) - k * T(7.54978995489188216e-8);
+    } else {
+        return ((x - k * T(1.57079625129699707031)) - k * T(7.54978941586159635336e-8)) - k * T(5.39030285815811905290e-15);
+    }
+}
+
+// True when some float lane of x is beyond trig_limit_single (or not a number).
+template<Real T>
+bool trig_far(const T& x) {
+    return lane_bits(!(fabs(x) <= T(trig_limit_single))) != 0;
+}
+
+// sin and cos on [-pi/4, pi/4].
+template<Real T>
+T sin_poly(const T& r) {
+    T z = r * r;
+    if constexpr (single<T>) {
+        return r + r * z * estrin(z, -1.6666654611e-1, 8.3321608736e-3, -1.9515295891e-4);
+    } else {
+        return r + r * z * estrin(z, -1.66666666666666307295e-1, 8.33333333332211858878e-3, -1.98412698295895385996e-4,
+                                  2.75573136213857245213e-6, -2.50507477628578072866e-8, 1.58962301576546568060e-10);
+    }
+}
+
+template<Real T>
+T cos_poly(const T& r) {
+    T z = r * r;
+    if constexpr (single<T>) {
+        return T(1) - T(0.5) * z + z * z * estrin(z, 4.166664568298827e-2, -1.388731625493765e-3, 2.443315711809948e-5);
+    } else {
+        return T(1) - T(0.5) * z + z * z * estrin(z, 4.16666666666665929218e-2, -1.38888888888730564116e-3,
+                                                  2.48015872888517045348e-5, -2.75573141792967388112e-7,
+                                                  2.08757008419747316778e-9, -1.13585365213876817300e-11);
+    }
+}
+
+template<Real T>
+T sin(const T& x) {
+    if constexpr (single<T>) {
+        if (trig_far(x))
+            return in_double([](const auto& v) { return vmath::sin(v); }, x);
+    }
+    using I = int_t<T>;
+    I q;
+    T r = reduce_half_pi(x, q);
+    T v = select((q & I(1)) != I(0), cos_poly(r), sin_poly(r));
+    v = select((q & I(2)) != I(0), T(-v), v);
+    v = select(x == T(0), x, v);
+    return patch(!(fabs(x) <= T(trig_limit)), v, [](auto a) { return std::sin(a); }, x);
+}
+
+template<Real T>
+T cos(const T& x) {
+    if constexpr (single<T>) {
+        if (trig_far(x))
+            return in_double([](const auto& v) { return vmath::cos(v); }, x);
+    }
+    using I = int_t<T>;
+    I q;
+    T r = reduce_half_pi(x, q);
+    T v = select((q & I(1)) != I(0), sin_poly(r), cos_poly(r));
+    v = select(((q + I(1)) & I(2)) != I(0), T(-v), v);
+    return patch(!(fabs(x) <= T(trig_limit)), v, [](auto a) { return std::cos(a); }, x);
+}
+
+template<Real T>
+T tan(const T& x) {
+    if constexpr (single<T>) {
+        if (trig_far(x))
+            return in_double([](const auto& v) { return vmath::tan(v); }, x);
+    }
+    using I = int_t<T>;
+    I q;
+    T r = reduce_half_pi(x, q);
+    T z = r * r;
+    T t;
+    if constexpr (single<T>) {
+        t = r + r * z * estrin(z, 3.33331568548e-1, 1.33387994085e-1, 5.34112807005e-2, 2.44301354525e-2,
+                               3.11992232697e-3, 9.38540185543e-3);
+    } else {
+        t = r + r * (z * estrin(z, -1.79565251976484877988e7, 1.15351664838587416140e6, -1.30936939181383777646e4) /
+                     estrin(z, -5.38695755929454629881e7, 2.50083801823357915839e7, -1.32089234440210967447e6,
+                            1.36812963470692954678e4, 1.0));
+    }
+    T v = select((q & I(1)) != I(0), T(T(-1) / t), select(x == T(0), x, t));
+    return patch(!(fabs(x) <= T(trig_limit)), v, [](auto a) { return std::tan(a); }, x);
+}
+
+// asin on [-0.5, 0.5].
+template<Real T>
+T asin_poly(const T& x) {
+    T z = x * x;
+    if constexpr (single<T>) {
+        return x + x * z * estrin(z, 1.6666752422e-1, 7.4953002686e-2, 4.5470025998e-2, 2.4181311049e-2, 4.2163199048e-2);
+    } else {
+        return x + x * (z * estrin(z, -8.198089802484824371615, 1.956261983317594739197e1, -1.626247967210700244449e1,
+                                   5.444622390564711410273, -6.019598008014123785661e-1, 4.253011369004428248960e-3) /
+                        estrin(z, -4.918853881490881290097e1, 1.395105614657485689735e2, -1.471791292232726029859e2,
+                               7.049610280856842141659e1, -1.474091372988853791896e1, 1.0));
+    }
+}
+
+template<Real T>
+constexpr double pio2_hi = single<T> ? 1.57079637050628662109375 : 1.57079632679489655800e+00;
+
+template<Real T>
+constexpr double pio2_lo = single<T> ? -4.37113900018624283e-8 : 6.12323399573676603587e-17;
+
+template<Real T>
+T asin(const T& x) {
+    // asin(a) = pi/2 - 2 asin(sqrt((1 - a) / 2)) for a > 0.5.
+    T a = fabs(x);
+    auto big = a > T(0.5);
+    T c = asin_poly(select(big, square_root(T(T(0.5) - T(0.5) * a)), a));
+    return copysign(select(big, T(T(pio2_hi<T>) - (T(2) * c - T(pio2_lo<T>))), c), x);
+}
+
+template<Real T>
+T acos(const T& x) {
+    T a = fabs(x);
+    auto big = a > T(0.5);
+    T c = asin_poly(select(big, square_root(T(T(0.5) - T(0.5) * a)), x));
+    T twice = T(2) * c;
+    T negative = T(2 * pio2_hi<T>) - (twice - T(2 * pio2_lo<T>));
+    return select(big, select(x < T(0), negative, twice), T(T(pio2_hi<T>) - (c - T(pio2_lo<T>))));
+}
+
+/**
+ * exp(hi - lo) * 2^k for |hi - lo| <= ln2 / 2, the fdlibm kernel: exp(r) = 1 + r + r c / (2 - c).
+ */
+template<Real T>
+T exp_reduced(const T& hi, const T& lo, const T& k) {
+    T r = hi - lo;
+    T z = r * r;
+    T c;
+    if constexpr (single<T>) {
+        c = r - z * estrin(z, 1.6666625440e-1, -2.7667332906e-3);
+    } else {
+        c = r - z * estrin(z, 1.66666666666666019037e-1, -2.77777777770155933842e-3, 6.61375632143793436117e-5,
+                           -1.65339022054652515390e-6, 4.13813679705723846039e-8);
+    }
+    return scale(T(T(1) + ((r * c / (T(2) - c) - lo) + hi)), k);
+}
+
+template<Real T>
+T scale(const T& y, const T& k) {
+    using I = int_t<T>;
+    T h = round_nearest(T(k * T(0.5)));
+    return y * pow2i<T>(convert<item_t<I>>(h)) * pow2i<T>(convert<item_t<I>>(T(k - h)));
+}
+
+// Results of exp(x) overflow above max_log and round to zero below min_log.
+template<Real T>
+constexpr double max_log = single<T> ? 88.72283905206835 : 709.782712893383973096;
+
+template<Real T>
+constexpr double min_log = single<T> ? -103.97208 : -745.1332191019412;
+
+template<Real T>
+constexpr double ln2_hi = single<T> ? 6.9314575195e-01 : 6.93147180369123816490e-01;
+
+template<Real T>
+constexpr double ln2_lo = single<T> ? 1.4286067653e-06 : 1.90821492927058770002e-10;
+
+template<Real T>
+T exp_finish(const T& x, const T& result, double lo, double hi) {
+    constexpr double inf = std::numeric_limits<double>::infinity();
+    T r = select(x > T(hi), T(inf), result);
+    r = select(x < T(lo), T(0), r);
+    return select(x != x, x, r);
+}
+
+template<Real T>
+T exp(const T& x) {
+    T c = select(x < T(min_log<T>), T(min_log<T>), select(x > T(max_log<T>), T(max_log<T>), x));
+    T k = round_nearest(c * T(std::numbers::log2e));
+    T result = exp_reduced(T(c - k * T(ln2_hi<T>)), T(k * T(ln2_lo<T>)), k);
+    return exp_finish(x, result, min_log<T>, max_log<T>);
+}
+
+template<Real T>
+T exp2(const T& x) {
+    constexpr double hi = std::numeric_limits<item_t<T>>::max_exponent;
+    constexpr double lo = std::numeric_limits<item_t<T>>::min_exponent - mantissa_bits<T> - 2;
+    // ln2 rounded to the type and the remainder.
+    constexpr double ln2 = single<T> ? 0.693147182464599609375 : 0.69314718055994528622676;
+    constexpr double ln2_rest = single<T> ? -1.904654299957767878e-9 : 2.319046813846299558e-17;
+
+    T c = select(x < T(lo), T(lo), select(x > T(hi), T(hi), x));
+    T k = round_nearest(c);
+    T r = c - k;
+    T e;
+    T t = two_prod(r, T(ln2), e);
+    T result = exp_reduced(t, T(-(e + r * T(ln2_rest))), k);
+    return exp_finish(x, result, lo, hi);
+}
+
+/**
+ * x = 2^k (1 + f) with 1 + f in [sqrt(0.5), sqrt(2)) for finite x > 0, subnormals included.
+ */
+template<Real T>
+T log_reduce(const T& x, T& k) {
+    using I = int_t<T>;
+    using Bits = item_t<I>;
+    using Item = item_t<T>;
+    constexpr Bits one = std::bit_cast<Bits>(Item(1));
+    constexpr Bits sqrt_half = std::bit_cast<Bits>(Item(std::numbers::sqrt2 / 2));
+    constexpr Bits mantissa = (Bits(1) << mantissa_bits<T>) - 1;
+
+    auto tiny = x < T(std::numeric_limits<Item>::min());
+    T v = select(tiny, T(x * T(double(uint64_t(1) << mantissa_bits<T>))), x);
+
+    I b = bitcast<Bits>(v) + I(one - sqrt_half);
+    k = convert<Item>(I((b >> mantissa_bits<T>) - I(exponent_bias<T>))) - select(tiny, T(mantissa_bits<T>), T(0));
+    return bitcast<Item>(I((b & I(mantissa)) + I(sqrt_half))) - T(1);
+}
+
+// R(z) of log(1 + f) = f - f^2 / 2 + s (f^2 / 2 + R(s^2)), s = f / (2 + f).
+template<Real T>
+T log_poly(const T& z) {
+    if constexpr (single<T>) {
+        return z * estrin(z, 0xaaaaaa.0p-24, 0xccce13.0p-25, 0x91e9ee.0p-25, 0xf89e26.0p-26);
+    } else {
+        return z * estrin(z, 6.666666666666735130e-01, 3.999999999940941908e-01, 2.857142874366239149e-01,
+                          2.222219843214978396e-01, 1.818357216161805012e-01, 1.531383769920937332e-01,
+                          1.479819860511658591e-01);
+    }
+}
+
+template<Real T>
+T log_finish(const T& x, const T& result) {
+    using Item = item_t<T>;
+    T r = select(x == T(std::numeric_limits<Item>::infinity()), x, result);
+    r = select(x == T(0), T(-std::numeric_limits<Item>::infinity()), r);
+    return select(!(x >= T(0)), T(std::numeric_limits<Item>::quiet_NaN()), r);
+}
+
+template<Real T>
+T log(const T& x) {
+    constexpr double hi = single<T> ? 6.9313812256e-01 : 6.93147180369123816490e-01;
+    constexpr double lo = single<T> ? 9.0580006145e-06 : 1.90821492927058770002e-10;
+
+    T k;
+    T f = log_reduce(x, k);
+    T s = f / (T(2) + f);
+    T hfsq = T(0.5) * f * f;
+    T result = s * (hfsq + log_poly(T(s * s))) + k * T(lo) - hfsq + f + k * T(hi);
+    return log_finish(x, result);
+}
+
+template<Real T>
+T log2(const T& x) {
+    // 1 / ln2 split so hi * ivln2_hi is exact.
+    constexpr double ivln2_hi = single<T> ? 1.4428710938e+00 : 1.44269504072144627571e+00;
+    constexpr double ivln2_lo = single<T> ? -1.7605285393e-04 : 1.67517131648865118353e-10;
+
+    T k;
+    T f = log_reduce(x, k);
+    T s = f / (T(2) + f);
+    T hfsq = T(0.5) * f * f;
+    T hi = clear_low<single<T> ? 12 : 32>(T(f - hfsq));
+    T lo = ((f - hi) - hfsq) + s * (hfsq + log_poly(T(s * s)));
+
+    T val_hi = hi * T(ivln2_hi);
+    T val_lo = (lo + hi) * T(ivln2_lo) + lo * T(ivln2_hi);
+    T w = k + val_hi;
+    val_lo = val_lo + ((k - w) + val_hi);
+    return log_finish(x, T(val_lo + w));
+}
+
+/**
+ * log(x) as hi + lo, about 2^-60 relative, for finite x > 0.
+ */
+template<Real T>
+T log_extended(const T& x, T& lo) {
+    T k;
+    T f = log_reduce(x, k);
+
+    // f^2 / 2 = hh + hl with hh exact.
+    T fh = clear_low<(mantissa_bits<T> + 2) / 2>(f), fl = f - fh;
+    T hh = T(0.5) * fh * fh, hl = T(0.5) * fl * (f + fh);
+
+    // s = f / (2 + f) + sl.
+    T d = T(2) + f, dl = f - (d - T(2));
+    T s = f / d;
+    T pe;
+    T p = two_prod(s, d, pe);
+    T sl = (((f - p) - pe) - s * dl) / d;
+
+    // log(1 + f) = f - (hh + hl) + (s + sl) (hh + hl) + s R.
+    T qe, ae, be, ce;
+    T q = two_prod(s, hh, qe);
+    T a = two_sum(f, T(-hh), ae);
+    T b = two_sum(a, q, be);
+    T tail = ae + be + (qe + s * hl + sl * hh + s * log_poly(T(s * s)) - hl);
+
+    T hi = two_sum(T(k * T(ln2_hi<T>)), b, ce);
+    return two_sum(hi, T(ce + tail + k * T(ln2_lo<T>)), lo);
+}
+
+/**
+ * pow of float arguments on double lanes for finite x > 0. |y log x| < 110 wherever the float result is
+ * finite and non-zero, so truncated series (2^-34 relative) for log and exp leave the float result
+ * correctly rounded in almost all cases, and 2^k needs no splitting in double.
+ */
+template<Real T>
+T pow_single(const T& x, const T& y) {
+    T k;
+    T f = log_reduce(x, k);
+    T s = f / (T(2) + f);
+    T l = T(2) * s * estrin(T(s * s), 1.0, 1.0 / 3, 1.0 / 5, 1.0 / 7, 1.0 / 9, 1.0 / 11) + k * T(std::numbers::ln2);
+
+    T m = y * l;
+    T c = select(m < T(-110), T(-110), select(m > T(90), T(90), m));
+    T e = round_nearest(c * T(std::numbers::log2e));
+    T r = (c - e * T(ln2_hi<T>)) - e * T(ln2_lo<T>);
+    T p = estrin(r, 1.0, 1.0, 1.0 / 2, 1.0 / 6, 1.0 / 24, 1.0 / 120, 1.0 / 720, 1.0 / 5040, 1.0 / 40320, 1.0 / 362880);
+    return p * pow2i<T>(convert<item_t<int_t<T>>>(e));
+}
+
+template<Real T>
+T pow(const T& x, const T& y) {
+    T result;
+    if constexpr (single<T>) {
+        result = in_double([](const auto& a, const auto& b) { return vmath::pow_single(a, b); }, x, y);
+    } else {
+        T ll;
+        T l = log_extended(x, ll);
+        T me;
+        T m = two_prod(y, l, me);
+        T ml = me + y * ll;
+
+        T c = select(m < T(min_log<T>), T(min_log<T>), select(m > T(max_log<T>), T(max_log<T>), m));
+        T k = round_nearest(c * T(std::numbers::log2e));
+        result = exp_reduced(T(c - k * T(ln2_hi<T>)), T(k * T(ln2_lo<T>) - ml), k);
+        result = exp_finish(m, result, min_log<T>, max_log<T>);
+    }
+
+    constexpr double inf = std::numeric_limits<double>::infinity();
+    auto regular = (x > T(0)) & (x < T(inf)) & (fabs(y) < T(inf));
+    return patch(!regular, result, [](auto a, auto b) { return std::pow(a, b); }, x, y);
+}
+
+// Double lanes only beat glibc with the AVX encodings (three operand forms, 256 bit double registers).
+template<class Scalar>
+constexpr bool fast_lanes = std::same_as<Scalar, float> || simd::packet_supported<double, 4>;
+
+#define DEF_VMATH_KERNEL(Name, func, ...)                                   \
+struct Name {                                                               \
+    template<class Scalar, size_t Lanes>                                    \
+    static constexpr bool profitable = __VA_ARGS__;                         \
+                                                                            \
+    template<class... T>                                                    \
+    auto operator()(const T&... x) const { return vmath::func(x...); }      \
+};                                                                          \
+
+DEF_VMATH_KERNEL(Sin, sin, fast_lanes<Scalar>)
+DEF_VMATH_KERNEL(Cos, cos, fast_lanes<Scalar>)
+DEF_VMATH_KERNEL(Tan, tan, fast_lanes<Scalar>)
+DEF_VMATH_KERNEL(Asin, asin, fast_lanes<Scalar>)
+DEF_VMATH_KERNEL(Acos, acos, fast_lanes<Scalar>)
+DEF_VMATH_KERNEL(Exp, exp, fast_lanes<Scalar>)
+DEF_VMATH_KERNEL(Exp2, exp2, fast_lanes<Scalar>)
+DEF_VMATH_KERNEL(Log, log, fast_lanes<Scalar>)
+DEF_VMATH_KERNEL(Log2, log2, fast_lanes<Scalar>)
+// pow evaluates on double lanes and only pays off four at a time.
+DEF_VMATH_KERNEL(Pow, pow, simd::packet_supported<double, 4> && (std::same_as<Scalar, float> || Lanes >= 4))
+
+#undef DEF_VMATH_KERNEL
+
+template<class V>
+constexpr size_t lanes() {
+    return simd::register_lanes<traits::vector_item_t<V>, traits::vector_trait<V>::size>();
+}
+
+/**
+ * Kernel can run on vectors of type V: float/double items and a packet register covering all lanes.
+ * Kernels with a profitable trait are only used where it holds, elsewhere the per-lane std:: call is faster.
+ */
+template<class Kernel, class V, class... Rest>
+constexpr bool vectorizable() {
+    if constexpr (std::is_void_v<Kernel> || !(std::same_as<V, Rest> && ...)) {
+        return false;
+    } else if constexpr (!concepts::Vector<V> || !std::is_floating_point_v<traits::vector_item_t<V>>) {
+        return false;
+    } else {
+        using Scalar = traits::vector_item_t<V>;
+        constexpr size_t n = lanes<V>();
+        if constexpr (n == 0 || !simd::packet_supported<Scalar, n>) {
+            return false;
+        } else if constexpr (requires { Kernel::template profitable<Scalar, n>; }) {
+            return Kernel::template profitable<Scalar, n>;
+        } else {
+            return true;
+        }
+    }
+}
+
+/**
+ * Evaluates kernel on all lanes of the vectors at once, padding lanes are set to 1. The result is the vector
+ * type of V, a swizzle argument gives a Vector.
+ */
+template<class Kernel, class V, class... Rest>
+traits::vector_of_t<V> map(const Kernel& kernel, const V& x, const Rest&... rest) {
+    using Scalar = traits::vector_item_t<V>;
+    using Packet = simd::Packet<Scalar, lanes<V>()>;
+
+    auto pack = [](const V& v) {
+        Scalar lanes[Packet::BatchWidth];
+        for (size_t i = traits::vector_trait<V>::size; i < Packet::BatchWidth; ++i)
+            lanes[i] = Scalar(1);
+        details::vector_foreach<V>([&](size_t i) {
+            lanes[i] = v[i];
+        });
+        return Packet::load(lanes);
+    };
+
+    Scalar out[Packet::BatchWidth];
+    kernel(pack(x), pack(rest)...).store(out);
+
+    traits::vector_of_t<V> result;
+    details::vector_foreach<V>([&](size_t i) {
+        result[i] = out[i];
+    });
+    return result;
+}
+
+} // namespace glsl::details::vmath
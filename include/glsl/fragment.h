@@ -0,0 +1,115 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <concepts>
+#include <cstdint>
+#include <span>
+#include "vector.h"
+#include "half.h"
+#include "packing.h"
+#include "quad.h"
+#include "details/parallel.h"
+
+namespace glsl {
+
+namespace details::fragment {
+
+// Pixels per tile side: a 32x32 tile of vec4 colors is 16 KB, it stays in L1/L2 while a thread shades it.
+constexpr unsigned tile = 32;
+
+/**
+ * Writes a row of shaded colors to the framebuffer in its pixel format, through the span conversions.
+ */
+template<class Pixel>
+void store(std::span<const Vector<float, 4>> colors, std::span<Pixel> out) {
+    if constexpr (std::same_as<Pixel, Vector<float, 4>>) {
+        std::copy(colors.begin(), colors.end(), out.begin());
+    } else if constexpr (std::same_as<Pixel, uint32_t>) {
+        packUnorm4x8(colors, out);
+    } else {
+        glsl::narrow<Pixel>(colors, out);
+    }
+}
+
+/**
+ * shade(x0, y0, x1, y1) for the tiles of the framebuffer, handed out one at a time to the shared pool.
+ */
+template<class Shade>
+void for_each_tile(unsigned width, unsigned height, const Shade& shade) {
+    size_t columns = (width + tile - 1) / tile, rows = (height + tile - 1) / tile;
+    parallel::ThreadPool::shared().run(columns * rows, [&](size_t index) {
+        unsigned x0 = unsigned(index % columns) * tile, y0 = unsigned(index / columns) * tile;
+        shade(x0, y0, std::min(x0 + tile, width), std::min(y0 + tile, height));
+    });
+}
+
+} // namespace details::fragment
+
+namespace concepts {
+
+template<typename T>
+concept FragmentPixel = std::same_as<T, glsl::Vector<float, 4>> || std::same_as<T, uint32_t> ||
+                        std::same_as<T, glsl::Vector<half, 4>> || std::same_as<T, glsl::Vector<bfloat16, 4>>;
+
+template<typename T>
+concept FragmentQuadShader =
+    std::invocable<const T&, glsl::Vector<Quad<float>, 2>> &&
+    std::convertible_to<std::invoke_result_t<const T&, glsl::Vector<Quad<float>, 2>>, glsl::Vector<Quad<float>, 4>>;
+
+template<typename T>
+concept FragmentShader = std::invocable<const T&, glsl::Vector<float, 2>> &&
+                         std::convertible_to<std::invoke_result_t<const T&, glsl::Vector<float, 2>>, glsl::Vector<float, 4>>;
+
+} // namespace concepts
+
+/**
+ * Runs shader(fragCoord) -> vec4 for every pixel of a width x height framebuffer: out[x + y * width] is the
+ * color at fragCoord = (x + 0.5, y + 0.5), the pixel center, rows from y = 0 (the bottom row in GLSL terms).
+ * The framebuffer is cut into 32x32 tiles which the threads of the shared pool (max_threads(), GLSL_THREADS)
+ * pick up one at a time, so expensive regions balance out. out holds vec4 colors, uint32_t RGBA8 (R in the
+ * low byte, packUnorm4x8: clamped to [0, 1] and rounded), or hvec4/bf16vec4. The shader is called
+ * concurrently and must not throw.
+ */
+template<concepts::FragmentPixel Pixel, concepts::FragmentShader Shader>
+void run_fragment(unsigned width, unsigned height, const Shader& shader, std::span<Pixel> out) {
+    assert(out.size() >= size_t(width) * height);
+
+    details::fragment::for_each_tile(width, height, [&](unsigned x0, unsigned y0, unsigned x1, unsigned y1) {
+        std::array<Vector<float, 4>, details::fragment::tile> colors;
+        for (unsigned y = y0; y < y1; ++y) {
+            for (unsigned x = x0; x < x1; ++x)
+                colors[x - x0] = Vector<float, 4>(shader(Vector<float, 2>(float(x) + 0.5f, float(y) + 0.5f)));
+            details::fragment::store<Pixel>(std::span(colors.data(), x1 - x0),
+                                            out.subspan(size_t(y) * width + x0, x1 - x0));
+        }
+    });
+}
+
+/**
+ * run_fragment with a shader of 2x2 quads: shader(fragCoord) takes a Vector<Quad<float>, 2> and returns a
+ * Vector<Quad<float>, 4>, one lane per pixel of the quad (see run_quad), so dFdx, dFdy and fwidth can be used
+ * inside it. Quads start at even pixels; on an odd width or height the lanes past the edge are computed, as
+ * helper invocations on a GPU are, and dropped.
+ */
+template<concepts::FragmentPixel Pixel, concepts::FragmentQuadShader Shader>
+void run_fragment_quads(unsigned width, unsigned height, const Shader& shader, std::span<Pixel> out) {
+    assert(out.size() >= size_t(width) * height);
+
+    details::fragment::for_each_tile(width, height, [&](unsigned x0, unsigned y0, unsigned x1, unsigned y1) {
+        std::array<Vector<float, 4>, details::fragment::tile> colors[2];
+        for (unsigned y = y0; y < y1; y += 2) {
+            for (unsigned x = x0; x < x1; x += 2) {
+                Vector<Quad<float>, 4> c = run_quad(Vector<float, 2>(float(x) + 0.5f, float(y) + 0.5f), shader);
+                for (size_t lane = 0; lane < 4; ++lane)
+                    colors[lane / 2][x - x0 + lane % 2] = Vector<float, 4>(c.x[lane], c.y[lane], c.z[lane], c.w[lane]);
+            }
+            for (unsigned row = y; row < std::min(y + 2, y1); ++row) {
+                details::fragment::store<Pixel>(std::span(colors[row - y].data(), x1 - x0),
+                                                out.subspan(size_t(row) * width + x0, x1 - x0));
+            }
+        }
+    });
+}
+} // namespace glsl
@@ -1,25 +1,21 @@
 #pragma once
 
-#ifndef GLSL_VEC_SWIZZLING
-#define GLSL_VEC_SWIZZLING 1
-#endif
-
-#ifndef GLSL_VEC_XYZW
-#define GLSL_VEC_XYZW 1
-#endif
-
-#ifndef GLSL_VEC_RGBA
-#define GLSL_VEC_RGBA 1
-#endif
-
-#ifndef GLSL_VEC_STPQ
-#define GLSL_VEC_STPQ 1
-#endif
-
+#include "details/config.h"
 #include "vector.h"
+#include "batch.h"
 #include "vector_functions.h"
+#include "integer_functions.h"
 #include "matrix.h"
 #include "matrix_functions.h"
+#include "transform.h"
+#include "quaternion.h"
+#include "packing.h"
+#include "half.h"
+#include "noise.h"
+#include "quad.h"
+#include "fragment.h"
+#include "texture.h"
+#include "precision.h"
 
 namespace glsl {
 
@@ -31,6 +27,10 @@ using ivec2 = glsl::Vector<int, 2>;
 using ivec3 = glsl::Vector<int, 3>;
 using ivec4 = glsl::Vector<int, 4>;
 
+using uvec2 = glsl::Vector<unsigned, 2>;
+using uvec3 = glsl::Vector<unsigned, 3>;
+using uvec4 = glsl::Vector<unsigned, 4>;
+
 using vec2 = glsl::Vector<float, 2>;
 using vec3 = glsl::Vector<float, 3>;
 using vec4 = glsl::Vector<float, 4>;
@@ -49,4 +49,87 @@ using mat2 = mat2x2;
 using mat3 = mat3x3;
 using mat4 = mat4x4;
 
+using dvec2 = glsl::Vector<double, 2>;
+using dvec3 = glsl::Vector<double, 3>;
+using dvec4 = glsl::Vector<double, 4>;
+
+using dmat2x2 = glsl::Matrix<double, 2, 2>;
+using dmat2x3 = glsl::Matrix<double, 2, 3>;
+using dmat2x4 = glsl::Matrix<double, 2, 4>;
+using dmat3x2 = glsl::Matrix<double, 3, 2>;
+using dmat3x3 = glsl::Matrix<double, 3, 3>;
+using dmat3x4 = glsl::Matrix<double, 3, 4>;
+using dmat4x2 = glsl::Matrix<double, 4, 2>;
+using dmat4x3 = glsl::Matrix<double, 4, 3>;
+using dmat4x4 = glsl::Matrix<double, 4, 4>;
+
+using dmat2 = dmat2x2;
+using dmat3 = dmat3x3;
+using dmat4 = dmat4x4;
+
+using hvec2 = glsl::Vector<half, 2>;
+using hvec3 = glsl::Vector<half, 3>;
+using hvec4 = glsl::Vector<half, 4>;
+
+using hmat2 = glsl::Matrix<half, 2, 2>;
+using hmat3 = glsl::Matrix<half, 3, 3>;
+using hmat4 = glsl::Matrix<half, 4, 4>;
+
+using bf16vec2 = glsl::Vector<bfloat16, 2>;
+using bf16vec3 = glsl::Vector<bfloat16, 3>;
+using bf16vec4 = glsl::Vector<bfloat16, 4>;
+
+using quat = glsl::Quaternion<float>;
+using dquat = glsl::Quaternion<double>;
+
+namespace highp {
+
+using glsl::ivec2, glsl::ivec3, glsl::ivec4;
+using glsl::uvec2, glsl::uvec3, glsl::uvec4;
+using glsl::vec2, glsl::vec3, glsl::vec4;
+using glsl::mat2, glsl::mat3, glsl::mat4;
+using glsl::quat;
+
+} // namespace highp
+
+namespace mediump {
+
+using ivec2 = glsl::Vector<int, 2, MediumpVectorTrait>;
+using ivec3 = glsl::Vector<int, 3, MediumpVectorTrait>;
+using ivec4 = glsl::Vector<int, 4, MediumpVectorTrait>;
+
+using uvec2 = glsl::Vector<unsigned, 2, MediumpVectorTrait>;
+using uvec3 = glsl::Vector<unsigned, 3, MediumpVectorTrait>;
+using uvec4 = glsl::Vector<unsigned, 4, MediumpVectorTrait>;
+
+using vec2 = glsl::Vector<float, 2, MediumpVectorTrait>;
+using vec3 = glsl::Vector<float, 3, MediumpVectorTrait>;
+using vec4 = glsl::Vector<float, 4, MediumpVectorTrait>;
+
+using mat2 = glsl::Matrix<float, 2, 2, MediumpVectorTrait>;
+using mat3 = glsl::Matrix<float, 3, 3, MediumpVectorTrait>;
+using mat4 = glsl::Matrix<float, 4, 4, MediumpVectorTrait>;
+
+} // namespace mediump
+
+namespace lowp {
+
+using ivec2 = glsl::Vector<int, 2, LowpVectorTrait>;
+using ivec3 = glsl::Vector<int, 3, LowpVectorTrait>;
+using ivec4 = glsl::Vector<int, 4, LowpVectorTrait>;
+
+using uvec2 = glsl::Vector<unsigned, 2, LowpVectorTrait>;
+using uvec3 = glsl::Vector<unsigned, 3, LowpVectorTrait>;
+using uvec4 = glsl::Vector<unsigned, 4, LowpVectorTrait>;
+
+using vec2 = glsl::Vector<float, 2, LowpVectorTrait>;
+using vec3 = glsl::Vector<float, 3, LowpVectorTrait>;
+using vec4 = glsl::Vector<float, 4, LowpVectorTrait>;
+
+using mat2 = glsl::Matrix<float, 2, 2, LowpVectorTrait>;
+using mat3 = glsl::Matrix<float, 3, 3, LowpVectorTrait>;
+using mat4 = glsl::Matrix<float, 4, 4, LowpVectorTrait>;
+
+} // namespace lowp
+
 } // namespace glsl
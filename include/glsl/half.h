@@ -0,0 +1,274 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include "vector.h"
+#include "packing.h"
+#include "details/soa.h"
+#include "details/vmath.h"
+#include "details/half_kernels.h"
+
+namespace glsl {
+
+namespace details::narrow {
+
+using vmath::bitcast, vmath::int_t, vmath::rebind_t;
+
+/**
+ * The 16-bit floating point formats: the float to bits conversion and back, written once for scalars and
+ * simd::Packet registers (bits in the low half of an int32_t lane), and the std::numeric_limits constants.
+ */
+struct Binary16 {
+    static constexpr int digits = 11, digits10 = 3, max_digits10 = 5;
+    static constexpr int min_exponent = -13, min_exponent10 = -4;
+    static constexpr int max_exponent = 16, max_exponent10 = 4;
+    static constexpr bool iec559 = true;
+
+    static constexpr uint16_t min = 0x0400, max = 0x7bff, epsilon = 0x1400, infinity = 0x7c00, quiet_NaN = 0x7e00;
+
+    template<class S> static constexpr int_t<S> narrow(const S& x) { return packing::half(x); }
+    template<class I> static constexpr rebind_t<I, float> widen(const I& h) { return packing::unhalf(h); }
+};
+
+// The upper half of a float, rounded to nearest even.
+struct BFloat16 {
+    static constexpr int digits = 8, digits10 = 2, max_digits10 = 4;
+    static constexpr int min_exponent = -125, min_exponent10 = -37;
+    static constexpr int max_exponent = 128, max_exponent10 = 38;
+    static constexpr bool iec559 = false;
+
+    static constexpr uint16_t min = 0x0080, max = 0x7f7f, epsilon = 0x3c00, infinity = 0x7f80, quiet_NaN = 0x7fc0;
+
+    template<class S>
+    static constexpr int_t<S> narrow(const S& x) {
+        using I = int_t<S>;
+        I bits = bitcast<int32_t>(x);
+        I nan = ((bits >> 16) & I(0x8000)) | I(quiet_NaN);
+        // A carry out of the mantissa rounds up the exponent, up to infinity. NaNs are kept out of the sum.
+        bits = select(x != x, I(0), bits);
+        I rounded = ((bits + I(0x7fff) + ((bits >> 16) & I(1))) >> 16) & I(0xffff);
+        return select(x != x, nan, rounded);
+    }
+
+    template<class I>
+    static constexpr rebind_t<I, float> widen(const I& h) {
+        return bitcast<float>(I(h << 16));
+    }
+};
+
+template<class Format>
+void narrow(const float* in, uint16_t* out, size_t count) {
+    size_t i = 0;
+#if GLSL_DISPATCH
+    if constexpr (std::same_as<Format, Binary16>) {
+        if (active_isa() != Isa::sse2)
+            i = avx2::narrow_half(in, out, count);
+    }
+#endif
+    soa::for_each_block<float>(count - i, [&]<class S>(size_t k) {
+        if constexpr (std::is_arithmetic_v<S>) {
+            out[i + k] = uint16_t(Format::narrow(in[i + k]));
+        } else {
+            Format::narrow(S::load(in + i + k)).store(out + i + k);
+        }
+    });
+}
+
+template<class Format>
+void widen(const uint16_t* in, float* out, size_t count) {
+    size_t i = 0;
+#if GLSL_DISPATCH
+    if constexpr (std::same_as<Format, Binary16>) {
+        if (active_isa() != Isa::sse2)
+            i = avx2::widen_half(in, out, count);
+    }
+#endif
+    soa::for_each_block<float>(count - i, [&]<class S>(size_t k) {
+        if constexpr (std::is_arithmetic_v<S>) {
+            out[i + k] = Format::widen(int32_t(in[i + k]));
+        } else {
+            Format::widen(int_t<S>::load(in + i + k)).store(out + i + k);
+        }
+    });
+}
+
+// The float scalar or vector of T.
+template<class T>
+struct widened {
+    using type = float;
+};
+
+template<concepts::Vector T>
+struct widened<T> {
+    using type = traits::vector_of_t<T, float>;
+};
+
+template<class T>
+using widened_t = typename widened<T>::type;
+
+// Scalars and vectors without padding, a span of them is a span of their components.
+template<class T>
+constexpr bool dense = sizeof(T) == traits::vector_trait<T>::size * sizeof(traits::vector_item_t<T>);
+
+// The first component of the first element; a Float16 is its uint16_t bits.
+template<class S, class T>
+S* first(T* p) {
+    if constexpr (concepts::Vector<T>) {
+        return reinterpret_cast<S*>(&p->data[0]);
+    } else {
+        return reinterpret_cast<S*>(p);
+    }
+}
+
+/**
+ * 2-byte floating point storage scalar: converts from any arithmetic value, rounding to nearest even, and
+ * to float, which is what arithmetic on it runs in (half + half is a float). Compound assignment and the
+ * builtins of Vector<half, N> and Matrix<half, C, R> compute in float and round the result back per lane,
+ * dot and length return the float. Declared in details so the builtins are not found for it by ADL, the
+ * <cmath> functions of float are the better match.
+ */
+template<class Format>
+struct Float16 {
+    using WidenedType = float;
+    using FormatType = Format;
+
+    uint16_t bits;
+
+    constexpr Float16() = default;
+
+    template<class T> requires std::is_arithmetic_v<T>
+    constexpr Float16(T x) : bits(uint16_t(Format::narrow(float(x)))) {}
+
+    static constexpr Float16 fromBits(uint16_t b) {
+        Float16 result;
+        result.bits = b;
+        return result;
+    }
+
+    constexpr operator float() const {
+        return Format::widen(int32_t(bits));
+    }
+
+    template<class T> requires std::is_arithmetic_v<T> || std::same_as<T, Float16>
+    constexpr Float16& operator+=(const T& x) {
+        return *this = Float16(float(*this) + float(x));
+    }
+
+    template<class T> requires std::is_arithmetic_v<T> || std::same_as<T, Float16>
+    constexpr Float16& operator-=(const T& x) {
+        return *this = Float16(float(*this) - float(x));
+    }
+
+    template<class T> requires std::is_arithmetic_v<T> || std::same_as<T, Float16>
+    constexpr Float16& operator*=(const T& x) {
+        return *this = Float16(float(*this) * float(x));
+    }
+
+    template<class T> requires std::is_arithmetic_v<T> || std::same_as<T, Float16>
+    constexpr Float16& operator/=(const T& x) {
+        return *this = Float16(float(*this) / float(x));
+    }
+};
+
+} // namespace details::narrow
+
+/**
+ * IEEE 754 binary16: 10 mantissa bits, 5 exponent bits, finite up to 65504.
+ */
+using half = details::narrow::Float16<details::narrow::Binary16>;
+
+/**
+ * bfloat16: the upper half of a float, 7 mantissa bits and the full float exponent range.
+ */
+using bfloat16 = details::narrow::Float16<details::narrow::BFloat16>;
+
+/**
+ * Converts spans of floats or float vectors to half or bfloat16 ones (T), and back: narrow<hvec3>(normals, out).
+ * Binary16 runs on F16C registers where the CPU has them, both formats on simd::Packet kernels otherwise.
+ */
+template<class T> requires concepts::Widening<traits::vector_item_t<T>>
+void narrow(std::type_identity_t<std::span<const details::narrow::widened_t<T>>> in,
+            std::type_identity_t<std::span<T>> out) {
+    assert(out.size() >= in.size());
+
+    using Wide = details::narrow::widened_t<T>;
+    using Format = typename traits::vector_item_t<T>::FormatType;
+    constexpr size_t N = traits::vector_trait<T>::size;
+
+    if constexpr (details::narrow::dense<T> && details::narrow::dense<Wide>) {
+        if (!in.empty()) {
+            details::narrow::narrow<Format>(details::narrow::first<const float>(in.data()),
+                                            details::narrow::first<uint16_t>(out.data()), in.size() * N);
+        }
+    } else {
+        for (size_t i = 0; i < in.size(); ++i)
+            out[i] = T(in[i]);
+    }
+}
+
+template<class T> requires concepts::Widening<traits::vector_item_t<T>>
+void widen(std::type_identity_t<std::span<const T>> in,
+           std::type_identity_t<std::span<details::narrow::widened_t<T>>> out) {
+    assert(out.size() >= in.size());
+
+    using Wide = details::narrow::widened_t<T>;
+    using Format = typename traits::vector_item_t<T>::FormatType;
+    constexpr size_t N = traits::vector_trait<T>::size;
+
+    if constexpr (details::narrow::dense<T> && details::narrow::dense<Wide>) {
+        if (!in.empty()) {
+            details::narrow::widen<Format>(details::narrow::first<const uint16_t>(in.data()),
+                                           details::narrow::first<float>(out.data()), in.size() * N);
+        }
+    } else {
+        for (size_t i = 0; i < in.size(); ++i)
+            out[i] = Wide(in[i]);
+    }
+}
+
+} // namespace glsl
+
+template<class Format>
+struct std::numeric_limits<glsl::details::narrow::Float16<Format>> {
+private:
+    using T = glsl::details::narrow::Float16<Format>;
+
+    static constexpr T bits(uint16_t b) { return T::fromBits(b); }
+
+public:
+    static constexpr bool is_specialized = true;
+    static constexpr bool is_signed = true;
+    static constexpr bool is_integer = false;
+    static constexpr bool is_exact = false;
+    static constexpr bool has_infinity = true;
+    static constexpr bool has_quiet_NaN = true;
+    static constexpr bool has_signaling_NaN = false;
+    static constexpr float_denorm_style has_denorm = denorm_present;
+    static constexpr bool has_denorm_loss = false;
+    static constexpr float_round_style round_style = round_to_nearest;
+    static constexpr bool is_iec559 = Format::iec559;
+    static constexpr bool is_bounded = true;
+    static constexpr bool is_modulo = false;
+    static constexpr int digits = Format::digits;
+    static constexpr int digits10 = Format::digits10;
+    static constexpr int max_digits10 = Format::max_digits10;
+    static constexpr int radix = 2;
+    static constexpr int min_exponent = Format::min_exponent;
+    static constexpr int min_exponent10 = Format::min_exponent10;
+    static constexpr int max_exponent = Format::max_exponent;
+    static constexpr int max_exponent10 = Format::max_exponent10;
+    static constexpr bool traps = false;
+    static constexpr bool tinyness_before = false;
+
+    static constexpr T min() noexcept { return bits(Format::min); }
+    static constexpr T max() noexcept { return bits(Format::max); }
+    static constexpr T lowest() noexcept { return bits(Format::max | 0x8000); }
+    static constexpr T epsilon() noexcept { return bits(Format::epsilon); }
+    static constexpr T round_error() noexcept { return T(0.5f); }
+    static constexpr T infinity() noexcept { return bits(Format::infinity); }
+    static constexpr T quiet_NaN() noexcept { return bits(Format::quiet_NaN); }
+    static constexpr T signaling_NaN() noexcept { return bits(Format::quiet_NaN); }
+    static constexpr T denorm_min() noexcept { return bits(0x0001); }
+};
@@ -0,0 +1,260 @@
+#pragma once
+
+#include <bit>
+#include <climits>
+#include <cstdint>
+#include <type_traits>
+#include "details/utils.h"
+#include "vector.h"
+
+namespace glsl {
+
+/**
+ * GLSL integer builtins on integral scalars and vectors. The scalar kernels are branch-free <bit> operations,
+ * so they compile to popcnt, tzcnt, lzcnt (bsr) and a single widening multiply (mulx with BMI2) where the
+ * build targets them, and the lane loops of vectors are left to the vectorizer. Bit numbers are int, as in GLSL:
+ * bitCount(uvec3) is an ivec3.
+ */
+namespace details::integer {
+
+template<class T>
+using unsigned_t = std::make_unsigned_t<T>;
+
+template<class T>
+constexpr int bits = int(sizeof(T) * CHAR_BIT);
+
+// Operands narrower than 32 bits are counted in 32-bit registers.
+template<class T>
+using register_t = std::conditional_t<(sizeof(T) <= 4), uint32_t, uint64_t>;
+
+template<class T>
+constexpr int popcount(T x) {
+    using U = register_t<T>;
+    U v = U(unsigned_t<T>(x));
+#if defined(__POPCNT__) || !(defined(__x86_64__) || defined(__i386__))
+    return std::popcount(v);
+#else
+    // Without popcnt std::popcount is a libgcc call, the SWAR count is as fast inline.
+    v = v - ((v >> 1) & U(0x5555555555555555u));
+    v = (v & U(0x3333333333333333u)) + ((v >> 2) & U(0x3333333333333333u));
+    v = (v + (v >> 4)) & U(0x0f0f0f0f0f0f0f0fu);
+    return int((v * U(0x0101010101010101u)) >> (bits<U> - 8));
+#endif
+}
+
+template<class T>
+constexpr int findLSB(T value) {
+    return value == 0 ? -1 : std::countr_zero(unsigned_t<T>(value));
+}
+
+// The most significant bit that differs from the sign bit.
+template<class T>
+constexpr int findMSB(T value) {
+    unsigned_t<T> u = unsigned_t<T>(value);
+    if constexpr (std::is_signed_v<T>)
+        u = value < 0 ? unsigned_t<T>(~u) : u;
+    return int(std::bit_width(u)) - 1;
+}
+
+template<class T>
+constexpr unsigned_t<T> mask(int count) {
+    return count >= bits<T> ? unsigned_t<T>(~unsigned_t<T>(0)) : unsigned_t<T>((unsigned_t<T>(1) << count) - 1u);
+}
+
+// Signed values are sign-extended from the top bit of the field. An empty field may sit at offset 32: the
+// offset is reduced modulo the width so the shift stays defined, and the empty mask clears whatever it shifted.
+template<class T>
+constexpr T bitfieldExtract(T value, int offset, int count) {
+    unsigned_t<T> m = mask<T>(count);
+    unsigned_t<T> field = unsigned_t<T>(unsigned_t<T>(value) >> (offset & (bits<T> - 1))) & m;
+    if constexpr (std::is_signed_v<T>) {
+        unsigned_t<T> sign = unsigned_t<T>(m & ~(m >> 1));
+        return T(unsigned_t<T>((field ^ sign) - sign));
+    } else {
+        return T(field);
+    }
+}
+
+template<class T>
+constexpr T bitfieldInsert(T base, T insert, int offset, int count) {
+    int shift = offset & (bits<T> - 1);
+    unsigned_t<T> m = unsigned_t<T>(mask<T>(count) << shift);
+    return T(unsigned_t<T>((unsigned_t<T>(base) & unsigned_t<T>(~m)) | (unsigned_t<T>(unsigned_t<T>(insert) << shift) & m)));
+}
+
+// Swaps halves, then quarters and so on down to single bits; the byte steps compile to bswap.
+template<class T>
+constexpr T bitfieldReverse(T value) {
+    using U = unsigned_t<T>;
+    constexpr int steps = std::countr_zero(unsigned(bits<U>));
+    U v = U(value);
+    static_foreach<0, steps>([&](size_t k) {
+        int s = bits<U> >> (k + 1);
+        // Low s bits of every group of 2s.
+        U m = U(U(~U(0)) / U(U(U(1) << s) | 1u));
+        v = U(((v >> s) & m) | U((v & m) << s));
+    });
+    return T(v);
+}
+
+// The carry out of the top bit is the majority of the top bits of x, y and not the sum.
+template<class T>
+constexpr T uaddCarry(T x, T y, T& carry) {
+    T sum = T(x + y);
+    carry = T(T((x & y) | ((x | y) & T(~sum))) >> (bits<T> - 1));
+    return sum;
+}
+
+template<class T>
+constexpr T usubBorrow(T x, T y, T& borrow) {
+    T difference = T(x - y);
+    borrow = T(T((T(~x) & y) | (T(T(~x) | y) & difference)) >> (bits<T> - 1));
+    return difference;
+}
+
+// The full product in one register twice as wide.
+template<class T>
+constexpr void mulExtended(T x, T y, T& msb, T& lsb) {
+    using Wide = std::conditional_t<std::is_signed_v<T>, int64_t, uint64_t>;
+    Wide product = Wide(x) * Wide(y);
+    msb = T(product >> bits<T>);
+    lsb = T(product);
+}
+
+} // namespace details::integer
+
+namespace concepts {
+
+template<typename T>
+concept IntegerVector = Vector<T> && std::integral<traits::vector_item_t<T>> &&
+                        !std::same_as<traits::vector_item_t<T>, bool>;
+
+template<typename T>
+concept UnsignedVector = IntegerVector<T> && std::unsigned_integral<traits::vector_item_t<T>>;
+
+} // namespace concepts
+
+template<std::integral T>
+constexpr int bitCount(T value) {
+    return details::integer::popcount(value);
+}
+
+template<concepts::IntegerVector T>
+constexpr auto bitCount(const T& value) {
+    return details::apply([](auto v) { return details::integer::popcount(v); }, value);
+}
+
+template<std::integral T>
+constexpr int findLSB(T value) {
+    return details::integer::findLSB(value);
+}
+
+template<concepts::IntegerVector T>
+constexpr auto findLSB(const T& value) {
+    return details::apply([](auto v) { return details::integer::findLSB(v); }, value);
+}
+
+template<std::integral T>
+constexpr int findMSB(T value) {
+    return details::integer::findMSB(value);
+}
+
+template<concepts::IntegerVector T>
+constexpr auto findMSB(const T& value) {
+    return details::apply([](auto v) { return details::integer::findMSB(v); }, value);
+}
+
+template<std::integral T>
+constexpr T bitfieldExtract(T value, int offset, int bits) {
+    return details::integer::bitfieldExtract(value, offset, bits);
+}
+
+template<concepts::IntegerVector T>
+constexpr auto bitfieldExtract(const T& value, int offset, int bits) {
+    return details::apply([=](auto v) { return details::integer::bitfieldExtract(v, offset, bits); }, value);
+}
+
+template<std::integral T>
+constexpr T bitfieldInsert(T base, T insert, int offset, int bits) {
+    return details::integer::bitfieldInsert(base, insert, offset, bits);
+}
+
+template<concepts::IntegerVector T>
+constexpr auto bitfieldInsert(const T& base, const T& insert, int offset, int bits) {
+    return details::apply([=](auto b, auto i) { return details::integer::bitfieldInsert(b, i, offset, bits); }, base, insert);
+}
+
+template<std::integral T>
+constexpr T bitfieldReverse(T value) {
+    return details::integer::bitfieldReverse(value);
+}
+
+template<concepts::IntegerVector T>
+constexpr auto bitfieldReverse(const T& value) {
+    return details::apply([](auto v) { return details::integer::bitfieldReverse(v); }, value);
+}
+
+template<std::unsigned_integral T>
+constexpr T uaddCarry(T x, T y, T& carry) {
+    return details::integer::uaddCarry(x, y, carry);
+}
+
+template<concepts::UnsignedVector T>
+constexpr T uaddCarry(const T& x, const T& y, T& carry) {
+    // Computed in locals, the out vector may alias an operand.
+    T result, out;
+    details::vector_foreach<T>([&](size_t i) {
+        result[i] = details::integer::uaddCarry(x[i], y[i], out[i]);
+    });
+    carry = out;
+    return result;
+}
+
+template<std::unsigned_integral T>
+constexpr T usubBorrow(T x, T y, T& borrow) {
+    return details::integer::usubBorrow(x, y, borrow);
+}
+
+template<concepts::UnsignedVector T>
+constexpr T usubBorrow(const T& x, const T& y, T& borrow) {
+    // Computed in locals, the out vector may alias an operand.
+    T result, out;
+    details::vector_foreach<T>([&](size_t i) {
+        result[i] = details::integer::usubBorrow(x[i], y[i], out[i]);
+    });
+    borrow = out;
+    return result;
+}
+
+template<std::unsigned_integral T> requires (sizeof(T) <= 4)
+constexpr void umulExtended(T x, T y, T& msb, T& lsb) {
+    details::integer::mulExtended(x, y, msb, lsb);
+}
+
+template<concepts::UnsignedVector T> requires (sizeof(traits::vector_item_t<T>) <= 4)
+constexpr void umulExtended(const T& x, const T& y, T& msb, T& lsb) {
+    T high, low;
+    details::vector_foreach<T>([&](size_t i) {
+        details::integer::mulExtended(x[i], y[i], high[i], low[i]);
+    });
+    msb = high;
+    lsb = low;
+}
+
+template<std::signed_integral T> requires (sizeof(T) <= 4)
+constexpr void imulExtended(T x, T y, T& msb, T& lsb) {
+    details::integer::mulExtended(x, y, msb, lsb);
+}
+
+template<concepts::IntegerVector T> requires std::signed_integral<traits::vector_item_t<T>> &&
+                                             (sizeof(traits::vector_item_t<T>) <= 4)
+constexpr void imulExtended(const T& x, const T& y, T& msb, T& lsb) {
+    T high, low;
+    details::vector_foreach<T>([&](size_t i) {
+        details::integer::mulExtended(x[i], y[i], high[i], low[i]);
+    });
+    msb = high;
+    lsb = low;
+}
+
+} // namespace glsl
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "vector.h"
+#include "details/matrix_product.h"
 
 namespace glsl {
 
@@ -97,7 +98,7 @@ public: // OPERATORS
     }
 
     template<class T>
-    requires (std::same_as<T, Matrix> || std::convertible_to<T, Scalar>)
+    requires (std::convertible_to<T, Scalar>)
     constexpr Matrix& operator*=(const T& v) {
         foreachColumn([&](auto i) {
             column(i) *= take(v, i);
@@ -105,6 +106,11 @@ public: // OPERATORS
         return *this;
     }
 
+    constexpr Matrix& operator*=(const Matrix& v)
+    requires (N == M) {
+        return *this = *this * v;
+    }
+
     template<class T>
     requires (std::same_as<T, Matrix> || std::convertible_to<T, Scalar>)
     constexpr Matrix& operator/=(const T& v) {
@@ -167,7 +173,7 @@ public: // OPERATORS
     }
 
     template<class T>
-    requires (std::same_as<T, Matrix> || std::convertible_to<T, Scalar>)
+    requires (std::convertible_to<T, Scalar>)
     friend constexpr Matrix operator*(const Matrix& v1, const T& v2) {
         return Matrix(v1) *= v2;
     }
@@ -203,9 +209,16 @@ public: // OPERATORS
     }
 
     friend constexpr ColumnType operator*(const Matrix& m1, const RowType& m2) {
-        ColumnType result;
-        details::static_foreach<0, N>([&](size_t row) {
-            result[row] = dot(m1.row(row), m2);
+        if constexpr (PackedColumns) {
+            if (!std::is_constant_evaluated()) {
+                ColumnType result;
+                Register::storeu(&result.data[0], m1.combine(m2));
+                return result;
+            }
+        }
+        ColumnType result = m1.column(0) * m2[0];
+        details::static_foreach<1, M>([&](size_t col) {
+            result += m1.column(col) * m2[col];
         });
         return result;
     }
@@ -218,9 +231,25 @@ public: // OPERATORS
         return result;
     }
 
-    template<size_t OtherM> requires (OtherM != M)
-    friend constexpr auto operator*(const Matrix& m1, const Matrix<Scalar, M, OtherM, Trait>& m2) {
+    // With GLSL_EXPR_TEMPLATES products of matrices are MatrixProduct chains, see details/matrix_product.h.
+    template<size_t OtherM>
+    friend constexpr auto operator*(const Matrix& m1, const Matrix<Scalar, M, OtherM, Trait>& m2)
+    requires (!details::product::lazy) {
+        return product(m1, m2);
+    }
+
+    // Eager linear algebra product, what chains are evaluated with.
+    template<size_t OtherM>
+    static constexpr auto product(const Matrix& m1, const Matrix<Scalar, M, OtherM, Trait>& m2) {
         Matrix<Scalar, N, OtherM, Trait> result;
+        if constexpr (N == 2 && M == 2 && OtherM == 2 && std::same_as<Scalar, float> &&
+                      sizeof(Matrix) == 4 * sizeof(Scalar) && details::simd::Register<Scalar, 4>::supported) {
+            if (!std::is_constant_evaluated()) {
+                using Reg = details::simd::Register<Scalar, 4>;
+                Reg::storeu(&result[0].data[0], Reg::mul2x2(Reg::loadu(&m1[0].data[0]), Reg::loadu(&m2[0].data[0])));
+                return result;
+            }
+        }
         details::static_foreach<0, OtherM>([&](size_t col) {
             result.column(col) = m1 * m2.column(col);
         });
@@ -320,6 +349,19 @@ public: // UTILS
 private:
     typename VectorTrait<ColumnType, M>::DataType data;
 
+    using Register = details::simd::RegisterFor<Scalar, N>;
+
+    // Columns are one whole register each, so products run as broadcast + multiply-add over columns.
+    static constexpr bool PackedColumns = Register::supported && sizeof(ColumnType) == Register::lanes * sizeof(Scalar);
+
+    auto combine(const RowType& weights) const requires PackedColumns {
+        auto result = Register::mul(Register::loadu(&column(0).data[0]), Register::set1(weights[0]));
+        details::static_foreach<1, M>([&](size_t col) {
+            result = Register::fmadd(Register::loadu(&column(col).data[0]), Register::set1(weights[col]), result);
+        });
+        return result;
+    }
+
     template<size_t Off, class T, class... Ts>
     constexpr void construct(T&& t, Ts&& ... ts) {
         constexpr size_t Len = traits::vector_size_for<T, ColumnType>();
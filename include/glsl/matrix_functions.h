@@ -1,10 +1,232 @@
 #pragma once
 
+#include <array>
+#include <bit>
 #include <cmath>
+#include <tuple>
+#include <utility>
 #include "matrix.h"
+#include "details/matrix_kernels.h"
 
 namespace glsl {
 
+namespace details::cofactor {
+
+template<class S, size_t Size>
+struct Adjugate {
+    std::array<S, Size> adjugate;
+    S determinant;
+};
+
+/**
+ * Adjugate (transposed cofactors) and determinant of a column-major 3x3 or 4x4 matrix given by its components,
+ * a[col * rows + row]. S is a scalar, a Batch or a simd::Packet of as many matrices.
+ */
+template<class S>
+[[gnu::always_inline]] constexpr Adjugate<S, 9> adjugate(const std::array<S, 9>& a) {
+    auto a00 = a[0], a01 = a[1], a02 = a[2];
+    auto a10 = a[3], a11 = a[4], a12 = a[5];
+    auto a20 = a[6], a21 = a[7], a22 = a[8];
+
+    auto b01 = a22 * a11 - a12 * a21;
+    auto b11 = a12 * a20 - a22 * a10;
+    auto b21 = a21 * a10 - a11 * a20;
+
+    return {
+        { b01, (a02 * a21 - a22 * a01), (a12 * a01 - a02 * a11),
+          b11, (a22 * a00 - a02 * a20), (a02 * a10 - a12 * a00),
+          b21, (a01 * a20 - a21 * a00), (a11 * a00 - a01 * a10) },
+        a00 * b01 + a01 * b11 + a02 * b21
+    };
+}
+
+template<class S>
+[[gnu::always_inline]] constexpr Adjugate<S, 16> adjugate(const std::array<S, 16>& a) {
+    auto a00 = a[0], a01 = a[1], a02 = a[2], a03 = a[3];
+    auto a10 = a[4], a11 = a[5], a12 = a[6], a13 = a[7];
+    auto a20 = a[8], a21 = a[9], a22 = a[10], a23 = a[11];
+    auto a30 = a[12], a31 = a[13], a32 = a[14], a33 = a[15];
+
+    auto b00 = a00 * a11 - a01 * a10;
+    auto b01 = a00 * a12 - a02 * a10;
+    auto b02 = a00 * a13 - a03 * a10;
+    auto b03 = a01 * a12 - a02 * a11;
+    auto b04 = a01 * a13 - a03 * a11;
+    auto b05 = a02 * a13 - a03 * a12;
+    auto b06 = a20 * a31 - a21 * a30;
+    auto b07 = a20 * a32 - a22 * a30;
+    auto b08 = a20 * a33 - a23 * a30;
+    auto b09 = a21 * a32 - a22 * a31;
+    auto b10 = a21 * a33 - a23 * a31;
+    auto b11 = a22 * a33 - a23 * a32;
+
+    auto det = b00 * b11 - b01 * b10 + b02 * b09 + b03 * b08 - b04 * b07 + b05 * b06;
+
+    return {
+        { a11 * b11 - a12 * b10 + a13 * b09,
+          a02 * b10 - a01 * b11 - a03 * b09,
+          a31 * b05 - a32 * b04 + a33 * b03,
+          a22 * b04 - a21 * b05 - a23 * b03,
+          a12 * b08 - a10 * b11 - a13 * b07,
+          a00 * b11 - a02 * b08 + a03 * b07,
+          a32 * b02 - a30 * b05 - a33 * b01,
+          a20 * b05 - a22 * b02 + a23 * b01,
+          a10 * b10 - a11 * b08 + a13 * b06,
+          a01 * b08 - a00 * b10 - a03 * b06,
+          a30 * b04 - a31 * b02 + a33 * b00,
+          a21 * b02 - a20 * b04 - a23 * b00,
+          a11 * b07 - a10 * b09 - a12 * b06,
+          a00 * b09 - a01 * b07 + a02 * b06,
+          a31 * b01 - a30 * b03 - a32 * b00,
+          a20 * b03 - a21 * b01 + a22 * b00 },
+        det
+    };
+}
+
+template<concepts::MatrixQuad T>
+constexpr auto components(const T& m) {
+    constexpr size_t N = T::MatrixRows;
+    std::array<typename T::MatrixItem, T::MatrixSize> a;
+    static_foreach<0, T::MatrixColumns>([&](size_t col) {
+        static_foreach<0, N>([&](size_t row) {
+            a[col * N + row] = m[col][row];
+        });
+    });
+    return a;
+}
+
+template<concepts::MatrixQuad T, class S>
+constexpr T matrix(const std::array<S, T::MatrixSize>& a) {
+    return std::apply([](const auto&... c) { return T(c...); }, a);
+}
+
+// dmat4 with contiguous columns, whose inverse takes the AVX2 kernel where the CPU has it.
+template<class T>
+constexpr bool wide = std::same_as<typename T::MatrixItem, double> && T::MatrixColumns == 4 &&
+                      sizeof(T) == T::MatrixSize * sizeof(double);
+
+} // namespace details::cofactor
+
+/**
+ * LU factorization with partial pivoting, P m = L U, of a square matrix of scalars. Factor once with
+ * glsl::lu(m), then solve as many systems against m as needed, each in O(M^2) instead of O(M^3).
+ * L (unit diagonal, below it) and U (on and above it) share one matrix; the row pivoted into row i is
+ * pivot[i]. A singular matrix factors with a zero on the diagonal of U, its solutions are not finite.
+ */
+template<concepts::MatrixQuad T>
+struct LU {
+
+    using Item = typename T::MatrixItem;
+    using ColumnType = typename T::ColumnType;
+
+    static constexpr size_t M = T::MatrixColumns;
+
+    T factors;
+    std::array<size_t, M> pivot;
+    bool odd = false;
+
+    constexpr explicit LU(const T& m) : factors(m) {
+        auto magnitude = [](Item x) { return x < Item(0) ? -x : x; };
+
+        for (size_t i = 0; i < M; ++i)
+            pivot[i] = i;
+
+        for (size_t c = 0; c < M; ++c) {
+            size_t p = c;
+            for (size_t r = c + 1; r < M; ++r) {
+                if (magnitude(at(r, c)) > magnitude(at(p, c)))
+                    p = r;
+            }
+            if (p != c) {
+                for (size_t k = 0; k < M; ++k)
+                    std::swap(at(p, k), at(c, k));
+                std::swap(pivot[p], pivot[c]);
+                odd = !odd;
+            }
+
+            Item diagonal = at(c, c);
+            if (diagonal == Item(0))
+                continue;
+
+            for (size_t r = c + 1; r < M; ++r)
+                at(r, c) /= diagonal;
+
+            // Columns are contiguous, so the trailing update runs down each column.
+            for (size_t k = c + 1; k < M; ++k) {
+                Item u = at(c, k);
+                for (size_t r = c + 1; r < M; ++r)
+                    at(r, k) -= at(r, c) * u;
+            }
+        }
+    }
+
+    constexpr bool singular() const {
+        for (size_t i = 0; i < M; ++i) {
+            if (at(i, i) == Item(0))
+                return true;
+        }
+        return false;
+    }
+
+    constexpr Item determinant() const {
+        Item det(odd ? -1 : 1);
+        for (size_t i = 0; i < M; ++i)
+            det *= at(i, i);
+        return det;
+    }
+
+    /**
+     * x with m x = b.
+     */
+    constexpr ColumnType solve(const ColumnType& b) const {
+        ColumnType x;
+        for (size_t i = 0; i < M; ++i)
+            x[i] = b[pivot[i]];
+
+        for (size_t j = 0; j < M; ++j) {
+            for (size_t i = j + 1; i < M; ++i)
+                x[i] -= at(i, j) * x[j];
+        }
+        for (size_t j = M; j-- > 0;) {
+            x[j] /= at(j, j);
+            for (size_t i = 0; i < j; ++i)
+                x[i] -= at(i, j) * x[j];
+        }
+        return x;
+    }
+
+    /**
+     * X with m X = b, column by column.
+     */
+    template<concepts::Matrix B> requires (B::MatrixRows == M)
+    constexpr B solve(const B& b) const {
+        B x;
+        B::foreachColumn([&](size_t i) {
+            x[i] = solve(b[i]);
+        });
+        return x;
+    }
+
+    constexpr T inverse() const {
+        return solve(T(1));
+    }
+
+private:
+
+    constexpr decltype(auto) at(size_t row, size_t col) {
+        return factors[col][row];
+    }
+
+    constexpr Item at(size_t row, size_t col) const {
+        return factors[col][row];
+    }
+};
+
+template<concepts::MatrixQuad T>
+constexpr LU<T> lu(const T& m) {
+    return LU<T>(m);
+}
+
 template<concepts::MatrixQuad T>
 constexpr auto determinant(const T& m) {
     constexpr size_t M = T::MatrixColumns;
@@ -17,6 +239,11 @@ constexpr auto determinant(const T& m) {
         return m[0][0] * m[1][1] * m[2][2] - m[0][0] * m[1][2] * m[2][1] -
                m[0][1] * m[1][0] * m[2][2] + m[0][1] * m[1][2] * m[2][0] +
                m[0][2] * m[1][0] * m[2][1] - m[0][2] * m[1][1] * m[2][0];
+    } else if constexpr (M == 4) {
+        // The closed form has no divisions, so no NaN on a zero pivot either.
+        return details::cofactor::adjugate(details::cofactor::components(m)).determinant;
+    } else if constexpr (std::is_arithmetic_v<typename T::MatrixItem>) {
+        return lu(m).determinant();
     } else {
         typename T::MatrixItem det(1);
         T temp(m);
@@ -51,6 +278,24 @@ constexpr auto transpose(const T& m) {
     }
 }
 
+template<concepts::Matrix T>
+constexpr T matrixCompMult(const T& x, const T& y) {
+    T result;
+    T::foreachColumn([&](auto i) {
+        result[i] = x[i] * y[i];
+    });
+    return result;
+}
+
+template<concepts::Matrix T>
+constexpr T fma(const T& a, const T& b, const T& c) {
+    T result;
+    T::foreachColumn([&](auto i) {
+        result[i] = glsl::fma(a[i], b[i], c[i]);
+    });
+    return result;
+}
+
 template<concepts::MatrixQuadN<1> T>
 constexpr auto inverse(const T& m) {
     return T(1 / determinant(m));
@@ -63,59 +308,29 @@ constexpr auto inverse(const T& m) {
 
 template<concepts::MatrixQuadN<3> T>
 constexpr auto inverse(const T& m) {
-    auto a00 = m[0][0], a01 = m[0][1], a02 = m[0][2];
-    auto a10 = m[1][0], a11 = m[1][1], a12 = m[1][2];
-    auto a20 = m[2][0], a21 = m[2][1], a22 = m[2][2];
-
-    auto b01 = a22 * a11 - a12 * a21;
-    auto b11 = a12 * a20 - a22 * a10;
-    auto b21 = a21 * a10 - a11 * a20;
-
-    auto det = a00 * b01 + a01 * b11 + a02 * b21;
-
-    return T(b01, (a02 * a21 - a22 * a01), (a12 * a01 - a02 * a11),
-             b11, (a22 * a00 - a02 * a20), (a02 * a10 - a12 * a00),
-             b21, (a01 * a20 - a21 * a00), (a11 * a00 - a01 * a10)) / det;
+    auto [adjugate, det] = details::cofactor::adjugate(details::cofactor::components(m));
+    return details::cofactor::matrix<T>(adjugate) / det;
 }
 
 template<concepts::MatrixQuadN<4> T>
 constexpr auto inverse(const T& m) {
-    auto a00 = m[0][0], a01 = m[0][1], a02 = m[0][2], a03 = m[0][3];
-    auto a10 = m[1][0], a11 = m[1][1], a12 = m[1][2], a13 = m[1][3];
-    auto a20 = m[2][0], a21 = m[2][1], a22 = m[2][2], a23 = m[2][3];
-    auto a30 = m[3][0], a31 = m[3][1], a32 = m[3][2], a33 = m[3][3];
-
-    auto b00 = a00 * a11 - a01 * a10;
-    auto b01 = a00 * a12 - a02 * a10;
-    auto b02 = a00 * a13 - a03 * a10;
-    auto b03 = a01 * a12 - a02 * a11;
-    auto b04 = a01 * a13 - a03 * a11;
-    auto b05 = a02 * a13 - a03 * a12;
-    auto b06 = a20 * a31 - a21 * a30;
-    auto b07 = a20 * a32 - a22 * a30;
-    auto b08 = a20 * a33 - a23 * a30;
-    auto b09 = a21 * a32 - a22 * a31;
-    auto b10 = a21 * a33 - a23 * a31;
-    auto b11 = a22 * a33 - a23 * a32;
-
-    auto det = b00 * b11 - b01 * b10 + b02 * b09 + b03 * b08 - b04 * b07 + b05 * b06;
+#if GLSL_DISPATCH
+    if constexpr (details::cofactor::wide<T>) {
+        if (!std::is_constant_evaluated() && active_isa() != Isa::sse2) {
+            // Written to an array, a matrix would be zeroed first.
+            std::array<double, 16> result;
+            details::avx2::inverse4(&m[0].data[0], result.data());
+            return std::bit_cast<T>(result);
+        }
+    }
+#endif
+    auto [adjugate, det] = details::cofactor::adjugate(details::cofactor::components(m));
+    return details::cofactor::matrix<T>(adjugate) / det;
+}
 
-    return T(a11 * b11 - a12 * b10 + a13 * b09,
-             a02 * b10 - a01 * b11 - a03 * b09,
-             a31 * b05 - a32 * b04 + a33 * b03,
-             a22 * b04 - a21 * b05 - a23 * b03,
-             a12 * b08 - a10 * b11 - a13 * b07,
-             a00 * b11 - a02 * b08 + a03 * b07,
-             a32 * b02 - a30 * b05 - a33 * b01,
-             a20 * b05 - a22 * b02 + a23 * b01,
-             a10 * b10 - a11 * b08 + a13 * b06,
-             a01 * b08 - a00 * b10 - a03 * b06,
-             a30 * b04 - a31 * b02 + a33 * b00,
-             a21 * b02 - a20 * b04 - a23 * b00,
-             a11 * b07 - a10 * b09 - a12 * b06,
-             a00 * b09 - a01 * b07 + a02 * b06,
-             a31 * b01 - a30 * b03 - a32 * b00,
-             a20 * b03 - a21 * b01 + a22 * b00) / det;
+template<concepts::MatrixQuad T> requires (T::MatrixColumns > 4)
+constexpr auto inverse(const T& m) {
+    return lu(m).inverse();
 }
 
 } // namespace glsl
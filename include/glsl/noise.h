@@ -0,0 +1,472 @@
+#pragma once
+
+#include <array>
+#include <cassert>
+#include <span>
+#include "vector.h"
+#include "details/parallel.h"
+#include "details/soa.h"
+#include "details/vmath.h"
+
+namespace glsl {
+
+/**
+ * Simplex and Perlin gradient noise on 1 to 4 dimensions, value and analytic gradient, written once for
+ * scalars and simd::Packet registers. The lattice hash is the permutation polynomial (34 x + 10) x mod 289
+ * evaluated in exact float arithmetic (no tables, no integer multiplies), so packet lanes compute the same
+ * bits as scalars and the noise is periodic with period 289 on every axis.
+ */
+namespace details::noise {
+
+// Exact for |x| < 2^22, like the rounding it is built on; the hash needs integers below 2^24 anyway.
+template<class S>
+S floor(const S& x) {
+    S r = vmath::round_nearest(x);
+    return r - select(r > x, S(1), S(0));
+}
+
+// x mod 289 of an integral x, exact while |x| < 2^24; a quotient rounded up or down is corrected.
+template<class S>
+S mod289(const S& x) {
+    S r = x - floor(x * S(1.0 / 289)) * S(289);
+    return r + select(r < S(0), S(289), S(0)) - select(r >= S(289), S(289), S(0));
+}
+
+// A function of x mod 289 only, so lattice coordinates need no wrapping before they are hashed.
+template<class S>
+S permute(const S& x) {
+    return mod289((x * S(34) + S(10)) * x);
+}
+
+/**
+ * Gradient of a hash in [0, 289): (+-1..8) in 1D, otherwise components of +-1 with none or one of them
+ * zero, picked by h mod (N + 1), and the signs from the bits of h / (N + 1).
+ */
+template<size_t N, class S>
+std::array<S, N> gradient(const S& h) {
+    std::array<S, N> g;
+    if constexpr (N == 1) {
+        S q = floor(h * S(0.125));
+        S bit = q - floor(q * S(0.5)) * S(2);
+        g[0] = (S(1) + h - q * S(8)) * (S(1) - S(2) * bit);
+    } else {
+        S q = floor((h + S(0.5)) * S(1.0 / (N + 1)));
+        S zero = h - q * S(double(N + 1));
+        static_foreach<0, N>([&](size_t k) {
+            S half = floor(q * S(0.5));
+            S bit = q - half * S(2);
+            q = half;
+            g[k] = select(zero == S(double(k)), S(0), S(1) - S(2) * bit);
+        });
+    }
+    return g;
+}
+
+template<size_t N, class S>
+S dot(const std::array<S, N>& a, const std::array<S, N>& b) {
+    S sum = a[0] * b[0];
+    static_foreach<1, N>([&](size_t k) {
+        sum = sum + a[k] * b[k];
+    });
+    return sum;
+}
+
+/**
+ * Simplex noise: the lattice skewed by F onto simplices of N + 1 corners (unskewed by G), each corner
+ * contributing (r2 - |d|^2)^4 (g . d) within radius^2 r2. The corners are ordered by the ranks of the
+ * components of the offset into the cell. scale brings the extremes of every dimension just inside [-1, 1].
+ */
+struct Simplex {
+    static constexpr double skew[5] = {0, 0.41421356237309505, 0.36602540378443865, 1.0 / 3, 0.30901699437494742};
+
+    static constexpr double unskew[5] = {0, 0.29289321881345248, 0.21132486540518712, 1.0 / 6, 0.13819660112501051};
+
+    static constexpr double scale[5] = {0, 8.89, 69.8, 22.9, 22.65};
+
+    template<bool Gradient, size_t N, class S>
+    [[gnu::flatten]] static S evaluate(const std::array<S, N>& x, std::array<S, N>& gradient) {
+        constexpr double F = skew[N], G = unskew[N];
+        constexpr double r2 = N <= 2 ? 0.5 : 0.6;
+
+        S s = x[0];
+        static_foreach<1, N>([&](size_t k) {
+            s = s + x[k];
+        });
+        s = s * S(F);
+
+        std::array<S, N> cell, offset, rank;
+        S t(0);
+        static_foreach<0, N>([&](size_t k) {
+            cell[k] = noise::floor(x[k] + s);
+            t = t + cell[k];
+        });
+        t = t * S(G);
+        static_foreach<0, N>([&](size_t k) {
+            offset[k] = x[k] - cell[k] + t;
+            cell[k] = mod289(cell[k]);
+            rank[k] = S(0);
+        });
+        static_foreach<0, N>([&](size_t a) {
+            static_foreach<0, N>([&](size_t b) {
+                if (a < b) {
+                    S greater = select(offset[a] > offset[b], S(1), S(0));
+                    rank[a] = rank[a] + greater;
+                    rank[b] = rank[b] + (S(1) - greater);
+                }
+            });
+        });
+
+        S value(0);
+        if constexpr (Gradient)
+            gradient.fill(S(0));
+
+        // Corner j is one step further along the axes of the j highest ranks.
+        static_foreach<0, N + 1>([&](size_t j) {
+            std::array<S, N> d;
+            S h(0);
+            static_foreach<0, N>([&](size_t k) {
+                S o = select(rank[k] >= S(double(N - j)), S(1), S(0));
+                d[k] = offset[k] - o + S(double(j) * G);
+                h = permute(h + cell[k] + o);
+            });
+            auto g = noise::gradient<N>(h);
+            S r = S(r2) - dot(d, d);
+            r = select(r > S(0), r, S(0));
+            S r_2 = r * r, r_4 = r_2 * r_2, n = dot(g, d);
+            value = value + r_4 * n;
+            if constexpr (Gradient) {
+                S falloff = S(8) * r_2 * r * n;
+                static_foreach<0, N>([&](size_t k) {
+                    gradient[k] = gradient[k] + r_4 * g[k] - falloff * d[k];
+                });
+            }
+        });
+
+        if constexpr (Gradient) {
+            static_foreach<0, N>([&](size_t k) {
+                gradient[k] = gradient[k] * S(scale[N]);
+            });
+        }
+        return value * S(scale[N]);
+    }
+};
+
+/**
+ * Perlin (improved) noise: g . d at the 2^N corners of the cell, blended by the quintic fade
+ * u = f^3 (f (6 f - 15) + 10), zero at the lattice points.
+ */
+struct Perlin {
+    static constexpr double scale[5] = {0, 0.2487, 1.115, 0.866, 0.771};
+
+    template<bool Gradient, size_t N, class S>
+    [[gnu::flatten]] static S evaluate(const std::array<S, N>& x, std::array<S, N>& gradient) {
+        std::array<S, N> cell, f, u, du;
+        static_foreach<0, N>([&](size_t k) {
+            S c = noise::floor(x[k]);
+            f[k] = x[k] - c;
+            cell[k] = mod289(c);
+            u[k] = f[k] * f[k] * f[k] * (f[k] * (f[k] * S(6) - S(15)) + S(10));
+            du[k] = S(30) * f[k] * f[k] * (f[k] * (f[k] - S(2)) + S(1));
+        });
+
+        S value(0);
+        if constexpr (Gradient)
+            gradient.fill(S(0));
+
+        static_foreach<0, (size_t(1) << N)>([&](size_t corner) {
+            std::array<S, N> d, w;
+            S h(0);
+            static_foreach<0, N>([&](size_t k) {
+                bool high = (corner >> k) & 1;
+                d[k] = high ? f[k] - S(1) : f[k];
+                w[k] = high ? u[k] : S(1) - u[k];
+                h = permute(h + cell[k] + S(high ? 1 : 0));
+            });
+            auto g = noise::gradient<N>(h);
+            S n = dot(g, d);
+            S weight = w[0];
+            static_foreach<1, N>([&](size_t k) {
+                weight = weight * w[k];
+            });
+            value = value + weight * n;
+            if constexpr (Gradient) {
+                static_foreach<0, N>([&](size_t k) {
+                    // d weight / dx_k: the fade derivative in place of the factor of axis k.
+                    S dw = ((corner >> k) & 1) ? du[k] : -du[k];
+                    static_foreach<0, N>([&](size_t m) {
+                        if (m != k)
+                            dw = dw * w[m];
+                    });
+                    gradient[k] = gradient[k] + weight * g[k] + n * dw;
+                });
+            }
+        });
+
+        if constexpr (Gradient) {
+            static_foreach<0, N>([&](size_t k) {
+                gradient[k] = gradient[k] * S(scale[N]);
+            });
+        }
+        return value * S(scale[N]);
+    }
+};
+
+template<class T>
+using item_t = traits::vector_item_t<T>;
+
+template<class T>
+constexpr size_t size = traits::vector_trait<T>::size;
+
+template<class T>
+std::array<item_t<T>, size<T>> components(const T& p) {
+    std::array<item_t<T>, size<T>> result;
+    if constexpr (concepts::Vector<T>) {
+        static_foreach<0, size<T>>([&](size_t k) {
+            result[k] = p[k];
+        });
+    } else {
+        result[0] = p;
+    }
+    return result;
+}
+
+template<class T>
+void assign(T& p, const std::array<item_t<T>, size<T>>& c) {
+    if constexpr (concepts::Vector<T>) {
+        static_foreach<0, size<T>>([&](size_t k) {
+            p[k] = c[k];
+        });
+    } else {
+        p = c[0];
+    }
+}
+
+template<class Noise, bool Gradient, class T>
+item_t<T> evaluate(const T& p, T* gradient) {
+    std::array<item_t<T>, size<T>> g;
+    item_t<T> value = Noise::template evaluate<Gradient>(components(p), g);
+    if constexpr (Gradient)
+        assign(*gradient, g);
+    return value;
+}
+
+// The first component of the first element.
+template<class T>
+auto* first(T* p) {
+    if constexpr (concepts::Vector<std::remove_const_t<T>>) {
+        return p ? &p->data[0] : nullptr;
+    } else {
+        return p;
+    }
+}
+
+// Points per thread at least, below that the threads cost more than they save.
+constexpr size_t grain = 4096;
+
+/**
+ * values[i] (and gradients[i] unless empty) of points[i], a packet of points per step, in contiguous
+ * ranges of points across max_threads() threads.
+ */
+template<class Noise, class T>
+void points(std::span<const T> points, std::span<item_t<T>> values, std::span<T> gradients) {
+    assert(values.size() >= points.size() && (gradients.empty() || gradients.size() >= points.size()));
+
+    if (points.empty())
+        return;
+
+    using Item = item_t<T>;
+    constexpr size_t N = size<T>;
+    auto in = soa::stream<N>(first(points.data()), points.data());
+    auto out = soa::stream<1>(values.data(), values.data());
+    auto grad = soa::stream<N>(first(gradients.data()), gradients.data());
+
+    parallel::for_each_chunk(points.size(), grain, [&](size_t begin, size_t end) {
+        soa::for_each_block<Item>(end - begin, [&]<class S>(size_t k) {
+            size_t i = begin + k;
+            std::array<S, N> g;
+            if (gradients.empty()) {
+                out.scatter(i, std::array<S, 1>{Noise::template evaluate<false>(in.template gather<S>(i), g)});
+            } else {
+                out.scatter(i, std::array<S, 1>{Noise::template evaluate<true>(in.template gather<S>(i), g)});
+                grad.scatter(i, g);
+            }
+        });
+    });
+}
+
+// 0, 1, ... in the lanes of S.
+template<class S>
+S iota() {
+    if constexpr (std::is_arithmetic_v<S>) {
+        return S(0);
+    } else {
+        using Item = typename S::BatchItem;
+        alignas(S) std::array<Item, S::BatchWidth> lanes;
+        for (size_t j = 0; j < S::BatchWidth; ++j)
+            lanes[j] = Item(j);
+        return S::load(lanes.data());
+    }
+}
+
+/**
+ * The grid origin + index * step, index < size, x fastest: rows of size.x points, a packet of them per
+ * step with the other coordinates fixed, whole rows per thread.
+ */
+template<class Noise, class T, size_t N>
+void grid(const T& origin, const T& step, const Vector<unsigned, N>& size, std::span<item_t<T>> values,
+          std::span<T> gradients) {
+    using Item = item_t<T>;
+
+    size_t width = size[0], rows = 1;
+    static_foreach<1, N>([&](size_t k) {
+        rows *= size[k];
+    });
+    assert(values.size() >= width * rows && (gradients.empty() || gradients.size() >= width * rows));
+
+    if (width * rows == 0)
+        return;
+
+    auto o = components(origin), d = components(step);
+    auto out = soa::stream<1>(values.data(), values.data());
+    auto grad = soa::stream<N>(first(gradients.data()), gradients.data());
+
+    parallel::for_each_chunk(rows, std::max<size_t>(grain / width, 1), [&](size_t begin, size_t end) {
+        for (size_t row = begin; row < end; ++row) {
+            std::array<Item, N> p;
+            size_t r = row;
+            static_foreach<1, N>([&](size_t k) {
+                p[k] = o[k] + Item(r % size[k]) * d[k];
+                r /= size[k];
+            });
+
+            soa::for_each_block<Item>(width, [&]<class S>(size_t x) {
+                std::array<S, N> c, g;
+                c[0] = S(o[0]) + (iota<S>() + S(Item(x))) * S(d[0]);
+                static_foreach<1, N>([&](size_t k) {
+                    c[k] = S(p[k]);
+                });
+                size_t i = row * width + x;
+                if (gradients.empty()) {
+                    out.scatter(i, std::array<S, 1>{Noise::template evaluate<false>(c, g)});
+                } else {
+                    out.scatter(i, std::array<S, 1>{Noise::template evaluate<true>(c, g)});
+                    grad.scatter(i, g);
+                }
+            });
+        }
+    });
+}
+
+// Added to every component of the input of the further outputs of noise2..noise4.
+constexpr double offsets[4] = {0, 19.19, 47.43, 73.97};
+
+template<size_t M, class T>
+Vector<item_t<T>, M> noise(const T& x) {
+    Vector<item_t<T>, M> result;
+    static_foreach<0, M>([&](size_t k) {
+        result[k] = evaluate<Simplex, false>(T(x + item_t<T>(offsets[k])), static_cast<T*>(nullptr));
+    });
+    return result;
+}
+
+} // namespace details::noise
+
+namespace concepts {
+
+template<typename T>
+concept NoiseInput = std::floating_point<T> || (Vector<T> && std::floating_point<traits::vector_item_t<T>> &&
+                                                 traits::vector_trait<T>::size >= 2 && traits::vector_trait<T>::size <= 4);
+
+} // namespace concepts
+
+/**
+ * Simplex noise of a float or double scalar or vector of 2 to 4 components, in [-1, 1] and C2-smooth;
+ * the second form also writes the analytic gradient.
+ */
+template<concepts::NoiseInput T>
+traits::vector_item_t<T> simplex(const T& p) {
+    return details::noise::evaluate<details::noise::Simplex, false>(p, static_cast<T*>(nullptr));
+}
+
+template<concepts::NoiseInput T>
+traits::vector_item_t<T> simplex(const std::type_identity_t<T>& p, T& gradient) {
+    return details::noise::evaluate<details::noise::Simplex, true>(p, &gradient);
+}
+
+/**
+ * Perlin (improved gradient) noise of a float or double scalar or vector of 2 to 4 components, in [-1, 1]
+ * and zero at integer points; the second form also writes the analytic gradient.
+ */
+template<concepts::NoiseInput T>
+traits::vector_item_t<T> perlin(const T& p) {
+    return details::noise::evaluate<details::noise::Perlin, false>(p, static_cast<T*>(nullptr));
+}
+
+template<concepts::NoiseInput T>
+traits::vector_item_t<T> perlin(const std::type_identity_t<T>& p, T& gradient) {
+    return details::noise::evaluate<details::noise::Perlin, true>(p, &gradient);
+}
+
+/**
+ * values[i] = simplex(points[i]) and, unless gradients is empty, gradients[i] its gradient: a register of
+ * points per step and the span split across max_threads() threads. The point type is explicit,
+ * simplex<vec3>(points, values), as the spans are not deduced.
+ */
+template<concepts::NoiseInput T>
+void simplex(std::type_identity_t<std::span<const T>> points,
+             std::type_identity_t<std::span<traits::vector_item_t<T>>> values,
+             std::type_identity_t<std::span<T>> gradients = {}) {
+    details::noise::points<details::noise::Simplex>(points, values, gradients);
+}
+
+template<concepts::NoiseInput T>
+void perlin(std::type_identity_t<std::span<const T>> points,
+            std::type_identity_t<std::span<traits::vector_item_t<T>>> values,
+            std::type_identity_t<std::span<T>> gradients = {}) {
+    details::noise::points<details::noise::Perlin>(points, values, gradients);
+}
+
+/**
+ * Fills values (and gradients unless empty) with the noise at origin + index * step for every index below
+ * size, x fastest: values[x + size.x * (y + size.y * z)] on a vec3 grid. Rows of x run a register of points
+ * per step, whole rows are split across max_threads() threads.
+ */
+template<concepts::NoiseInput T> requires concepts::Vector<T>
+void simplex(const T& origin, const T& step, const Vector<unsigned, traits::vector_trait<T>::size>& size,
+             std::type_identity_t<std::span<traits::vector_item_t<T>>> values,
+             std::type_identity_t<std::span<T>> gradients = {}) {
+    details::noise::grid<details::noise::Simplex>(origin, step, size, values, gradients);
+}
+
+template<concepts::NoiseInput T> requires concepts::Vector<T>
+void perlin(const T& origin, const T& step, const Vector<unsigned, traits::vector_trait<T>::size>& size,
+            std::type_identity_t<std::span<traits::vector_item_t<T>>> values,
+            std::type_identity_t<std::span<T>> gradients = {}) {
+    details::noise::grid<details::noise::Perlin>(origin, step, size, values, gradients);
+}
+
+/**
+ * The GLSL noise builtins, on simplex noise: noise1 is simplex(x), the further components of noise2..noise4
+ * are the noise at x shifted by fixed offsets, so they are uncorrelated.
+ */
+template<concepts::NoiseInput T>
+traits::vector_item_t<T> noise1(const T& x) {
+    return simplex(x);
+}
+
+template<concepts::NoiseInput T>
+Vector<traits::vector_item_t<T>, 2> noise2(const T& x) {
+    return details::noise::noise<2>(x);
+}
+
+template<concepts::NoiseInput T>
+Vector<traits::vector_item_t<T>, 3> noise3(const T& x) {
+    return details::noise::noise<3>(x);
+}
+
+template<concepts::NoiseInput T>
+Vector<traits::vector_item_t<T>, 4> noise4(const T& x) {
+    return details::noise::noise<4>(x);
+}
+
+} // namespace glsl
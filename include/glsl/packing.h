@@ -0,0 +1,244 @@
+#pragma once
+
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <span>
+#include "vector.h"
+#include "details/soa.h"
+#include "details/vmath.h"
+
+namespace glsl {
+
+/**
+ * GLSL pack and unpack builtins: normalized and half floats in the fields of a uint32_t, first component
+ * in the least significant bits. The kernels are written once for scalars and simd::Packet registers, the
+ * span versions convert a register of vectors (or of packed values) per step.
+ */
+namespace details::packing {
+
+using vmath::bitcast, vmath::convert, vmath::int_t, vmath::rebind_t;
+
+/**
+ * Field of Bits bits of x clamped to [0, 1], or to [-1, 1] when Signed, and scaled to the field range;
+ * rounded to nearest even.
+ */
+template<bool Signed, int Bits, class S>
+constexpr int_t<S> normalized(const S& x) {
+    constexpr float low = Signed ? -1.0f : 0.0f;
+    constexpr float scale = float(Signed ? (1 << (Bits - 1)) - 1 : (1 << Bits) - 1);
+    S c = select(x < S(low), S(low), select(x > S(1), S(1), x));
+    // The fraction is pushed out of the mantissa, its low bits are then the two's complement of the result.
+    return bitcast<int32_t>(S(c * S(scale) + S(0x1.8p23f))) & int_t<S>((1 << Bits) - 1);
+}
+
+/**
+ * x of a field of Bits bits written by normalized.
+ */
+template<bool Signed, int Bits, class I>
+constexpr rebind_t<I, float> denormalized(const I& field) {
+    using S = rebind_t<I, float>;
+    if constexpr (Signed) {
+        constexpr int sign = 1 << (Bits - 1);
+        S x = convert<float>(I((field ^ I(sign)) - I(sign))) / S(float(sign - 1));
+        return select(x < S(-1), S(-1), x);
+    } else {
+        return convert<float>(field) / S(float((1 << Bits) - 1));
+    }
+}
+
+/**
+ * Binary16 bits of x, rounded to nearest even; overflow goes to infinity, NaN stays a quiet NaN with the top
+ * of its payload (as the F16C conversion does).
+ */
+template<class S>
+constexpr int_t<S> half(const S& x) {
+    using I = int_t<S>;
+    I bits = bitcast<int32_t>(x);
+    I sign = bits & I(int32_t(0x80000000u));
+    bits = bits ^ sign;
+    S magnitude = bitcast<float>(bits);
+
+    // Subnormal halves: the float addition aligns the mantissa and rounds.
+    constexpr int32_t subnormal_magic = ((127 - 15) + (23 - 10) + 1) << 23;
+    I subnormal = bitcast<int32_t>(S(magnitude + bitcast<float>(subnormal_magic))) - I(subnormal_magic);
+
+    // Normal halves: rebias, then round to nearest even on the 13 bits shifted out.
+    I odd = (bits >> 13) & I(1);
+    I normal = ((bits + I(((15 - 127) << 23) + 0xfff) + odd) >> 13) & I(0x7fff);
+
+    I result = select(magnitude < S(0x1p-14f), subnormal, normal);
+    result = select(magnitude >= S(65536.0f), I(0x7c00), result);
+    result = select(magnitude != magnitude, I(I(0x7e00) | ((bits >> 13) & I(0x1ff))), result);
+    return result | ((sign >> 16) & I(0x8000));
+}
+
+/**
+ * Float of the binary16 bits h.
+ */
+template<class I>
+constexpr rebind_t<I, float> unhalf(const I& h) {
+    using S = rebind_t<I, float>;
+    constexpr int32_t exponent = 0x7c00 << 13;
+
+    I bits = (h & I(0x7fff)) << 13;
+    I e = bits & I(exponent);
+    bits = bits + I((127 - 15) << 23);
+
+    // Infinity and NaN, quieted.
+    I special = bits + I((128 - 16) << 23);
+    special = special | select((h & I(0x3ff)) == I(0), I(0), I(0x400000));
+    // Subnormals: the exponent is made that of 2^-14 and the implicit one subtracted again.
+    I subnormal = bitcast<int32_t>(S(bitcast<float>(I(bits + I(1 << 23))) - S(0x1p-14f)));
+
+    bits = select(e == I(exponent), special, select(e == I(0), subnormal, bits));
+    return bitcast<float>(I(bits | ((h & I(0x8000)) << 16)));
+}
+
+// Fields of Bits bits, first in the least significant bits.
+template<int Bits, class I, size_t N>
+constexpr I fields(const std::array<I, N>& values) {
+    I result = values[0];
+    for (size_t k = 1; k < N; ++k)
+        result = result | (values[k] << int(k * Bits));
+    return result;
+}
+
+template<int Bits, size_t N, class I>
+constexpr std::array<I, N> split(const I& p) {
+    std::array<I, N> result;
+    for (size_t k = 0; k < N; ++k)
+        result[k] = (p >> int(k * Bits)) & I(int32_t((uint64_t(1) << Bits) - 1));
+    return result;
+}
+
+// The packed formats: components per uint32_t, and the conversion of one component to its field and back.
+struct Unorm2x16 {
+    static constexpr size_t size = 2;
+    static constexpr int bits = 16;
+    template<class S> static constexpr auto pack(const S& x) { return normalized<false, 16>(x); }
+    template<class I> static constexpr auto unpack(const I& f) { return denormalized<false, 16>(f); }
+};
+
+struct Snorm2x16 {
+    static constexpr size_t size = 2;
+    static constexpr int bits = 16;
+    template<class S> static constexpr auto pack(const S& x) { return normalized<true, 16>(x); }
+    template<class I> static constexpr auto unpack(const I& f) { return denormalized<true, 16>(f); }
+};
+
+struct Unorm4x8 {
+    static constexpr size_t size = 4;
+    static constexpr int bits = 8;
+    template<class S> static constexpr auto pack(const S& x) { return normalized<false, 8>(x); }
+    template<class I> static constexpr auto unpack(const I& f) { return denormalized<false, 8>(f); }
+};
+
+struct Snorm4x8 {
+    static constexpr size_t size = 4;
+    static constexpr int bits = 8;
+    template<class S> static constexpr auto pack(const S& x) { return normalized<true, 8>(x); }
+    template<class I> static constexpr auto unpack(const I& f) { return denormalized<true, 8>(f); }
+};
+
+struct Half2x16 {
+    static constexpr size_t size = 2;
+    static constexpr int bits = 16;
+    template<class S> static constexpr auto pack(const S& x) { return half(x); }
+    template<class I> static constexpr auto unpack(const I& f) { return unhalf(f); }
+};
+
+template<class Format, class S>
+constexpr int_t<S> encode(const std::array<S, Format::size>& v) {
+    std::array<int_t<S>, Format::size> f;
+    for (size_t k = 0; k < Format::size; ++k)
+        f[k] = Format::pack(v[k]);
+    return fields<Format::bits>(f);
+}
+
+template<class Format, class I>
+constexpr std::array<rebind_t<I, float>, Format::size> decode(const I& p) {
+    auto f = split<Format::bits, Format::size>(p);
+    std::array<rebind_t<I, float>, Format::size> result;
+    for (size_t k = 0; k < Format::size; ++k)
+        result[k] = Format::unpack(f[k]);
+    return result;
+}
+
+template<class Format, concepts::Vector T> requires (traits::vector_trait<T>::size == Format::size)
+constexpr uint32_t pack(const T& v) {
+    std::array<float, Format::size> c;
+    for (size_t k = 0; k < Format::size; ++k)
+        c[k] = float(v[k]);
+    return uint32_t(encode<Format>(c));
+}
+
+template<class Format>
+constexpr Vector<float, Format::size> unpack(uint32_t p) {
+    auto c = decode<Format>(int32_t(p));
+    Vector<float, Format::size> result;
+    for (size_t k = 0; k < Format::size; ++k)
+        result[k] = c[k];
+    return result;
+}
+
+template<class Format, template<class, size_t> class Trait>
+void pack(std::span<const Vector<float, Format::size, Trait>> v, std::span<uint32_t> out) {
+    assert(out.size() >= v.size());
+
+    if (v.empty())
+        return;
+
+    // int32_t and uint32_t may alias each other.
+    auto* p = reinterpret_cast<int32_t*>(out.data());
+    soa::for_each<float, soa::lanes_for<float, Format::size>>(v.size(), []<class S>(const std::array<S, Format::size>& c) {
+        return std::array{ encode<Format>(c) };
+    }, soa::stream<1>(p, p), soa::stream<Format::size>(&v.data()->data[0], v.data()));
+}
+
+template<class Format, template<class, size_t> class Trait>
+void unpack(std::span<const uint32_t> p, std::span<Vector<float, Format::size, Trait>> out) {
+    assert(out.size() >= p.size());
+
+    if (p.empty())
+        return;
+
+    auto* in = reinterpret_cast<const int32_t*>(p.data());
+    soa::for_each<int32_t, soa::lanes_for<float, Format::size>>(p.size(), []<class I>(const std::array<I, 1>& c) {
+        return decode<Format>(c[0]);
+    }, soa::stream<Format::size>(&out.data()->data[0], out.data()), soa::stream<1>(in, in));
+}
+
+} // namespace details::packing
+
+#define DEF_PACKING_FUNC(name, Format)                                                                   \
+template<concepts::Vector T> requires (traits::vector_trait<T>::size == details::packing::Format::size) \
+constexpr uint32_t pack##name(const T& v) {                                                             \
+    return details::packing::pack<details::packing::Format>(v);                                         \
+}                                                                                                       \
+                                                                                                        \
+constexpr Vector<float, details::packing::Format::size> unpack##name(uint32_t p) {                      \
+    return details::packing::unpack<details::packing::Format>(p);                                       \
+}                                                                                                       \
+                                                                                                        \
+template<template<class, size_t> class Trait = VectorTrait>                                             \
+void pack##name(std::type_identity_t<std::span<const Vector<float, details::packing::Format::size, Trait>>> v, \
+                std::span<uint32_t> out) {                                                              \
+    details::packing::pack<details::packing::Format, Trait>(v, out);                                    \
+}                                                                                                       \
+                                                                                                        \
+template<template<class, size_t> class Trait = VectorTrait>                                             \
+void unpack##name(std::span<const uint32_t> p,                                                          \
+                  std::type_identity_t<std::span<Vector<float, details::packing::Format::size, Trait>>> out) { \
+    details::packing::unpack<details::packing::Format, Trait>(p, out);                                  \
+}
+
+DEF_PACKING_FUNC(Unorm2x16, Unorm2x16)
+DEF_PACKING_FUNC(Snorm2x16, Snorm2x16)
+DEF_PACKING_FUNC(Unorm4x8, Unorm4x8)
+DEF_PACKING_FUNC(Snorm4x8, Snorm4x8)
+DEF_PACKING_FUNC(Half2x16, Half2x16)
+
+#undef DEF_PACKING_FUNC
+
+} // namespace glsl
@@ -0,0 +1,278 @@
+#pragma once
+
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <numbers>
+#include "vector.h"
+#include "batch.h"
+#include "vector_functions.h"
+#include "details/vmath.h"
+
+namespace glsl {
+
+/**
+ * GLSL precision qualifiers. highp is the default and maps every builtin to the std:: function,
+ * mediump and lowp vectors (see MediumpVectorTrait, LowpVectorTrait) trade accuracy for cheaper,
+ * branch-light approximations of sin, cos, exp, log, pow, inversesqrt and normalize.
+ *
+ * Maximum error against the std:: result for float vectors, double vectors are at least as accurate
+ * (2e-7 is about two float ulp):
+ *
+ *                  mediump                   lowp                      domain
+ *   sin, cos       2e-7 abs                  5e-5 abs                  |x| <= 1e4
+ *   exp            2e-7 rel                  1e-4 rel                  results below the normal range flush to 0
+ *   log            2e-7 * max(1, |log x|)    5e-6 * max(1, |log x|)    x > 0, log(0) = -inf, log(x < 0) = NaN
+ *   pow            2e-7 * (1 + |y log x|)    1e-4 * (1 + |y log x|)    x > 0
+ *   inversesqrt    5e-6 rel                  2e-3 rel                  0 < x < inf
+ *   normalize      5e-6 rel                  2e-3 rel                  non-zero vectors
+ */
+enum class Precision {
+    low,
+    medium,
+    high,
+};
+
+namespace details::vmath {
+
+template<class T, size_t W, class U>
+struct rebind<Batch<T, W>, U> {
+    using type = Batch<U, W>;
+};
+
+} // namespace details::vmath
+
+namespace details::approx {
+
+/**
+ * The kernels below are written once for float/double scalars, Batch packets and simd::Packet registers,
+ * selects replace branches so a packet runs as straight-line register code. select is called unqualified
+ * so the Packet overload is found by ADL.
+ */
+using vmath::Real, vmath::rebind, vmath::rebind_t, vmath::int_t, vmath::convert, vmath::bitcast;
+using vmath::mantissa_bits, vmath::exponent_bias, vmath::pow2i, vmath::round_nearest, vmath::horner;
+using vmath::reduce_half_pi;
+
+constexpr double ln2_hi = 0.693359375;
+
+constexpr double ln2_lo = -2.12194440e-4;
+
+template<Precision P, Real T>
+T sin_kernel(const T& r) {
+    T z = r * r;
+    if constexpr (P == Precision::low) {
+        return r + r * z * horner(z, -1.0 / 6, 1.0 / 120);
+    } else {
+        return r + r * z * horner(z, -1.6666654611e-1, 8.3321608736e-3, -1.9515295891e-4);
+    }
+}
+
+template<Precision P, Real T>
+T cos_kernel(const T& r) {
+    T z = r * r;
+    if constexpr (P == Precision::low) {
+        return horner(z, 1.0, -0.5, 1.0 / 24, -1.0 / 720);
+    } else {
+        return T(1) - T(0.5) * z + z * z * horner(z, 4.166664568298827e-2, -1.388731625493765e-3, 2.443315711809948e-5);
+    }
+}
+
+template<Precision P, Real T>
+T sin(const T& x) {
+    using I = int_t<T>;
+    I q;
+    T r = reduce_half_pi(x, q);
+    T v = select((q & I(1)) != I(0), cos_kernel<P>(r), sin_kernel<P>(r));
+    return select((q & I(2)) != I(0), T(-v), v);
+}
+
+template<Precision P, Real T>
+T cos(const T& x) {
+    using I = int_t<T>;
+    I q;
+    T r = reduce_half_pi(x, q);
+    T v = select((q & I(1)) != I(0), sin_kernel<P>(r), cos_kernel<P>(r));
+    return select(((q + I(1)) & I(2)) != I(0), T(-v), v);
+}
+
+template<Precision P, Real T>
+T exp(const T& x) {
+    using I = int_t<T>;
+    constexpr bool single = sizeof(traits::batch_item_t<T>) == 4;
+    constexpr double hi = single ? 88.72283 : 709.782712893384;
+    constexpr double lo = single ? -87.33654 : -708.3964185322641;
+    constexpr double inf = std::numeric_limits<double>::infinity();
+
+    T c = details::clamp(x, T(lo), T(hi));
+    T k = round_nearest(c * T(std::numbers::log2e));
+    T r = (c - k * T(ln2_hi)) - k * T(ln2_lo);
+
+    T p;
+    if constexpr (P == Precision::low) {
+        p = horner(r, 1.0, 1.0, 1.0 / 2, 1.0 / 6, 1.0 / 24);
+    } else {
+        p = T(1) + r + r * r * horner(r, 5.0000001201e-1, 1.6666665459e-1, 4.1665795894e-2,
+                                      8.3334519073e-3, 1.3981999507e-3, 1.9875691500e-4);
+    }
+
+    // 2^k leaves the normal range at the ends, apply it in two halves.
+    I n = convert<traits::batch_item_t<I>>(k);
+    I h = convert<traits::batch_item_t<I>>(round_nearest(T(k * T(0.5))));
+    T result = p * pow2i<T>(h) * pow2i<T>(I(n - h));
+    result = select(x < T(lo), T(0), result);
+    result = select(x > T(hi), T(inf), result);
+    return select(x != x, x, result);
+}
+
+template<Precision P, Real T>
+T log(const T& x) {
+    using I = int_t<T>;
+    using Item = traits::batch_item_t<T>;
+    constexpr auto mantissa = (traits::batch_item_t<I>(1) << mantissa_bits<T>) - 1;
+
+    // Subnormals are scaled into the normal range first.
+    auto tiny = x < T(std::numeric_limits<Item>::min());
+    T v = select(tiny, T(x * T(double(uint64_t(1) << mantissa_bits<T>))), x);
+    I e = select(tiny, I(-mantissa_bits<T>), I(0));
+
+    // v = m * 2^e with m in [sqrt(0.5), sqrt(2)).
+    I b = bitcast<traits::batch_item_t<I>>(v);
+    e = e + (b >> mantissa_bits<T>) - I(exponent_bias<T>);
+    T m = bitcast<Item>((b & I(mantissa)) | I(traits::batch_item_t<I>(exponent_bias<T>) << mantissa_bits<T>));
+    auto big = m > T(std::numbers::sqrt2);
+    m = select(big, T(m * T(0.5)), m);
+    e = e + select(big, I(1), I(0));
+
+    // log(m) = 2 atanh(t), t = (m - 1) / (m + 1) <= 0.1716.
+    T t = (m - T(1)) / (m + T(1));
+    T z = t * t;
+    T s;
+    if constexpr (P == Precision::low) {
+        s = T(2) * t * horner(z, 1.0, 1.0 / 3, 1.0 / 5);
+    } else {
+        s = T(2) * t * horner(z, 1.0, 1.0 / 3, 1.0 / 5, 1.0 / 7, 1.0 / 9);
+    }
+
+    T fe = convert<Item>(e);
+    T result = fe * T(ln2_hi) + (s + fe * T(ln2_lo));
+    result = select(x == T(std::numeric_limits<Item>::infinity()), x, result);
+    result = select(x == T(0), T(-std::numeric_limits<Item>::infinity()), result);
+    return select(!(x >= T(0)), T(std::numeric_limits<Item>::quiet_NaN()), result);
+}
+
+template<Precision P, Real T>
+T pow(const T& x, const T& y) {
+    T result = approx::exp<P>(y * approx::log<P>(x));
+    return select(y == T(0), T(1), result);
+}
+
+/**
+ * Bit-level initial estimate refined by Newton-Raphson steps, one for lowp and two for mediump.
+ */
+template<Precision P, Real T>
+T inversesqrt(const T& x) {
+    using I = int_t<T>;
+    using Item = traits::batch_item_t<T>;
+    using Bits = traits::batch_item_t<I>;
+    constexpr auto magic = Bits(sizeof(Item) == 4 ? 0x5f375a86 : 0x5fe6eb50c7b537a9);
+
+    // The sign bit is cleared after the shift so scalars and packets (logical >>) agree outside the domain.
+    T y = bitcast<Item>(I(magic) - ((bitcast<Bits>(x) >> 1) & I(std::numeric_limits<Bits>::max())));
+    T h = T(0.5) * x;
+    y = y * (T(1.5) - h * y * y);
+    if constexpr (P != Precision::low)
+        y = y * (T(1.5) - h * y * y);
+    return y;
+}
+
+} // namespace details::approx
+
+namespace details {
+
+/**
+ * Shared part of the reduced precision traits: VectorTrait storage plus approximate builtins
+ * that DEF_VEC_FUNC picks up through the TraitType hooks.
+ */
+template<template<class, size_t> class Self, Precision P, class Scalar, size_t Size>
+struct PrecisionVectorTrait : VectorTrait<Scalar, Size> {
+
+    static constexpr Precision precision = P;
+
+    template<class T = Scalar, size_t S = Size>
+    using Factory = Vector<T, S, Self>;
+
+    template<size_t... Indices>
+    using Proxy = std::conditional_t<sizeof...(Indices) == 1, Scalar, VectorProxy<Self<Scalar, Size>, Indices...>>;
+
+public: // APPROXIMATE BUILTINS
+
+    static Factory<> sin(const Factory<>& x) requires std::floating_point<Scalar> {
+        return packed([](const auto& v) { return approx::sin<P>(v); }, x);
+    }
+
+    static Factory<> cos(const Factory<>& x) requires std::floating_point<Scalar> {
+        return packed([](const auto& v) { return approx::cos<P>(v); }, x);
+    }
+
+    static Factory<> exp(const Factory<>& x) requires std::floating_point<Scalar> {
+        return packed([](const auto& v) { return approx::exp<P>(v); }, x);
+    }
+
+    static Factory<> log(const Factory<>& x) requires std::floating_point<Scalar> {
+        return packed([](const auto& v) { return approx::log<P>(v); }, x);
+    }
+
+    static Factory<> pow(const Factory<>& x, const Factory<>& y) requires std::floating_point<Scalar> {
+        return packed([](const auto& a, const auto& b) { return approx::pow<P>(a, b); }, x, y);
+    }
+
+    static Factory<> inversesqrt(const Factory<>& x) requires std::floating_point<Scalar> {
+        return packed([](const auto& v) { return approx::inversesqrt<P>(v); }, x);
+    }
+
+    static Factory<> normalize(const Factory<>& x) requires std::floating_point<Scalar> {
+        return x * approx::inversesqrt<P>(glsl::dot(x, x));
+    }
+
+private:
+
+    // Runs func on a packet register holding all lanes, or on a Batch where no register fits.
+    template<class Func, class... Args>
+    static Factory<> packed(const Func& func, const Args&... args) {
+        if constexpr (vmath::vectorizable<Func, Args...>()) {
+            return vmath::map(func, args...);
+        } else {
+            auto pack = [](const Factory<>& v) {
+                Batch<Scalar, Size> b;
+                Factory<>::foreachIndex([&](size_t i) {
+                    b[i] = v[i];
+                });
+                return b;
+            };
+
+            auto r = func(pack(args)...);
+            Factory<> result;
+            Factory<>::foreachIndex([&](size_t i) {
+                result[i] = r[i];
+            });
+            return result;
+        }
+    }
+};
+
+} // namespace details
+
+/**
+ * Vector storage of VectorTrait with the mediump approximations (errors are listed at glsl::Precision).
+ */
+template<class Scalar, size_t Size>
+struct MediumpVectorTrait : details::PrecisionVectorTrait<MediumpVectorTrait, Precision::medium, Scalar, Size> {};
+
+/**
+ * Vector storage of VectorTrait with the lowp approximations (errors are listed at glsl::Precision).
+ */
+template<class Scalar, size_t Size>
+struct LowpVectorTrait : details::PrecisionVectorTrait<LowpVectorTrait, Precision::low, Scalar, Size> {};
+
+} // namespace glsl
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <concepts>
+#include "vector.h"
+#include "batch.h"
+#include "vector_functions.h"
+
+namespace glsl {
+
+/**
+ * A 2x2 quad of fragments evaluated in lockstep, one Batch lane each: lane 0 is (x, y), lane 1 (x + 1, y),
+ * lane 2 (x, y + 1) and lane 3 (x + 1, y + 1). Vector<Quad<float>, N> runs every builtin on the four
+ * fragments at once, and the derivative builtins are differences between lanes, as on a GPU.
+ */
+template<class T = float>
+using Quad = Batch<T, 4>;
+
+namespace details::quad {
+
+// Each row the difference of its two lanes.
+template<class T>
+constexpr Quad<T> dx(const Quad<T>& q) {
+    T bottom = q[1] - q[0], top = q[3] - q[2];
+    return Quad<T>(bottom, bottom, top, top);
+}
+
+// Each column the difference of its two lanes.
+template<class T>
+constexpr Quad<T> dy(const Quad<T>& q) {
+    T left = q[2] - q[0], right = q[3] - q[1];
+    return Quad<T>(left, right, left, right);
+}
+
+// The differences of the first row and column, for all four lanes.
+template<class T>
+constexpr Quad<T> dx_coarse(const Quad<T>& q) {
+    return Quad<T>(q[1] - q[0]);
+}
+
+template<class T>
+constexpr Quad<T> dy_coarse(const Quad<T>& q) {
+    return Quad<T>(q[2] - q[0]);
+}
+
+template<class Func, class T>
+constexpr T apply(const Func& func, const T& v) {
+    if constexpr (concepts::Vector<T>) {
+        T result;
+        vector_foreach<T>([&](size_t i) {
+            result[i] = func(v[i]);
+        });
+        return result;
+    } else {
+        return func(v);
+    }
+}
+
+} // namespace details::quad
+
+namespace concepts {
+
+template<typename T>
+concept QuadValue = std::same_as<traits::vector_item_t<T>, Quad<traits::batch_item_t<traits::vector_item_t<T>>>> &&
+                    std::floating_point<traits::batch_item_t<traits::vector_item_t<T>>>;
+
+} // namespace concepts
+
+/**
+ * Evaluates f(fragCoord) for the quad whose first fragment is at fragCoord, the other three one pixel to the
+ * right, above and both: f takes a Vector<Quad<float>, 2> and returns Quad values, so derivatives of anything
+ * it computes are available inside it. run_quad(vec2(10.5f, 20.5f), [](auto p) { return fwidth(p.x * p.y); }).
+ */
+template<class Func>
+constexpr auto run_quad(const Vector<float, 2>& fragCoord, const Func& f) {
+    float x = fragCoord.x, y = fragCoord.y;
+    return f(Vector<Quad<float>, 2>(Quad<float>(x, x + 1, x, x + 1), Quad<float>(y, y, y + 1, y + 1)));
+}
+
+/**
+ * The GLSL derivative builtins of a Quad value or vector: dFdx differences the two fragments of each row,
+ * dFdy the two of each column (the Fine variants); the Coarse variants take the first row and column for
+ * the whole quad. fwidth is abs(dFdx) + abs(dFdy).
+ */
+template<concepts::QuadValue T>
+constexpr T dFdx(const T& p) {
+    return details::quad::apply([](const auto& q) { return details::quad::dx(q); }, p);
+}
+
+template<concepts::QuadValue T>
+constexpr T dFdy(const T& p) {
+    return details::quad::apply([](const auto& q) { return details::quad::dy(q); }, p);
+}
+
+template<concepts::QuadValue T>
+constexpr T dFdxFine(const T& p) {
+    return dFdx(p);
+}
+
+template<concepts::QuadValue T>
+constexpr T dFdyFine(const T& p) {
+    return dFdy(p);
+}
+
+template<concepts::QuadValue T>
+constexpr T dFdxCoarse(const T& p) {
+    return details::quad::apply([](const auto& q) { return details::quad::dx_coarse(q); }, p);
+}
+
+template<concepts::QuadValue T>
+constexpr T dFdyCoarse(const T& p) {
+    return details::quad::apply([](const auto& q) { return details::quad::dy_coarse(q); }, p);
+}
+
+template<concepts::QuadValue T>
+T fwidth(const T& p) {
+    return details::quad::apply([](const auto& q) { return abs(details::quad::dx(q)) + abs(details::quad::dy(q)); }, p);
+}
+
+template<concepts::QuadValue T>
+T fwidthFine(const T& p) {
+    return fwidth(p);
+}
+
+template<concepts::QuadValue T>
+T fwidthCoarse(const T& p) {
+    return details::quad::apply([](const auto& q) {
+        return abs(details::quad::dx_coarse(q)) + abs(details::quad::dy_coarse(q));
+    }, p);
+}
+
+} // namespace glsl
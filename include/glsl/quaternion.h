@@ -0,0 +1,322 @@
+#pragma once
+
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <ostream>
+#include <span>
+#include "matrix.h"
+#include "vector_functions.h"
+#include "details/soa.h"
+#include "details/vmath.h"
+
+namespace glsl {
+
+namespace details::quaternion {
+
+// Above this cosine slerp falls back to a normalized lerp, sin(theta) would cancel.
+constexpr double linear_threshold = 0.9995;
+
+/**
+ * slerp on x, y, z, w components, S is a scalar or a simd::Packet of as many quaternions.
+ * b is negated where the quaternions are more than 90 degrees apart, so the shorter arc is taken.
+ */
+template<class S>
+std::array<S, 4> slerp(const std::array<S, 4>& a, std::array<S, 4> b, const S& t) {
+    using details::select;
+
+    S d = a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3];
+    auto flip = d < S(0);
+    d = select(flip, S(0) - d, d);
+    for (auto& c : b)
+        c = select(flip, S(0) - c, c);
+
+    auto linear = d > S(linear_threshold);
+    S theta = vmath::acos(select(linear, S(0), d));
+    // sin(acos(d)), 1 - d is exact near 1.
+    S s = vmath::square_root(S((S(1) - d) * (S(1) + d)));
+    S wa = select(linear, S(1) - t, vmath::sin(S((S(1) - t) * theta)) / s);
+    S wb = select(linear, t, vmath::sin(S(t * theta)) / s);
+
+    std::array<S, 4> r;
+    for (size_t k = 0; k < 4; ++k)
+        r[k] = wa * a[k] + wb * b[k];
+
+    S scale = select(linear, S(1) / vmath::square_root(S(r[0] * r[0] + r[1] * r[1] + r[2] * r[2] + r[3] * r[3])), S(1));
+    for (auto& c : r)
+        c = c * scale;
+    return r;
+}
+
+// v rotated by the unit quaternion q: t = 2 cross(q.xyz, v), v + q.w t + cross(q.xyz, t).
+template<class S>
+std::array<S, 3> rotate(const std::array<S, 4>& q, const std::array<S, 3>& v) {
+    S tx = S(2) * (q[1] * v[2] - q[2] * v[1]);
+    S ty = S(2) * (q[2] * v[0] - q[0] * v[2]);
+    S tz = S(2) * (q[0] * v[1] - q[1] * v[0]);
+    return {
+        v[0] + q[3] * tx + (q[1] * tz - q[2] * ty),
+        v[1] + q[3] * ty + (q[2] * tx - q[0] * tz),
+        v[2] + q[3] * tz + (q[0] * ty - q[1] * tx),
+    };
+}
+
+} // namespace details::quaternion
+
+/**
+ * Rotation quaternion x i + y j + z k + w, stored as the Vector (x, y, z, w).
+ * The Hamilton product runs on whole vectors (broadcast, permute, multiply-add), so SimdVectorTrait
+ * quaternions multiply in registers; rotate and slerp over spans process a packet of quaternions at once.
+ */
+template<class T, template<class, size_t> class Trait = VectorTrait>
+struct Quaternion {
+
+    using VectorType = typename Trait<T, 3>::template Factory<>;
+    using StorageType = typename Trait<T, 4>::template Factory<>;
+    using QuaternionItem = T;
+
+    StorageType data;
+
+public: // CONSTRUCTORS
+
+    // Identity rotation.
+    constexpr Quaternion() : data(0, 0, 0, 1) {}
+
+    constexpr Quaternion(const Quaternion&) = default;
+
+    constexpr Quaternion(T x, T y, T z, T w) : data(x, y, z, w) {}
+
+    constexpr Quaternion(const VectorType& xyz, T w) : data(xyz, w) {}
+
+    constexpr explicit Quaternion(const StorageType& xyzw) : data(xyzw) {}
+
+    constexpr Quaternion& operator=(const Quaternion&) = default;
+
+    /**
+     * Rotation by angle radians around the unit vector axis.
+     */
+    static Quaternion angleAxis(T angle, const VectorType& axis) {
+        T half = angle / T(2);
+        return Quaternion(axis * T(std::sin(half)), T(std::cos(half)));
+    }
+
+public: // OPERATORS
+
+    constexpr decltype(auto) operator[](size_t i) {
+        return data[i];
+    }
+
+    constexpr decltype(auto) operator[](size_t i) const {
+        return data[i];
+    }
+
+    constexpr Quaternion operator+() const {
+        return *this;
+    }
+
+    constexpr Quaternion operator-() const {
+        return Quaternion(StorageType(StorageType(0) - data));
+    }
+
+    constexpr Quaternion& operator*=(const Quaternion& q) {
+        return *this = *this * q;
+    }
+
+    friend constexpr Quaternion operator+(const Quaternion& a, const Quaternion& b) {
+        return Quaternion(StorageType(a.data + b.data));
+    }
+
+    friend constexpr Quaternion operator-(const Quaternion& a, const Quaternion& b) {
+        return Quaternion(StorageType(a.data - b.data));
+    }
+
+    friend constexpr Quaternion operator*(const Quaternion& q, T s) {
+        return Quaternion(StorageType(q.data * s));
+    }
+
+    friend constexpr Quaternion operator*(T s, const Quaternion& q) {
+        return Quaternion(StorageType(s * q.data));
+    }
+
+    friend constexpr Quaternion operator/(const Quaternion& q, T s) {
+        return Quaternion(StorageType(q.data / s));
+    }
+
+    /**
+     * Hamilton product, the rotation b followed by a. Each column of the product matrix of a is a signed
+     * permutation of b, so the product is four broadcast multiply-adds.
+     */
+    friend constexpr Quaternion operator*(const Quaternion& a, const Quaternion& b) {
+        const StorageType& q = b.data;
+        StorageType r = StorageType(a.data[3]) * q;
+        r = fma(StorageType(a.data[0]), StorageType(StorageType(q[3], q[2], q[1], q[0]) * StorageType(1, -1, 1, -1)), r);
+        r = fma(StorageType(a.data[1]), StorageType(StorageType(q[2], q[3], q[0], q[1]) * StorageType(1, 1, -1, -1)), r);
+        r = fma(StorageType(a.data[2]), StorageType(StorageType(q[1], q[0], q[3], q[2]) * StorageType(-1, 1, 1, -1)), r);
+        return Quaternion(r);
+    }
+
+    // v rotated by q, q must be a unit quaternion.
+    friend constexpr VectorType operator*(const Quaternion& q, const VectorType& v) {
+        return rotate(q, v);
+    }
+
+    friend constexpr bool operator==(const Quaternion& a, const Quaternion& b) {
+        return a.data == b.data;
+    }
+
+    friend std::ostream& operator<<(std::ostream& os, const Quaternion& obj) {
+        return os << obj.data;
+    }
+
+public: // FUNCTIONS
+
+    friend constexpr T dot(const Quaternion& a, const Quaternion& b) {
+        return dot(a.data, b.data);
+    }
+
+    friend T length(const Quaternion& q) {
+        return length(q.data);
+    }
+
+    friend Quaternion normalize(const Quaternion& q) {
+        return Quaternion(StorageType(normalize(q.data)));
+    }
+
+    friend constexpr Quaternion conjugate(const Quaternion& q) {
+        return Quaternion(VectorType(VectorType(0) - q.xyz()), q.data[3]);
+    }
+
+    friend constexpr Quaternion inverse(const Quaternion& q) {
+        return conjugate(q) / dot(q, q);
+    }
+
+    friend constexpr VectorType rotate(const Quaternion& q, const VectorType& v) {
+        VectorType u = q.xyz();
+        VectorType t = T(2) * cross(u, v);
+        return VectorType(v + q.data[3] * t + cross(u, t));
+    }
+
+    /**
+     * Normalized linear interpolation, on the shorter arc. Its angular speed is not constant,
+     * but it is cheaper than slerp and close to it for nearby rotations.
+     */
+    friend Quaternion nlerp(const Quaternion& a, const Quaternion& b, T t) {
+        Quaternion c = dot(a, b) < T(0) ? -b : b;
+        return normalize(Quaternion(StorageType(mix(a.data, c.data, StorageType(t)))));
+    }
+
+    /**
+     * Spherical linear interpolation of unit quaternions on the shorter arc, constant angular speed.
+     */
+    friend Quaternion slerp(const Quaternion& a, const Quaternion& b, T t) {
+        auto r = details::quaternion::slerp<T>(a.components(), b.components(), t);
+        return Quaternion(r[0], r[1], r[2], r[3]);
+    }
+
+public: // AUXILIARY
+
+    constexpr VectorType xyz() const {
+        return VectorType(data[0], data[1], data[2]);
+    }
+
+    constexpr std::array<T, 4> components() const {
+        return { data[0], data[1], data[2], data[3] };
+    }
+};
+
+/**
+ * Rotation matrix of the unit quaternion q.
+ */
+template<class T, template<class, size_t> class Trait>
+constexpr Matrix<T, 3, 3, Trait> mat3_cast(const Quaternion<T, Trait>& q) {
+    T x = q.data[0], y = q.data[1], z = q.data[2], w = q.data[3];
+    T xx = x * x, yy = y * y, zz = z * z;
+    T xy = x * y, xz = x * z, yz = y * z;
+    T wx = w * x, wy = w * y, wz = w * z;
+    return Matrix<T, 3, 3, Trait>(
+        T(1) - T(2) * (yy + zz), T(2) * (xy + wz), T(2) * (xz - wy),
+        T(2) * (xy - wz), T(1) - T(2) * (xx + zz), T(2) * (yz + wx),
+        T(2) * (xz + wy), T(2) * (yz - wx), T(1) - T(2) * (xx + yy));
+}
+
+template<class T, template<class, size_t> class Trait>
+constexpr Matrix<T, 4, 4, Trait> mat4_cast(const Quaternion<T, Trait>& q) {
+    Matrix<T, 3, 3, Trait> r = mat3_cast(q);
+    Matrix<T, 4, 4, Trait> result(1);
+    details::static_foreach<0, 3>([&](size_t col) {
+        details::static_foreach<0, 3>([&](size_t row) {
+            result.at(row, col) = r.at(row, col);
+        });
+    });
+    return result;
+}
+
+/**
+ * Unit quaternion of the rotation matrix m (the upper 3x3 block of a 4x4 one), Shepperd's method:
+ * the square root is taken of the largest of w, x, y and z so the divisions stay well conditioned.
+ */
+template<class T, size_t N, template<class, size_t> class Trait> requires (N == 3 || N == 4)
+Quaternion<T, Trait> quat_cast(const Matrix<T, N, N, Trait>& m) {
+    auto a = [&](size_t row, size_t col) { return m.at(row, col); };
+    T trace = a(0, 0) + a(1, 1) + a(2, 2);
+    if (trace > T(0)) {
+        T s = T(2) * T(std::sqrt(trace + T(1)));
+        return Quaternion<T, Trait>((a(2, 1) - a(1, 2)) / s, (a(0, 2) - a(2, 0)) / s, (a(1, 0) - a(0, 1)) / s, s / T(4));
+    } else if (a(0, 0) > a(1, 1) && a(0, 0) > a(2, 2)) {
+        T s = T(2) * T(std::sqrt(T(1) + a(0, 0) - a(1, 1) - a(2, 2)));
+        return Quaternion<T, Trait>(s / T(4), (a(0, 1) + a(1, 0)) / s, (a(0, 2) + a(2, 0)) / s, (a(2, 1) - a(1, 2)) / s);
+    } else if (a(1, 1) > a(2, 2)) {
+        T s = T(2) * T(std::sqrt(T(1) + a(1, 1) - a(0, 0) - a(2, 2)));
+        return Quaternion<T, Trait>((a(0, 1) + a(1, 0)) / s, s / T(4), (a(1, 2) + a(2, 1)) / s, (a(0, 2) - a(2, 0)) / s);
+    } else {
+        T s = T(2) * T(std::sqrt(T(1) + a(2, 2) - a(0, 0) - a(1, 1)));
+        return Quaternion<T, Trait>((a(0, 2) + a(2, 0)) / s, (a(1, 2) + a(2, 1)) / s, s / T(4), (a(1, 0) - a(0, 1)) / s);
+    }
+}
+
+/**
+ * out[i] = slerp(a[i], b[i], t[i]), a packet of quaternions per iteration. The scalar type is explicit,
+ * slerp<float>(a, b, t, out), as the spans are not deduced.
+ */
+template<class T, template<class, size_t> class Trait = VectorTrait>
+void slerp(std::type_identity_t<std::span<const Quaternion<T, Trait>>> a,
+           std::type_identity_t<std::span<const Quaternion<T, Trait>>> b,
+           std::type_identity_t<std::span<const T>> t,
+           std::type_identity_t<std::span<Quaternion<T, Trait>>> out) {
+    assert(b.size() == a.size() && t.size() == a.size() && out.size() >= a.size());
+
+    if (a.empty())
+        return;
+
+    namespace q = details::quaternion;
+    namespace s = details::soa;
+    s::for_each<T>(a.size(), []<class S>(const std::array<S, 4>& qa, const std::array<S, 4>& qb, const std::array<S, 1>& ts) {
+        return q::slerp<S>(qa, qb, ts[0]);
+    }, s::stream<4>(&out.data()->data.data[0], out.data()),
+       s::stream<4>(&a.data()->data.data[0], a.data()),
+       s::stream<4>(&b.data()->data.data[0], b.data()),
+       s::stream<1>(t.data(), t.data()));
+}
+
+/**
+ * out[i] = rotate(q[i], v[i]), a packet of vectors per iteration.
+ */
+template<class T, template<class, size_t> class Trait = VectorTrait>
+void rotate(std::type_identity_t<std::span<const Quaternion<T, Trait>>> q,
+            std::type_identity_t<std::span<const typename Trait<T, 3>::template Factory<>>> v,
+            std::type_identity_t<std::span<typename Trait<T, 3>::template Factory<>>> out) {
+    assert(v.size() == q.size() && out.size() >= q.size());
+
+    if (q.empty())
+        return;
+
+    namespace k = details::quaternion;
+    namespace s = details::soa;
+    s::for_each<T>(q.size(), []<class S>(const std::array<S, 4>& qs, const std::array<S, 3>& vs) {
+        return k::rotate<S>(qs, vs);
+    }, s::stream<3>(&out.data()->data[0], out.data()),
+       s::stream<4>(&q.data()->data.data[0], q.data()),
+       s::stream<3>(&v.data()->data[0], v.data()));
+}
+
+} // namespace glsl
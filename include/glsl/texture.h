@@ -0,0 +1,377 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <concepts>
+#include <span>
+#include <vector>
+#include "vector.h"
+#include "half.h"
+#include "quad.h"
+#include "details/parallel.h"
+
+namespace glsl {
+
+/**
+ * How texture coordinates outside [0, 1] are brought back into the image (GL_TEXTURE_WRAP_S/T/R).
+ */
+enum class Wrap {
+    repeat,
+    mirrored_repeat,
+    clamp_to_edge,
+};
+
+/**
+ * The texel filter of a level: nearest texel or the bilinear mix of the four around the coordinate.
+ */
+enum class Filter {
+    nearest,
+    linear,
+};
+
+/**
+ * How levels of the mip chain are picked when minifying: only the base level, the nearest level, or the mix
+ * of the two around the level of detail (with linear texel filters, trilinear filtering).
+ */
+enum class MipFilter {
+    none,
+    nearest,
+    linear,
+};
+
+/**
+ * The sampling state of a texture, like the parameters of a GL texture object. The defaults repeat the
+ * image and filter trilinearly.
+ */
+struct Sampler {
+    Wrap wrapS = Wrap::repeat;
+    Wrap wrapT = Wrap::repeat;
+    Wrap wrapR = Wrap::repeat;
+    Filter magFilter = Filter::linear;
+    Filter minFilter = Filter::linear;
+    MipFilter mipFilter = MipFilter::linear;
+};
+
+namespace concepts {
+
+template<typename T>
+concept TexelScalar = std::floating_point<T> || Widening<T>;
+
+template<typename T>
+concept Texel = (TexelScalar<T> && !Vector<T>) ||
+                (Vector<T> && TexelScalar<traits::vector_item_t<T>> && T::VectorSize >= 2 && T::VectorSize <= 4);
+
+} // namespace concepts
+
+namespace details::texture {
+
+// Texels per tile side: an 8x8 tile is 64 texels, a few cache lines a bilinear footprint rarely leaves.
+constexpr int tile = 8;
+
+// Lookups per thread of the span builtins.
+constexpr size_t grain = 16384;
+
+// Filters run in double for double texels, float otherwise (half and bfloat16 are widened).
+template<class Texel>
+using compute_t = std::conditional_t<std::same_as<traits::vector_item_t<Texel>, double>, double, float>;
+
+template<class Texel>
+struct sample {
+    using type = compute_t<Texel>;
+};
+
+template<concepts::Vector Texel>
+struct sample<Texel> {
+    using type = Vector<compute_t<Texel>, Texel::VectorSize>;
+};
+
+template<class Texel>
+using sample_t = typename sample<Texel>::type;
+
+// The Z-order of a texel inside its tile: the bits of x and y interleaved, x in the even ones.
+constexpr size_t morton(int x, int y) {
+    auto spread = [](unsigned v) { return (v & 1) | (v & 2) << 1 | (v & 4) << 2; };
+    return spread(unsigned(x)) | spread(unsigned(y)) << 1;
+}
+
+// i brought into [0, n).
+constexpr int wrap(int i, int n, Wrap mode) {
+    switch (mode) {
+    case Wrap::repeat: {
+        int r = i % n;
+        return r < 0 ? r + n : r;
+    }
+    case Wrap::mirrored_repeat: {
+        int r = i % (2 * n);
+        r = r < 0 ? r + 2 * n : r;
+        return r < n ? r : 2 * n - 1 - r;
+    }
+    default:
+        return std::clamp(i, 0, n - 1);
+    }
+}
+
+// The integer part of a texel coordinate, saturated so far-away coordinates do not overflow int; NaN is 0.
+inline int cell(float x) {
+    return x == x ? int(std::clamp(std::floor(x), -1e9f, 1e9f)) : 0;
+}
+
+template<class S, class C>
+S lerp(const S& a, const S& b, C t) {
+    return S(a + (b - a) * t);
+}
+
+} // namespace details::texture
+
+/**
+ * A 2D texture of float, double, half or bfloat16 scalars or 2 to 4 component vectors, with its mip chain
+ * and sampling state (sampler, public like the parameters of a GL texture object). Levels are stored in 8x8
+ * tiles, row after row of tiles, with the texels of a tile in Z-order: the four texels of a bilinear
+ * footprint share a tile and usually a cache line, in whichever direction the image is walked, which keeps
+ * rotated and minified access from thrashing the cache like a row-major image would. Samples are computed
+ * and returned in float (double for double texels): a Texture2D<hvec4> is sampled as vec4.
+ */
+template<concepts::Texel T>
+class Texture2D {
+public:
+    using TexelType = T;
+    using SampleType = details::texture::sample_t<T>;
+
+    Sampler sampler;
+
+    Texture2D() = default;
+
+    /**
+     * A width x height texture of zeroed texels, its base level only.
+     */
+    Texture2D(unsigned width, unsigned height, const Sampler& sampler = {}) : sampler(sampler) {
+        assert(width > 0 && height > 0);
+        add_level(int(width), int(height));
+        data.resize(mips[0].size);
+    }
+
+    /**
+     * A texture of the row-major width x height texels, texels[x + y * width] at (x, y).
+     */
+    Texture2D(unsigned width, unsigned height, std::span<const T> texels, const Sampler& sampler = {})
+        : Texture2D(width, height, sampler) {
+        assert(texels.size() >= size_t(width) * height);
+        for (int y = 0; y < int(height); ++y) {
+            for (int x = 0; x < int(width); ++x)
+                data[index(mips[0], x, y)] = texels[size_t(x) + size_t(y) * width];
+        }
+    }
+
+    /**
+     * Levels of the mip chain, 1 until generateMipmap().
+     */
+    int levels() const {
+        return int(mips.size());
+    }
+
+    Vector<int, 2> size(int level = 0) const {
+        assert(level >= 0 && level < levels());
+        return Vector<int, 2>(mips[size_t(level)].width, mips[size_t(level)].height);
+    }
+
+    const T& fetch(const Vector<int, 2>& p, int level = 0) const {
+        const Level& l = mips[size_t(level)];
+        assert(p.x >= 0 && p.x < l.width && p.y >= 0 && p.y < l.height);
+        return data[index(l, p.x, p.y)];
+    }
+
+    /**
+     * Writes one texel; the levels below it are not updated until generateMipmap() runs again.
+     */
+    void store(const Vector<int, 2>& p, const T& texel, int level = 0) {
+        const Level& l = mips[size_t(level)];
+        assert(p.x >= 0 && p.x < l.width && p.y >= 0 && p.y < l.height);
+        data[index(l, p.x, p.y)] = texel;
+    }
+
+    /**
+     * Builds the full mip chain down to 1x1 from the base level, each level the 2x2 box filter of the one
+     * above it (at odd sizes the last row or column is left out, as halving rounds down).
+     */
+    void generateMipmap() {
+        mips.resize(1);
+        while (mips.back().width > 1 || mips.back().height > 1)
+            add_level(std::max(mips.back().width / 2, 1), std::max(mips.back().height / 2, 1));
+        data.resize(mips.back().offset + mips.back().size);
+
+        for (size_t level = 1; level < mips.size(); ++level) {
+            const Level& src = mips[level - 1];
+            const Level& dst = mips[level];
+            for (int y = 0; y < dst.height; ++y) {
+                int y0 = std::min(2 * y, src.height - 1), y1 = std::min(2 * y + 1, src.height - 1);
+                for (int x = 0; x < dst.width; ++x) {
+                    int x0 = std::min(2 * x, src.width - 1), x1 = std::min(2 * x + 1, src.width - 1);
+                    SampleType sum = SampleType(data[index(src, x0, y0)]) + SampleType(data[index(src, x1, y0)]) +
+                                     SampleType(data[index(src, x0, y1)]) + SampleType(data[index(src, x1, y1)]);
+                    data[index(dst, x, y)] = T(SampleType(sum * Compute(0.25)));
+                }
+            }
+        }
+    }
+
+    /**
+     * The filtered sample at uv for a level of detail, what textureLod returns: the mag filter on the base
+     * level at lod <= 0, otherwise the min filter on the levels the mip filter picks, lod clamped to the
+     * chain.
+     */
+    SampleType sample(const Vector<float, 2>& uv, float lod) const {
+        if (!(lod > 0))
+            return filter(sampler.magFilter, mips[0], uv);
+
+        int last = levels() - 1;
+        switch (sampler.mipFilter) {
+        case MipFilter::none:
+            return filter(sampler.minFilter, mips[0], uv);
+        case MipFilter::nearest:
+            return filter(sampler.minFilter, mips[size_t(std::min(int(std::ceil(lod + 0.5f)) - 1, last))], uv);
+        default:
+            if (lod >= float(last))
+                return filter(sampler.minFilter, mips[size_t(last)], uv);
+            int level = int(lod);
+            return details::texture::lerp(filter(sampler.minFilter, mips[size_t(level)], uv),
+                                          filter(sampler.minFilter, mips[size_t(level) + 1], uv),
+                                          Compute(lod - float(level)));
+        }
+    }
+
+    /**
+     * The level of detail of a footprint with the uv derivatives dPdx and dPdy: log2 of its longer side
+     * in base level texels.
+     */
+    float lod(const Vector<float, 2>& dPdx, const Vector<float, 2>& dPdy) const {
+        Vector<float, 2> texels(float(mips[0].width), float(mips[0].height));
+        return 0.5f * std::log2(std::max(dot(dPdx * texels, dPdx * texels), dot(dPdy * texels, dPdy * texels)));
+    }
+
+private:
+    using Compute = details::texture::compute_t<T>;
+
+    struct Level {
+        int width, height;
+        size_t tiles;
+        size_t offset, size;
+    };
+
+    std::vector<Level> mips;
+    std::vector<T> data;
+
+    void add_level(int width, int height) {
+        using details::texture::tile;
+        size_t columns = size_t(width + tile - 1) / tile, rows = size_t(height + tile - 1) / tile;
+        size_t offset = mips.empty() ? 0 : mips.back().offset + mips.back().size;
+        mips.push_back(Level{ width, height, columns, offset, columns * rows * tile * tile });
+    }
+
+    static size_t index(const Level& l, int x, int y) {
+        using details::texture::tile;
+        size_t t = size_t(y / tile) * l.tiles + size_t(x / tile);
+        return l.offset + t * tile * tile + details::texture::morton(x % tile, y % tile);
+    }
+
+    SampleType texel(const Level& l, int x, int y) const {
+        return SampleType(data[index(l, details::texture::wrap(x, l.width, sampler.wrapS),
+                                     details::texture::wrap(y, l.height, sampler.wrapT))]);
+    }
+
+    SampleType filter(Filter mode, const Level& l, const Vector<float, 2>& uv) const {
+        float x = uv.x * float(l.width), y = uv.y * float(l.height);
+        if (mode == Filter::nearest)
+            return texel(l, details::texture::cell(x), details::texture::cell(y));
+
+        x -= 0.5f;
+        y -= 0.5f;
+        int x0 = details::texture::cell(x), y0 = details::texture::cell(y);
+        Compute ax = Compute(x - std::floor(x)), ay = Compute(y - std::floor(y));
+        return details::texture::lerp(details::texture::lerp(texel(l, x0, y0), texel(l, x0 + 1, y0), ax),
+                                      details::texture::lerp(texel(l, x0, y0 + 1), texel(l, x0 + 1, y0 + 1), ax),
+                                      ay);
+    }
+};
+
+/**
+ * The GLSL texture builtins on a Texture2D: texture picks the level of detail from the derivatives of uv,
+ * which only a quad has, so texture(tex, vec2) samples the base level (plus bias); texture on a
+ * Vector<Quad<float>, 2> (see run_quad) is the one that mipmaps. textureLod and textureGrad take the level
+ * or the derivatives, texelFetch reads a texel of a level unfiltered, textureSize is the size of a level.
+ */
+template<class T>
+typename Texture2D<T>::SampleType texture(const Texture2D<T>& tex, const Vector<float, 2>& uv, float bias = 0) {
+    return tex.sample(uv, bias);
+}
+
+template<class T>
+typename Texture2D<T>::SampleType textureLod(const Texture2D<T>& tex, const Vector<float, 2>& uv, float lod) {
+    return tex.sample(uv, lod);
+}
+
+template<class T>
+typename Texture2D<T>::SampleType textureGrad(const Texture2D<T>& tex, const Vector<float, 2>& uv,
+                                              const Vector<float, 2>& dPdx, const Vector<float, 2>& dPdy) {
+    return tex.sample(uv, tex.lod(dPdx, dPdy));
+}
+
+template<class T>
+typename Texture2D<T>::SampleType texelFetch(const Texture2D<T>& tex, const Vector<int, 2>& p, int lod) {
+    return typename Texture2D<T>::SampleType(tex.fetch(p, lod));
+}
+
+template<class T>
+Vector<int, 2> textureSize(const Texture2D<T>& tex, int lod) {
+    return tex.size(lod);
+}
+
+/**
+ * texture of the four fragments of a quad, each at the level of detail of its uv derivatives (dFdx, dFdy).
+ */
+template<class T>
+auto texture(const Texture2D<T>& tex, const Vector<Quad<float>, 2>& uv, float bias = 0) {
+    using Compute = details::texture::compute_t<T>;
+    using Result = std::conditional_t<concepts::Vector<T>, traits::vector_of_t<T, Quad<Compute>>, Quad<Compute>>;
+
+    Vector<Quad<float>, 2> dx = dFdx(uv), dy = dFdy(uv);
+    Result result;
+    for (size_t lane = 0; lane < 4; ++lane) {
+        auto s = tex.sample(Vector<float, 2>(uv.x[lane], uv.y[lane]),
+                            tex.lod(Vector<float, 2>(dx.x[lane], dx.y[lane]),
+                                    Vector<float, 2>(dy.x[lane], dy.y[lane])) + bias);
+        if constexpr (concepts::Vector<Result>) {
+            for (size_t k = 0; k < Result::VectorSize; ++k)
+                result[k][lane] = s[k];
+        } else {
+            result[lane] = s;
+        }
+    }
+    return result;
+}
+
+/**
+ * texture and textureLod of a span of coordinates, out[i] the sample at uv[i], split across the threads of
+ * the shared pool (max_threads(), GLSL_THREADS) for large spans.
+ */
+template<class T>
+void texture(const Texture2D<T>& tex, std::span<const Vector<float, 2>> uv,
+             std::span<typename Texture2D<T>::SampleType> out, float bias = 0) {
+    assert(out.size() >= uv.size());
+    details::parallel::for_each_chunk(uv.size(), details::texture::grain, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+            out[i] = tex.sample(uv[i], bias);
+    });
+}
+
+template<class T>
+void textureLod(const Texture2D<T>& tex, std::span<const Vector<float, 2>> uv, float lod,
+                std::span<typename Texture2D<T>::SampleType> out) {
+    assert(out.size() >= uv.size());
+    details::parallel::for_each_chunk(uv.size(), details::texture::grain, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+            out[i] = tex.sample(uv[i], lod);
+    });
+}
+
+} // namespace glsl
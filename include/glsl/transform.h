@@ -0,0 +1,278 @@
+#pragma once
+
+#include <cassert>
+#include <span>
+#include "matrix.h"
+#include "matrix_functions.h"
+#include "details/soa.h"
+#include "details/transform_kernels.h"
+
+namespace glsl {
+
+namespace details {
+
+// Packed kernels need tightly packed elements, the baseline one also matrix columns of exactly one register.
+template<class T, size_t N, template<class, size_t> class Trait>
+constexpr bool dense_span = std::is_floating_point_v<T> &&
+                            sizeof(Vector<T, 4, Trait>) == 4 * sizeof(T) &&
+                            sizeof(Vector<T, N, Trait>) == N * sizeof(T);
+
+template<class T, size_t N, template<class, size_t> class Trait>
+constexpr bool packed_span = simd::Register<T, 4>::supported && dense_span<T, N, Trait>;
+
+/**
+ * Transforms count vectors of InSize scalars by the column-major 4x4 matrix m, implying w = W
+ * for 3-component inputs. Columns stay in registers; four elements are in flight per iteration.
+ */
+template<class Reg, size_t InSize, size_t OutSize, int W, class T>
+void transform_packed(const T* in, const T* m, T* out, size_t count) {
+    using type = typename Reg::type;
+
+    const type c0 = Reg::loadu(m), c1 = Reg::loadu(m + 4), c2 = Reg::loadu(m + 8), c3 = Reg::loadu(m + 12);
+
+    const bool stream = OutSize == 4 && count * OutSize * sizeof(T) > GLSL_STREAM_THRESHOLD &&
+                        reinterpret_cast<uintptr_t>(out) % Reg::alignment == 0;
+
+    auto apply = [&](const T* v) {
+        type r = Reg::fmadd(c2, Reg::set1(v[2]), Reg::fmadd(c1, Reg::set1(v[1]), Reg::mul(c0, Reg::set1(v[0]))));
+        if constexpr (InSize == 4) {
+            return Reg::fmadd(c3, Reg::set1(v[3]), r);
+        } else if constexpr (W == 1) {
+            return Reg::add(r, c3);
+        } else {
+            return r;
+        }
+    };
+
+    auto store = [&](T* p, type r, bool last) {
+        if constexpr (OutSize == 4) {
+            if (stream) {
+                Reg::stream(p, r);
+            } else {
+                Reg::storeu(p, r);
+            }
+        } else {
+            // The 4th lane spills into the next element, which is written afterwards.
+            if (last) {
+                alignas(Reg::alignment) T tmp[4];
+                Reg::store(tmp, r);
+                p[0] = tmp[0], p[1] = tmp[1], p[2] = tmp[2];
+            } else {
+                Reg::storeu(p, r);
+            }
+        }
+    };
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const T* v = in + i * InSize;
+        type r0 = apply(v), r1 = apply(v + InSize), r2 = apply(v + 2 * InSize), r3 = apply(v + 3 * InSize);
+        T* o = out + i * OutSize;
+        store(o, r0, false);
+        store(o + OutSize, r1, false);
+        store(o + 2 * OutSize, r2, false);
+        store(o + 3 * OutSize, r3, true);
+    }
+    for (; i < count; ++i) {
+        store(out + i * OutSize, apply(in + i * InSize), true);
+    }
+
+    if (stream)
+        Reg::fence();
+}
+
+// Runs the widest kernel active_isa() allows on the leading vectors, returns how many it did.
+template<size_t InSize, size_t OutSize, int W, class T>
+size_t transform_wide(const T* in, const T* m, T* out, size_t count) {
+#if GLSL_DISPATCH
+    switch (active_isa()) {
+    case Isa::avx512:
+        return avx512::transform<T, InSize, OutSize, W>(in, m, out, count);
+    case Isa::avx2:
+        return avx2::transform<T, InSize, OutSize, W>(in, m, out, count);
+    case Isa::sse2:
+        break;
+    }
+#endif
+    return 0;
+}
+
+template<size_t InSize, size_t OutSize, int W, class T, template<class, size_t> class Trait>
+void transform_span(std::span<const Vector<T, InSize, Trait>> in,
+                    const Matrix<T, 4, 4, Trait>& m,
+                    std::span<Vector<T, OutSize, Trait>> out) {
+    assert(out.size() >= in.size());
+
+    if (in.empty())
+        return;
+
+    size_t i = 0;
+    if constexpr (dense_span<T, InSize, Trait> && dense_span<T, OutSize, Trait>) {
+        i = transform_wide<InSize, OutSize, W>(&in.data()->data[0], &m[0].data[0], &out.data()->data[0], in.size());
+    }
+
+    if constexpr (packed_span<T, InSize, Trait> && packed_span<T, OutSize, Trait>) {
+        if (i < in.size()) {
+            transform_packed<simd::Register<T, 4>, InSize, OutSize, W>(
+                    &in[i].data[0], &m[0].data[0], &out[i].data[0], in.size() - i);
+        }
+    } else {
+        for (; i < in.size(); ++i) {
+            Vector<T, 4, Trait> r;
+            if constexpr (InSize == 4) {
+                r = m * in[i];
+            } else {
+                r = m * Vector<T, 4, Trait>(in[i], W);
+            }
+            if constexpr (OutSize == 4) {
+                out[i] = r;
+            } else {
+                out[i] = Vector<T, 3, Trait>(r[0], r[1], r[2]);
+            }
+        }
+    }
+}
+
+// 3x3 and 4x4 matrices of tightly packed floating point components, columns included.
+template<class T>
+constexpr bool dense_matrix = (T::MatrixColumns == 3 || T::MatrixColumns == 4) &&
+                              std::is_floating_point_v<typename T::MatrixItem> &&
+                              sizeof(T) == T::MatrixSize * sizeof(typename T::MatrixItem);
+
+// The components of a span of matrices, column after column.
+template<class T, size_t Size = T::MatrixSize>
+auto components(std::span<T> m) {
+    return soa::stream<Size>(m.empty() ? nullptr : &m[0][0].data[0], m.data());
+}
+
+/**
+ * Writes kernel(components).adjugate of every matrix of m to out, a packet of matrices at a time. singular[i]
+ * (when given) is set where kernel(components).determinant is zero or not finite, the count of those is returned.
+ * Flattened, GCC keeps the block of a packet (gather, kernel, scatter) out of line otherwise.
+ */
+template<class T, class Out, class Kernel>
+[[gnu::flatten]] size_t matrix_span(std::span<const T> m, const Out& out, std::span<bool> singular, const Kernel& kernel) {
+    assert(singular.empty() || singular.size() >= m.size());
+
+    if (m.empty())
+        return 0;
+
+    using Item = typename T::MatrixItem;
+    auto in = components(m);
+    size_t count = 0;
+    soa::for_each_block<Item>(m.size(), [&]<class S>(size_t i) {
+        auto [values, det] = kernel(in.template gather<S>(i));
+        out.scatter(i, values);
+        count += soa::store_mask<S>(!((det != S(0)) & (det - det == S(0))), singular.data(), i);
+    });
+    return count;
+}
+
+template<size_t N, class S>
+std::array<S, N * N> transposed(const std::array<S, N * N>& a) {
+    std::array<S, N * N> result;
+    static_foreach<0, N>([&](size_t col) {
+        static_foreach<0, N>([&](size_t row) {
+            result[col * N + row] = a[row * N + col];
+        });
+    });
+    return result;
+}
+
+} // namespace details
+
+/**
+ * out[i] = (m * vec4(points[i], 1)).xyz, an affine transform of positions.
+ */
+template<class T, template<class, size_t> class Trait>
+void transform_points(std::type_identity_t<std::span<const Vector<T, 3, Trait>>> points,
+                      const Matrix<T, 4, 4, Trait>& m,
+                      std::type_identity_t<std::span<Vector<T, 3, Trait>>> out) {
+    details::transform_span<3, 3, 1>(points, m, out);
+}
+
+/**
+ * out[i] = (m * vec4(vectors[i], 0)).xyz, translation is ignored.
+ */
+template<class T, template<class, size_t> class Trait>
+void transform_vectors(std::type_identity_t<std::span<const Vector<T, 3, Trait>>> vectors,
+                       const Matrix<T, 4, 4, Trait>& m,
+                       std::type_identity_t<std::span<Vector<T, 3, Trait>>> out) {
+    details::transform_span<3, 3, 0>(vectors, m, out);
+}
+
+/**
+ * out[i] = m * vec4(points[i], 1), homogeneous clip-space coordinates without the perspective divide.
+ */
+template<class T, template<class, size_t> class Trait>
+void project_points(std::type_identity_t<std::span<const Vector<T, 3, Trait>>> points,
+                    const Matrix<T, 4, 4, Trait>& m,
+                    std::type_identity_t<std::span<Vector<T, 4, Trait>>> out) {
+    details::transform_span<3, 4, 1>(points, m, out);
+}
+
+/**
+ * out[i] = m * vectors[i].
+ */
+template<class T, template<class, size_t> class Trait>
+void transform(std::type_identity_t<std::span<const Vector<T, 4, Trait>>> vectors,
+               const Matrix<T, 4, 4, Trait>& m,
+               std::type_identity_t<std::span<Vector<T, 4, Trait>>> out) {
+    details::transform_span<4, 4, 0>(vectors, m, out);
+}
+
+/**
+ * out[i] = inverse(m[i]) on spans of mat3 or mat4, a packet of matrices per iteration. singular[i], when
+ * given, is set where the determinant of m[i] is zero or not finite (out[i] is not finite then); returns how
+ * many are. The matrix type is explicit, inverse<mat4>(m, out, singular), as the spans are not deduced.
+ */
+template<concepts::MatrixQuad T> requires details::dense_matrix<T>
+size_t inverse(std::type_identity_t<std::span<const T>> m,
+               std::type_identity_t<std::span<T>> out,
+               std::type_identity_t<std::span<bool>> singular = {}) {
+    assert(out.size() >= m.size());
+    return details::matrix_span(m, details::components(out),
+                                singular, []<class S, size_t Size>(const std::array<S, Size>& a) {
+        auto [adjugate, det] = details::cofactor::adjugate(a);
+        S scale = S(1) / det;
+        for (auto& c : adjugate)
+            c = c * scale;
+        return details::cofactor::Adjugate<S, Size>{ adjugate, det };
+    });
+}
+
+/**
+ * out[i] = transpose(inverse(m[i])), the normal matrices of m, with singular as in inverse.
+ */
+template<concepts::MatrixQuad T> requires details::dense_matrix<T>
+size_t inverseTranspose(std::type_identity_t<std::span<const T>> m,
+                        std::type_identity_t<std::span<T>> out,
+                        std::type_identity_t<std::span<bool>> singular = {}) {
+    assert(out.size() >= m.size());
+    return details::matrix_span(m, details::components(out),
+                                singular, []<class S, size_t Size>(const std::array<S, Size>& a) {
+        auto [adjugate, det] = details::cofactor::adjugate(a);
+        S scale = S(1) / det;
+        auto result = details::transposed<T::MatrixColumns>(adjugate);
+        for (auto& c : result)
+            c = c * scale;
+        return details::cofactor::Adjugate<S, Size>{ result, det };
+    });
+}
+
+/**
+ * out[i] = determinant(m[i]), with singular as in inverse.
+ */
+template<concepts::MatrixQuad T> requires details::dense_matrix<T>
+size_t determinant(std::type_identity_t<std::span<const T>> m,
+                   std::type_identity_t<std::span<typename T::MatrixItem>> out,
+                   std::type_identity_t<std::span<bool>> singular = {}) {
+    assert(out.size() >= m.size());
+    return details::matrix_span(m, details::soa::stream<1>(out.data(), out.data()),
+                                singular, []<class S, size_t Size>(const std::array<S, Size>& a) {
+        auto det = details::cofactor::adjugate(a).determinant;
+        return details::cofactor::Adjugate<S, 1>{ { det }, det };
+    });
+}
+
+} // namespace glsl
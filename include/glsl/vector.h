@@ -1,12 +1,19 @@
 #pragma once
 
+#include <array>
+#include <ostream>
 #include "details/vector_base.h"
+#include "details/simd.h"
+#include "details/vector_expr.h"
 
 namespace glsl {
 
 template<class Scalar, size_t Size>
 struct VectorTrait;
 
+template<class Scalar, size_t Size>
+struct SimdVectorTrait;
+
 template<class Scalar, size_t Size, template<class, size_t> class Trait = VectorTrait>
 struct Vector;
 
@@ -35,6 +42,127 @@ struct VectorTrait {
     using Proxy = typename ProxyImpl<Indices...>::type;
 };
 
+/**
+ * Vector storage kept in a padded, register-aligned block, so arithmetic, comparisons
+ * and the reducing builtins run as packed SSE/AVX instructions instead of lane by lane.
+ * Scalar types or sizes without a matching register fall back to VectorTrait layout.
+ */
+template<class Scalar, size_t Size>
+struct SimdVectorTrait {
+    using ScalarType = Scalar;
+    using ScalarRef = std::add_lvalue_reference_t<ScalarType>;
+    using ScalarArg = traits::cref_if_class_t<ScalarType>;
+
+    template<class T = Scalar, size_t S = Size>
+    using Factory = Vector<T, S, SimdVectorTrait>;
+
+    using Register = details::simd::RegisterFor<ScalarType, Size>;
+
+    static constexpr bool Packed = Register::supported;
+
+    using DataType = std::conditional_t<Packed, details::simd::Storage<ScalarType, Size>, std::array<ScalarType, Size>>;
+
+    template<size_t... Indices>
+    struct ProxyImpl {
+        using type = VectorProxy<SimdVectorTrait, Indices...>;
+    };
+
+    template<size_t Index>
+    struct ProxyImpl<Index> {
+        using type = ScalarType;
+    };
+
+    template<size_t... Indices>
+    using Proxy = typename ProxyImpl<Indices...>::type;
+
+public: // PACKED KERNELS
+
+    template<class Op, class T>
+    requires (Packed && (std::same_as<T, Factory<>> || (std::convertible_to<T, Scalar> && !concepts::Vector<T>)))
+    static void assign(DataType& data, const T& v) {
+        data.store(details::simd::apply<Op, Register>(data.load(), load(v)));
+    }
+
+    static bool equals(const DataType& a, const Factory<>& b) requires Packed {
+        constexpr int mask = (1 << Size) - 1;
+        return (Register::movemask(Register::cmpeq(a.load(), b.data.load())) & mask) == mask;
+    }
+
+    static Factory<> min(const Factory<>& a, const Factory<>& b) requires Packed {
+        return make(Register::min(a.data.load(), b.data.load()));
+    }
+
+    static Factory<> max(const Factory<>& a, const Factory<>& b) requires Packed {
+        return make(Register::max(a.data.load(), b.data.load()));
+    }
+
+    static Factory<> clamp(const Factory<>& x, const Factory<>& lo, const Factory<>& hi) requires Packed {
+        return make(Register::min(Register::max(x.data.load(), lo.data.load()), hi.data.load()));
+    }
+
+    static Factory<> sqrt(const Factory<>& x) requires Packed {
+        return make(Register::sqrt(x.data.load()));
+    }
+
+    static Factory<> inversesqrt(const Factory<>& x) requires Packed {
+        return make(Register::div(Register::set1(1), Register::sqrt(x.data.load())));
+    }
+
+    static Factory<> fma(const Factory<>& a, const Factory<>& b, const Factory<>& c) requires Packed {
+        return make(Register::fmadd(a.data.load(), b.data.load(), c.data.load()));
+    }
+
+    static Scalar dot(const Factory<>& x, const Factory<>& y) requires Packed {
+        return Register::lane0(Register::hsum(lanes(Register::mul(x.data.load(), y.data.load()))));
+    }
+
+    static Factory<> normalize(const Factory<>& x) requires Packed {
+        auto v = x.data.load();
+        auto len = Register::sqrt(Register::hsum(lanes(Register::mul(v, v))));
+        return make(Register::mul(v, Register::div(Register::set1(1), len)));
+    }
+
+#define DEF_PACKED_COMPARE(func, cmp)                                                       \
+    static Factory<> func(const Factory<>& x, const Factory<>& y) requires Packed {         \
+        return make(Register::bitand_(Register::cmp(x.data.load(), y.data.load()),          \
+                                      Register::set1(1)));                                  \
+    }                                                                                       \
+
+    DEF_PACKED_COMPARE(equal, cmpeq)
+    DEF_PACKED_COMPARE(notEqual, cmpneq)
+    DEF_PACKED_COMPARE(greaterThan, cmpgt)
+    DEF_PACKED_COMPARE(greaterThanEqual, cmpge)
+    DEF_PACKED_COMPARE(lessThan, cmplt)
+    DEF_PACKED_COMPARE(lessThanEqual, cmple)
+
+#undef DEF_PACKED_COMPARE
+
+private:
+
+    template<class T>
+    static auto load(const T& v) {
+        if constexpr (std::same_as<T, Factory<>>) {
+            return v.data.load();
+        } else {
+            return Register::set1(static_cast<Scalar>(v));
+        }
+    }
+
+    static auto lanes(auto v) {
+        if constexpr (Size < Register::lanes) {
+            return Register::bitand_(v, Register::first(Size));
+        } else {
+            return v;
+        }
+    }
+
+    static Factory<> make(auto v) {
+        Factory<> result;
+        result.data.store(v);
+        return result;
+    }
+};
+
 template<class Scalar, size_t Size, template<class, size_t> class Trait>
 struct Vector : VectorBase<Scalar, Size, Trait> {
 
@@ -103,6 +231,9 @@ public: // OPERATORS
 
     template<class T> requires(concepts::SuitedTypeFor<std::remove_reference_t<T>, Vector>)
     constexpr Vector& operator=(T&& v) {
+        // Evaluated into a temporary, so the lanes are computed without storing through possible aliases.
+        if constexpr (details::expr::Expression<T>)
+            return *this = v.eval();
         foreachWith(v, [&](auto&& v1, auto&& v2) {
             v1 = v2;
         });
@@ -111,6 +242,10 @@ public: // OPERATORS
 
     template<concepts::SuitedTypeFor<Vector> T>
     constexpr Vector& operator+=(const T& v) {
+        if constexpr (details::expr::Expression<T>)
+            return *this = *this + v;
+        if (packedWith<std::plus<>>(v))
+            return *this;
         foreachWith(v, [&](auto&& v1, auto&& v2) {
             v1 += v2;
         });
@@ -119,6 +254,10 @@ public: // OPERATORS
 
     template<concepts::SuitedTypeFor<Vector> T>
     constexpr Vector& operator-=(const T& v) {
+        if constexpr (details::expr::Expression<T>)
+            return *this = *this - v;
+        if (packedWith<std::minus<>>(v))
+            return *this;
         foreachWith(v, [&](auto&& v1, auto&& v2) {
             v1 -= v2;
         });
@@ -127,6 +266,10 @@ public: // OPERATORS
 
     template<concepts::SuitedTypeFor<Vector> T>
     constexpr Vector& operator*=(const T& v) {
+        if constexpr (details::expr::Expression<T>)
+            return *this = *this * v;
+        if (packedWith<std::multiplies<>>(v))
+            return *this;
         foreachWith(v, [&](auto&& v1, auto&& v2) {
             v1 *= v2;
         });
@@ -135,6 +278,10 @@ public: // OPERATORS
 
     template<concepts::SuitedTypeFor<Vector> T>
     constexpr Vector& operator/=(const T& v) {
+        if constexpr (details::expr::Expression<T>)
+            return *this = *this / v;
+        if (packedWith<std::divides<>>(v))
+            return *this;
         foreachWith(v, [&](auto&& v1, auto&& v2) {
             v1 /= v2;
         });
@@ -171,9 +318,21 @@ public: // OPERATORS
 
     template<concepts::SuitedTypeFor<Vector> T>
     constexpr bool operator==(const T& v) const {
+        if constexpr (requires { TraitType::equals(data, v); }) {
+            if (!std::is_constant_evaluated())
+                return TraitType::equals(data, v);
+        }
         bool equals = true;
         foreachWith(v, [&](const auto& v1, const auto& v2) {
-            equals &= v1 == v2;
+            if constexpr (concepts::Batch<std::remove_cvref_t<decltype(v1)>>) {
+                // Batch items compare to a lane mask, the vectors are equal when every lane is.
+                auto lanes = v1 == v2;
+                lanes.foreachLane([&](size_t i) {
+                    equals &= bool(lanes[i]);
+                });
+            } else {
+                equals &= v1 == v2;
+            }
         });
         return equals;
     }
@@ -191,29 +350,29 @@ public: // OPERATORS
         return result;
     }
 
-    template<concepts::SuitedTypeFor<Vector> T>
+    template<concepts::SuitedTypeFor<Vector> T> requires (!details::expr::lazy_vector<Vector>)
     friend constexpr Vector operator+(const Vector& v1, const T& v2) {
         return traits::vector_common_t<Vector, T>(v1) += v2;
     }
 
-    template<concepts::SuitedTypeFor<Vector> T>
+    template<concepts::SuitedTypeFor<Vector> T> requires (!details::expr::lazy_vector<Vector>)
     friend constexpr Vector operator-(const Vector& v1, const T& v2) {
         return traits::vector_common_t<Vector, T>(v1) -= v2;
     }
 
-    template<concepts::SuitedTypeFor<Vector> T>
+    template<concepts::SuitedTypeFor<Vector> T> requires (!details::expr::lazy_vector<Vector>)
     friend constexpr Vector operator*(const Vector& v1, const T& v2) {
         return traits::vector_common_t<Vector, T>(v1) *= v2;
     }
 
-    template<concepts::SuitedTypeFor<Vector> T>
+    template<concepts::SuitedTypeFor<Vector> T> requires (!details::expr::lazy_vector<Vector>)
     friend constexpr Vector operator/(const Vector& v1, const T& v2) {
         return traits::vector_common_t<Vector, T>(v1) /= v2;
     }
 
     constexpr operator ScalarType() const
     requires (VectorSize == 1) {
-        return at(0);
+        return data[0];
     }
 
 public: // STL COMPATIBILITY
@@ -259,14 +418,14 @@ public: // UTILS
     template<concepts::SuitedScalarFor<Vector> T, class Func>
     constexpr void foreachWith(const T& obj, const Func& func) {
         foreachIndex([&, obj = scalarFrom(obj)](auto index) {
-            func(at(index), obj);
+            func(data[index], obj);
         });
     }
 
     template<concepts::SuitedVectorFor<Vector> T, class Func>
     constexpr void foreachWith(const T& obj, const Func& func) {
         foreachIndex([&](auto index) {
-            func(at(index), scalarFrom(obj.at(index)));
+            func(data[index], scalarFrom(obj[index]));
         });
     }
 
@@ -294,6 +453,17 @@ public: // UTILS
 
 private:
 
+    template<class Op, class T>
+    constexpr bool packedWith(const T& obj) {
+        if constexpr (requires { TraitType::template assign<Op>(data, obj); }) {
+            if (!std::is_constant_evaluated()) {
+                TraitType::template assign<Op>(data, obj);
+                return true;
+            }
+        }
+        return false;
+    }
+
     template<size_t Off, class T, class... Ts>
     constexpr void construct(T&& t, Ts&& ... ts) {
         constexpr size_t Len = traits::vector_size_for<T, Vector>();
@@ -305,7 +475,7 @@ private:
     template<size_t Off, size_t Len, class T>
     constexpr void compose(const T& v) {
         details::static_foreach<Off, Off + Len>([&](auto i) {
-            at(i) = scalarFrom(take(v, i - Off));
+            data[i] = scalarFrom(take(v, i - Off));
         });
     }
 
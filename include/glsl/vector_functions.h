@@ -1,84 +1,197 @@
 #pragma once
 
+#include <algorithm>
 #include <cmath>
 #include <numbers>
 #include "details/utils.h"
+#include "batch.h"
+#include "details/vmath.h"
 
 namespace glsl {
 
 inline constexpr double pi = std::numbers::pi_v<double>;
 
-#define DEF_VEC_FUNC(func, impl)                                    \
-template<class... Args>                                             \
-constexpr auto func(const Args& ...args) {                          \
-    using T = typename traits::first<Args...>::type;                \
-    if constexpr (concepts::Vector<T>) {                            \
-        constexpr auto fun = func<traits::vector_item_t<Args>...>;  \
-        return details::apply(fun, args...);                        \
-    } else {                                                        \
-        return T(impl(args...));                                    \
-    }                                                               \
-}                                                                   \
+#define DEF_VEC_FUNC(func, impl) DEF_VEC_FUNC_PACKED(func, impl, void)
+
+/**
+ * Builtin over scalars, Batch packets and vectors. Vectors go to the trait hook T::TraitType::func when it
+ * exists, then to the packed Kernel (details::vmath) when their scalar and size fit a register and the kernel
+ * beats the std:: call there, and are evaluated lane by lane otherwise and in constant evaluation. Lanes call
+ * the scalar builtin through a lambda: GCC does not inline it through a function pointer once it holds an
+ * fma instruction (-mfma).
+ */
+#define DEF_VEC_FUNC_PACKED(func, impl, Kernel)                                 \
+template<class... Args>                                                         \
+constexpr auto func(const Args& ...args) {                                      \
+    using T = typename traits::first<Args...>::type;                            \
+    if constexpr ((details::expr::Expression<Args> || ...)) {                   \
+        return func(details::expr::evaluate(args)...);                          \
+    } else if constexpr (concepts::Vector<T>) {                                 \
+        if constexpr (requires { T::TraitType::func(args...); }) {              \
+            if (!std::is_constant_evaluated())                                  \
+                return T::TraitType::func(args...);                             \
+        } else if constexpr (details::vmath::vectorizable<Kernel, Args...>()) { \
+            if (!std::is_constant_evaluated())                                  \
+                return details::vmath::map(Kernel(), args...);                  \
+        }                                                                       \
+        auto fun = [](const traits::vector_item_t<Args>&... items) {            \
+            return func(items...);                                              \
+        };                                                                      \
+        return details::apply(fun, args...);                                    \
+    } else if constexpr (concepts::Batch<T> &&                                 \
+                         !requires { impl(args...); }) {                        \
+        auto fun = [](const traits::batch_item_t<Args>&... items) {             \
+            return func(items...);                                              \
+        };                                                                      \
+        return details::lanewise(fun, args...);                                 \
+    } else {                                                                    \
+        return T(impl(args...));                                                \
+    }                                                                           \
+}                                                                               \
 
 namespace details {
 
+/**
+ * A floating point constant in the precision T computes in: float for float (and half) code, which a double
+ * literal would silently promote to double, double for double and integer code.
+ */
+template<class T>
+constexpr auto constant(double value) {
+    using Item = traits::batch_item_t<T>;
+    if constexpr (std::is_floating_point_v<Item>) {
+        return Item(value);
+    } else if constexpr (concepts::Widening<Item>) {
+        return typename Item::WidenedType(value);
+    } else {
+        return value;
+    }
+}
+
+template<concepts::Batch T>
+constexpr T fma(T a, T b, T c) {
+#if defined(FP_FAST_FMA) && defined(FP_FAST_FMAF)
+    if constexpr (std::is_floating_point_v<traits::batch_item_t<T>>) {
+        if (!std::is_constant_evaluated())
+            return details::lanewise([](auto x, auto y, auto z) { return details::fma(x, y, z); }, a, b, c);
+    }
+#endif
+    return a * b + c;
+}
+
+template<concepts::Widening T>
+constexpr T fma(T a, T b, T c) {
+    using W = typename T::WidenedType;
+    return T(details::fma(W(a), W(b), W(c)));
+}
+
+template<concepts::Scalar T>
+constexpr T sqrt(T x) {
+    using std::sqrt;
+    return sqrt(x);
+}
+
+template<concepts::Scalar T>
+constexpr T abs(T x) {
+    using std::abs;
+    return abs(x);
+}
+
+template<concepts::Scalar T>
+constexpr T floor(T x) {
+    using std::floor;
+    return floor(x);
+}
+
+template<concepts::Scalar T>
+constexpr T ceil(T x) {
+    using std::ceil;
+    return ceil(x);
+}
+
+template<concepts::Scalar T>
+constexpr T trunc(T x) {
+    using std::trunc;
+    return trunc(x);
+}
+
+template<concepts::Scalar T>
+constexpr T round(T x) {
+    using std::round;
+    return round(x);
+}
+
+template<concepts::Scalar T>
+constexpr T min(T x, T y) {
+    return select(y < x, y, x);
+}
+
+template<concepts::Scalar T>
+constexpr T max(T x, T y) {
+    return select(x < y, y, x);
+}
+
+template<concepts::Scalar T>
+constexpr T clamp(T x, T minVal, T maxVal) {
+    return select(x < minVal, minVal, select(maxVal < x, maxVal, x));
+}
+
 template<concepts::Scalar T>
 constexpr T degrees(T x) {
-    return x * (180 / std::numbers::pi);
+    return T(x * details::constant<T>(180 / std::numbers::pi));
 }
 
 template<concepts::Scalar T>
 constexpr T radians(T x) {
-    return x * (std::numbers::pi / 180);
+    return T(x * details::constant<T>(std::numbers::pi / 180));
 }
 
 template<concepts::Scalar T>
 constexpr T fract(T x) {
-    return x - std::floor(x);
+    return x - details::floor(x);
 }
 
 template<concepts::Scalar T, concepts::Scalar T1 = T>
 constexpr T mix(T x, T y, T1 a) {
-    if constexpr (std::same_as<T1, bool>) {
-        return a ? y : x;
+    if constexpr (concepts::Mask<T1>) {
+        return select(a, y, x);
     } else {
-        return x + a * (y - x);
+        return details::fma(T(a), T(y - x), x);
     }
 }
 
 template<concepts::Scalar T>
 constexpr T mod(T x, T y) {
-    if constexpr (std::integral<T>) {
+    if constexpr (std::integral<traits::batch_item_t<T>>) {
         return x % y;
     } else {
-        return x - y * std::floor(x / y);
+        return x - y * details::floor(x / y);
     }
 }
 
 template<concepts::Scalar T>
 constexpr T sign(T x) {
-    return x > 0 ? 1 : x < 0 ? -1 : 0;
+    return select(x > T(0), T(1), select(x < T(0), T(-1), T(0)));
 }
 
 template<concepts::Scalar T>
 constexpr T smoothstep(T edge0, T edge1, T x) {
-    T t = std::clamp((x - edge0) / (edge1 - edge0), T(0), T(1));
-    return t * t * (T(3) - T(2) * t);
+    T t = details::clamp(T((x - edge0) / (edge1 - edge0)), T(0), T(1));
+    return t * t * details::fma(T(-2), t, T(3));
 }
 
 template<concepts::Scalar T>
 constexpr T inversesqrt(T x) {
-    return T(1) / std::sqrt(x);
+    return T(1) / details::sqrt(x);
 }
 
 template<concepts::Scalar T>
 constexpr T step(T edge, T x) {
-    return x < edge ? T(0) : T(1);
+    return select(x < edge, T(0), T(1));
 }
 
 template<concepts::Scalar T>
 constexpr T faceforward(T n, T i, T nref) {
-    return (nref * i) < 0 ? T(n) : T(-n);
+    return select(nref * i < T(0), T(n), T(-n));
 }
 
 template<concepts::Scalar T>
@@ -118,52 +231,62 @@ constexpr T lessThanEqual(T x, T y) {
 
 } // namespace details
 
-DEF_VEC_FUNC(acos, std::acos)
-DEF_VEC_FUNC(asin, std::asin)
-DEF_VEC_FUNC(cos, std::cos)
-DEF_VEC_FUNC(sin, std::sin)
-DEF_VEC_FUNC(tan, std::tan)
+DEF_VEC_FUNC_PACKED(acos, std::acos, details::vmath::Acos)
+DEF_VEC_FUNC_PACKED(asin, std::asin, details::vmath::Asin)
+DEF_VEC_FUNC_PACKED(cos, std::cos, details::vmath::Cos)
+DEF_VEC_FUNC_PACKED(sin, std::sin, details::vmath::Sin)
+DEF_VEC_FUNC_PACKED(tan, std::tan, details::vmath::Tan)
 DEF_VEC_FUNC(degrees, details::degrees)
 DEF_VEC_FUNC(radians, details::radians)
-DEF_VEC_FUNC(abs, std::abs)
-DEF_VEC_FUNC(ceil, std::ceil)
-DEF_VEC_FUNC(exp, std::exp)
-DEF_VEC_FUNC(exp2, std::exp2)
-DEF_VEC_FUNC(floor, std::floor)
+DEF_VEC_FUNC(abs, details::abs)
+DEF_VEC_FUNC(ceil, details::ceil)
+DEF_VEC_FUNC_PACKED(exp, std::exp, details::vmath::Exp)
+DEF_VEC_FUNC_PACKED(exp2, std::exp2, details::vmath::Exp2)
+DEF_VEC_FUNC(floor, details::floor)
 DEF_VEC_FUNC(fract, details::fract)
 DEF_VEC_FUNC(isinf, std::isinf)
 DEF_VEC_FUNC(isnan, std::isnan)
-DEF_VEC_FUNC(log, std::log)
-DEF_VEC_FUNC(log2, std::log2)
-DEF_VEC_FUNC(max, std::max)
-DEF_VEC_FUNC(min, std::min)
-DEF_VEC_FUNC(clamp, std::clamp)
+DEF_VEC_FUNC_PACKED(log, std::log, details::vmath::Log)
+DEF_VEC_FUNC_PACKED(log2, std::log2, details::vmath::Log2)
+DEF_VEC_FUNC(max, details::max)
+DEF_VEC_FUNC(min, details::min)
+DEF_VEC_FUNC(clamp, details::clamp)
 DEF_VEC_FUNC(mod, details::mod)
-DEF_VEC_FUNC(pow, std::pow)
-DEF_VEC_FUNC(round, std::round)
+DEF_VEC_FUNC_PACKED(pow, std::pow, details::vmath::Pow)
+DEF_VEC_FUNC(round, details::round)
 DEF_VEC_FUNC(sign, details::sign)
 DEF_VEC_FUNC(smoothstep, details::smoothstep)
-DEF_VEC_FUNC(sqrt, std::sqrt)
+DEF_VEC_FUNC(sqrt, details::sqrt)
 DEF_VEC_FUNC(inversesqrt, details::inversesqrt)
 DEF_VEC_FUNC(step, details::step)
-DEF_VEC_FUNC(trunc, std::trunc)
+DEF_VEC_FUNC(trunc, details::trunc)
 DEF_VEC_FUNC(faceforward, details::faceforward)
 DEF_VEC_FUNC(mix, details::mix)
+DEF_VEC_FUNC(fma, details::fma)
 
-template<concepts::Vector T>
-constexpr auto mix(const T& x, const T& y) {
-    constexpr auto rx = x[1] * y[2] - x[2] * y[1];
-    constexpr auto ry = x[2] * y[0] - x[0] * y[2];
-    constexpr auto rz = x[0] * y[1] - x[1] * y[0];
+template<concepts::Vector T> requires (traits::vector_trait<T>::size == 3)
+constexpr auto cross(const T& x, const T& y) {
+    auto rx = x[1] * y[2] - x[2] * y[1];
+    auto ry = x[2] * y[0] - x[0] * y[2];
+    auto rz = x[0] * y[1] - x[1] * y[0];
     return T(rx, ry, rz);
 }
 
 template<class T>
 constexpr auto dot(const T& x, const T& y) {
     if constexpr (concepts::Vector<T>) {
-        decltype(dot(x[0], y[0])) result(0);
+        if constexpr (requires { T::TraitType::dot(x, y); }) {
+            if (!std::is_constant_evaluated())
+                return T::TraitType::dot(x, y);
+        }
+        using Result = decltype(dot(x[0], y[0]));
+        Result result(0);
         details::vector_foreach<T>([&](size_t index) {
-            result += dot(x[index], y[index]);
+            if constexpr (concepts::Vector<std::remove_cvref_t<decltype(x[index])>>) {
+                result += dot(x[index], y[index]);
+            } else {
+                result = details::fma(Result(x[index]), Result(y[index]), result);
+            }
         });
         return result;
     } else {
@@ -183,14 +306,59 @@ constexpr auto distance(const T& x, const T& y) {
 
 template<class T>
 constexpr auto normalize(const T& x) {
-    return x * glsl::inversesqrt(glsl::dot(x, x));
+    if constexpr (requires { T::TraitType::normalize(x); }) {
+        if (!std::is_constant_evaluated())
+            return T::TraitType::normalize(x);
+    }
+    // The vector type of T, a swizzle normalizes to the Vector it selects.
+    return traits::vector_of_t<T>(x * glsl::inversesqrt(glsl::dot(x, x)));
 }
 
 template<class T>
 constexpr auto reflect(const T& x, const T& n) {
-    return x - 2.0 * glsl::dot(n, x) * n;
+    if constexpr (details::expr::Expression<T>) {
+        return glsl::reflect(x.eval(), n.eval());
+    } else {
+        auto d = glsl::dot(n, x);
+        return glsl::fma(T(decltype(d)(-2) * d), n, x);
+    }
+}
+
+template<concepts::Vector T> requires concepts::Scalar<typename T::VectorItem>
+constexpr auto faceforward(const T& n, const T& i, const T& nref) {
+    if constexpr (details::expr::Expression<T>) {
+        return glsl::faceforward(n.eval(), i.eval(), nref.eval());
+    } else {
+        auto front = glsl::dot(nref, i) < 0;
+        T result;
+        details::vector_foreach<T>([&](size_t k) {
+            result[k] = details::select(front, n[k], -n[k]);
+        });
+        return result;
+    }
 }
 
+#if GLSL_EXPR_TEMPLATES
+
+// A lazy expression next to another vector type is evaluated first, expressions of one type stay lazy.
+template<class T, class U> requires details::expr::Mixed<T, U>
+constexpr auto dot(const T& x, const U& y) {
+    return glsl::dot(details::expr::evaluate(x), details::expr::evaluate(y));
+}
+
+template<class T, class U> requires details::expr::Mixed<T, U>
+constexpr auto distance(const T& x, const U& y) {
+    return glsl::length(x - y);
+}
+
+template<class T, class U> requires details::expr::Mixed<T, U>
+constexpr auto reflect(const T& x, const U& n) {
+    using V = decltype(details::expr::evaluate(x));
+    return V(glsl::reflect(details::expr::evaluate(x), details::expr::evaluate(n)));
+}
+
+#endif
+
 template<class T>
 constexpr bool all(const T& x) {
     if constexpr (concepts::Vector<T>) {
@@ -199,6 +367,12 @@ constexpr bool all(const T& x) {
             result &= all(x[index]);
         });
         return result;
+    } else if constexpr (concepts::Batch<T>) {
+        bool result = true;
+        T::foreachLane([&](size_t index) {
+            result &= bool(x[index]);
+        });
+        return result;
     } else {
         return bool(x);
     }
@@ -212,6 +386,12 @@ constexpr bool any(const T& x) {
             result |= all(x[index]);
         });
         return result;
+    } else if constexpr (concepts::Batch<T>) {
+        bool result = false;
+        T::foreachLane([&](size_t index) {
+            result |= bool(x[index]);
+        });
+        return result;
     } else {
         return bool(x);
     }
@@ -225,5 +405,6 @@ DEF_VEC_FUNC(lessThan, details::lessThan)
 DEF_VEC_FUNC(lessThanEqual, details::lessThanEqual)
 
 #undef DEF_VEC_FUNC
+#undef DEF_VEC_FUNC_PACKED
 
 } // namespace glsl
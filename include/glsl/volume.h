@@ -0,0 +1,345 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <stdexcept>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "vector.h"
+#include "texture.h"
+#include "details/parallel.h"
+
+namespace glsl {
+
+namespace details::volume {
+
+// Texels per brick side: a 16^3 brick is 4096 texels, whole pages for any texel size, paged in as one.
+constexpr int brick = 16;
+
+// The header takes the first page, bricks start page aligned.
+constexpr size_t page = 4096;
+
+struct Header {
+    char magic[8];
+    uint32_t texel;
+    uint32_t brick;
+    uint32_t width, height, depth;
+};
+
+constexpr char magic[8] = "GLSLVOL";
+
+// The Z-order of a texel inside its brick: the bits of x, y and z interleaved.
+constexpr size_t morton(int x, int y, int z) {
+    auto spread = [](unsigned v) { return (v & 1) | (v & 2) << 2 | (v & 4) << 4 | (v & 8) << 6; };
+    return spread(unsigned(x)) | spread(unsigned(y)) << 1 | spread(unsigned(z)) << 2;
+}
+
+// A side of a volume: not empty, and small enough that wrapping (mirrored_repeat works on twice the side)
+// stays within int.
+constexpr bool valid(uint32_t side) {
+    return side > 0 && side <= (1u << 30);
+}
+
+// Lookups between the gather of a coordinate and its use.
+constexpr size_t ahead = 8;
+
+/**
+ * Stable LSD radix sort of brick << 32 | lookup keys on the bits of the brick, 11 at a time: a pass or two
+ * over the keys where std::sort compares them log n times.
+ */
+inline void sort_bricks(std::vector<uint64_t>& keys, unsigned bits) {
+    std::vector<uint64_t> sorted(keys.size());
+    for (unsigned shift = 32; shift < 32 + bits; shift += 11) {
+        std::array<size_t, 2048> offsets{};
+        for (uint64_t key : keys)
+            ++offsets[(key >> shift) & 2047];
+        size_t sum = 0;
+        for (size_t& offset : offsets)
+            sum += std::exchange(offset, sum);
+        for (uint64_t key : keys)
+            sorted[offsets[(key >> shift) & 2047]++] = key;
+        keys.swap(sorted);
+    }
+}
+
+} // namespace details::volume
+
+/**
+ * A 3D texture memory-mapped read-only from a file, for volumes larger than RAM: the file is cut into 16^3
+ * bricks with their texels in Z-order, and the pages of a brick are read in by the operating system the
+ * first time a lookup touches it (and dropped again under memory pressure). The trilinear footprint of a
+ * lookup stays within one brick but at its faces, so scattered lookups fault in few pages; the span form of
+ * texture sorts them by brick first. Files are written by Texture3D<T>::create, for the texel type and the
+ * build they are read back with (a mismatch throws). Volumes have no mip chain: they are sampled with
+ * sampler.magFilter and wrapped with wrapS, wrapT and wrapR. POSIX only, so not part of glsl.h.
+ */
+template<concepts::Texel T>
+class Texture3D {
+    static_assert(std::is_trivially_copyable_v<T>);
+
+public:
+    using TexelType = T;
+    using SampleType = details::texture::sample_t<T>;
+
+    Sampler sampler;
+
+    /**
+     * Writes a width x height x depth volume to path one brick at a time, texel(ivec3) -> T called for every
+     * texel, so the volume never has to fit in memory.
+     */
+    template<class Texel>
+    static void create(const std::filesystem::path& path, const Vector<unsigned, 3>& size, const Texel& texel) {
+        using details::volume::brick;
+
+        if (!details::volume::valid(size.x) || !details::volume::valid(size.y) || !details::volume::valid(size.z))
+            throw std::runtime_error("glsl::Texture3D: cannot write an empty or oversized volume to " + path.string());
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        details::volume::Header header{};
+        std::memcpy(header.magic, details::volume::magic, sizeof(header.magic));
+        header.texel = uint32_t(sizeof(T));
+        header.brick = uint32_t(brick);
+        header.width = size.x;
+        header.height = size.y;
+        header.depth = size.z;
+        std::vector<char> first(details::volume::page);
+        std::memcpy(first.data(), &header, sizeof(header));
+        file.write(first.data(), std::streamsize(first.size()));
+
+        std::vector<T> texels(brick * brick * brick);
+        Vector<int, 3> grid = (Vector<int, 3>(size) + (brick - 1)) / brick;
+        for (int bz = 0; bz < grid.z; ++bz) {
+            for (int by = 0; by < grid.y; ++by) {
+                for (int bx = 0; bx < grid.x; ++bx) {
+                    std::fill(texels.begin(), texels.end(), T());
+                    for (int z = 0; z < brick; ++z) {
+                        for (int y = 0; y < brick; ++y) {
+                            for (int x = 0; x < brick; ++x) {
+                                Vector<int, 3> p(bx * brick + x, by * brick + y, bz * brick + z);
+                                if (all(lessThan(p, Vector<int, 3>(size))))
+                                    texels[details::volume::morton(x, y, z)] = T(texel(p));
+                            }
+                        }
+                    }
+                    file.write(reinterpret_cast<const char*>(texels.data()), std::streamsize(texels.size() * sizeof(T)));
+                }
+            }
+        }
+        if (!file.flush())
+            throw std::runtime_error("glsl::Texture3D: cannot write " + path.string());
+    }
+
+    /**
+     * Maps a volume written by create.
+     */
+    explicit Texture3D(const std::filesystem::path& path, const Sampler& sampler = {}) : sampler(sampler) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            throw std::system_error(errno, std::generic_category(), "glsl::Texture3D: cannot open " + path.string());
+        struct stat status;
+        if (::fstat(fd, &status) == 0 && size_t(status.st_size) >= details::volume::page) {
+            length = size_t(status.st_size);
+            void* mapped = ::mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+            base = mapped == MAP_FAILED ? nullptr : static_cast<const char*>(mapped);
+        }
+        ::close(fd);
+        if (!base)
+            throw std::runtime_error("glsl::Texture3D: cannot map " + path.string());
+
+        details::volume::Header header;
+        std::memcpy(&header, base, sizeof(header));
+        if (!details::volume::valid(header.width) || !details::volume::valid(header.height) ||
+            !details::volume::valid(header.depth)) {
+            unmap();
+            throw std::runtime_error("glsl::Texture3D: " + path.string() + " is not a volume of this texel type");
+        }
+        extent = Vector<int, 3>(int(header.width), int(header.height), int(header.depth));
+        grid = (extent + (details::volume::brick - 1)) / details::volume::brick;
+        size_t expected = details::volume::page + bricks() * brick_size;
+        if (std::memcmp(header.magic, details::volume::magic, sizeof(header.magic)) != 0 ||
+            header.texel != sizeof(T) || header.brick != uint32_t(details::volume::brick) || length < expected) {
+            unmap();
+            throw std::runtime_error("glsl::Texture3D: " + path.string() + " is not a volume of this texel type");
+        }
+        texels = reinterpret_cast<const T*>(base + details::volume::page);
+    }
+
+    Texture3D(Texture3D&& other) noexcept
+        : sampler(other.sampler), base(std::exchange(other.base, nullptr)), length(other.length),
+          texels(other.texels), extent(other.extent), grid(other.grid) {}
+
+    Texture3D& operator=(Texture3D&& other) noexcept {
+        if (this != &other) {
+            unmap();
+            sampler = other.sampler;
+            base = std::exchange(other.base, nullptr);
+            length = other.length;
+            texels = other.texels;
+            extent = other.extent;
+            grid = other.grid;
+        }
+        return *this;
+    }
+
+    ~Texture3D() {
+        unmap();
+    }
+
+    Vector<int, 3> size() const {
+        return extent;
+    }
+
+    const T& fetch(const Vector<int, 3>& p) const {
+        assert(all(greaterThanEqual(p, Vector<int, 3>(0))) && all(lessThan(p, extent)));
+        return texels[index(p.x, p.y, p.z)];
+    }
+
+    /**
+     * Bricks in the file, the keys brick(uvw) returns are below it.
+     */
+    size_t bricks() const {
+        return size_t(grid.x) * size_t(grid.y) * size_t(grid.z);
+    }
+
+    /**
+     * The brick of the first texel of the footprint of uvw, what the span form of texture sorts by.
+     */
+    size_t brick(const Vector<float, 3>& uvw) const {
+        using details::volume::brick;
+        Vector<int, 3> p = corner(uvw);
+        return (size_t(p.z / brick) * size_t(grid.y) + size_t(p.y / brick)) * size_t(grid.x) + size_t(p.x / brick);
+    }
+
+    /**
+     * The filtered sample at uvw, what texture returns.
+     */
+    SampleType sample(const Vector<float, 3>& uvw) const {
+        using details::texture::wrap;
+        float x = uvw.x * float(extent.x), y = uvw.y * float(extent.y), z = uvw.z * float(extent.z);
+        if (sampler.magFilter == Filter::nearest) {
+            return texel(wrap(details::texture::cell(x), extent.x, sampler.wrapS),
+                         wrap(details::texture::cell(y), extent.y, sampler.wrapT),
+                         wrap(details::texture::cell(z), extent.z, sampler.wrapR));
+        }
+
+        x -= 0.5f;
+        y -= 0.5f;
+        z -= 0.5f;
+        int x0 = details::texture::cell(x), y0 = details::texture::cell(y), z0 = details::texture::cell(z);
+        Compute ax = Compute(x - std::floor(x)), ay = Compute(y - std::floor(y)), az = Compute(z - std::floor(z));
+        // The eight texels wrapped one axis at a time.
+        int x1 = wrap(x0 + 1, extent.x, sampler.wrapS), y1 = wrap(y0 + 1, extent.y, sampler.wrapT);
+        int z1 = wrap(z0 + 1, extent.z, sampler.wrapR);
+        x0 = wrap(x0, extent.x, sampler.wrapS);
+        y0 = wrap(y0, extent.y, sampler.wrapT);
+        z0 = wrap(z0, extent.z, sampler.wrapR);
+        auto plane = [&](int slice) {
+            return details::texture::lerp(details::texture::lerp(texel(x0, y0, slice), texel(x1, y0, slice), ax),
+                                          details::texture::lerp(texel(x0, y1, slice), texel(x1, y1, slice), ax), ay);
+        };
+        return details::texture::lerp(plane(z0), plane(z1), az);
+    }
+
+private:
+    using Compute = details::texture::compute_t<T>;
+
+    static constexpr size_t brick_size =
+        size_t(details::volume::brick) * details::volume::brick * details::volume::brick * sizeof(T);
+
+    const char* base = nullptr;
+    size_t length = 0;
+    const T* texels = nullptr;
+    Vector<int, 3> extent, grid;
+
+    void unmap() {
+        if (base)
+            ::munmap(const_cast<char*>(base), length);
+        base = nullptr;
+    }
+
+    // Of a texel inside the volume, so the divisions are shifts.
+    size_t index(int x, int y, int z) const {
+        constexpr unsigned brick = details::volume::brick;
+        unsigned ux = unsigned(x), uy = unsigned(y), uz = unsigned(z);
+        size_t b = (size_t(uz / brick) * size_t(grid.y) + uy / brick) * size_t(grid.x) + ux / brick;
+        return b * (brick * brick * brick) + details::volume::morton(int(ux % brick), int(uy % brick), int(uz % brick));
+    }
+
+    SampleType texel(int x, int y, int z) const {
+        return SampleType(texels[index(x, y, z)]);
+    }
+
+    // The wrapped texel a lookup starts from.
+    Vector<int, 3> corner(const Vector<float, 3>& uvw) const {
+        float shift = sampler.magFilter == Filter::nearest ? 0.0f : 0.5f;
+        return Vector<int, 3>(
+            details::texture::wrap(details::texture::cell(uvw.x * float(extent.x) - shift), extent.x, sampler.wrapS),
+            details::texture::wrap(details::texture::cell(uvw.y * float(extent.y) - shift), extent.y, sampler.wrapT),
+            details::texture::wrap(details::texture::cell(uvw.z * float(extent.z) - shift), extent.z, sampler.wrapR));
+    }
+};
+
+/**
+ * The GLSL texture, texelFetch and textureSize builtins on a Texture3D (which has a single level).
+ */
+template<class T>
+typename Texture3D<T>::SampleType texture(const Texture3D<T>& tex, const Vector<float, 3>& uvw) {
+    return tex.sample(uvw);
+}
+
+template<class T>
+typename Texture3D<T>::SampleType texelFetch(const Texture3D<T>& tex, const Vector<int, 3>& p, int lod) {
+    assert(lod == 0);
+    return typename Texture3D<T>::SampleType(tex.fetch(p));
+}
+
+template<class T>
+Vector<int, 3> textureSize(const Texture3D<T>& tex, int lod) {
+    assert(lod == 0);
+    return tex.size();
+}
+
+/**
+ * texture of a span of coordinates, out[i] the sample at uvw[i]. The lookups are sorted by brick and run in
+ * that order, split across the threads of the shared pool, so each brick is paged in and walked once per
+ * batch however scattered the coordinates are. Scattered lookups into a 200 MB volume run twice as fast as
+ * a loop even when it is all in memory; a volume that fits in the caches is better sampled in a loop.
+ */
+template<class T>
+void texture(const Texture3D<T>& tex, std::span<const Vector<float, 3>> uvw,
+             std::span<typename Texture3D<T>::SampleType> out) {
+    assert(out.size() >= uvw.size() && uvw.size() <= UINT32_MAX);
+
+    // The brick in the high bits, the lookup in the low ones.
+    std::vector<uint64_t> order(uvw.size());
+    details::parallel::for_each_chunk(uvw.size(), details::texture::grain, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+            order[i] = uint64_t(tex.brick(uvw[i])) << 32 | i;
+    });
+    details::volume::sort_bricks(order, unsigned(std::bit_width(tex.bricks() - 1)));
+
+    details::parallel::for_each_chunk(order.size(), details::texture::grain, [&](size_t begin, size_t end) {
+        for (size_t k = begin; k < end; ++k) {
+            // The coordinates are gathered in brick order, ask for them ahead.
+            if (k + details::volume::ahead < end)
+                __builtin_prefetch(&uvw[size_t(order[k + details::volume::ahead] & UINT32_MAX)]);
+            size_t i = size_t(order[k] & UINT32_MAX);
+            out[i] = tex.sample(uvw[i]);
+        }
+    });
+}
+
+} // namespace glsl
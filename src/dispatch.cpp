@@ -0,0 +1,21 @@
+/**
+ * The glsl_dispatch library (cmake -DGLSL_DISPATCH_LIBRARY=ON): CPU detection and the AVX2/AVX-512 bulk
+ * kernels are compiled once here, translation units including the headers only call into them.
+ */
+#define GLSL_DISPATCH_IMPLEMENTATION 1
+#include <glsl/glsl.h>
+
+#if GLSL_DISPATCH
+
+#define GLSL_INSTANTIATE_TRANSFORM(isa, T)                                                                  \
+template size_t glsl::details::isa::transform<T, 3, 3, 1>(const T* in, const T* m, T* out, size_t count); \
+template size_t glsl::details::isa::transform<T, 3, 3, 0>(const T* in, const T* m, T* out, size_t count); \
+template size_t glsl::details::isa::transform<T, 3, 4, 1>(const T* in, const T* m, T* out, size_t count); \
+template size_t glsl::details::isa::transform<T, 4, 4, 0>(const T* in, const T* m, T* out, size_t count); \
+
+GLSL_INSTANTIATE_TRANSFORM(avx2, float)
+GLSL_INSTANTIATE_TRANSFORM(avx2, double)
+GLSL_INSTANTIATE_TRANSFORM(avx512, float)
+GLSL_INSTANTIATE_TRANSFORM(avx512, double)
+
+#endif
@@ -0,0 +1,82 @@
+# Checks the disassembly of the codegen probes against the CODEGEN annotations of their source.
+#
+# usage: cmake -DOBJDUMP=<objdump> -DOBJECTS=<object files> -DSOURCE=<probes.cpp> -P check.cmake
+
+execute_process(COMMAND ${OBJDUMP} -d --no-show-raw-insn -C ${OBJECTS}
+                OUTPUT_VARIABLE disassembly
+                RESULT_VARIABLE result)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "${OBJDUMP} failed: ${result}")
+endif()
+
+# Collect the instructions of every function, padding nops excluded.
+string(REPLACE ";" "," disassembly "${disassembly}")
+string(REPLACE "\n" ";" lines "${disassembly}")
+set(function "")
+foreach(line IN LISTS lines)
+    if(line MATCHES "^[0-9a-f]+ <([^>]+)>:$")
+        set(function "${CMAKE_MATCH_1}")
+        set(code_${function} "")
+    elseif(function AND line MATCHES "^ *[0-9a-f]+:\t(.*)$")
+        set(instruction "${CMAKE_MATCH_1}")
+        if(NOT instruction MATCHES "^(nop|xchg +%ax,%ax|cs nop|data16)")
+            list(APPEND code_${function} "${instruction}")
+        endif()
+    endif()
+endforeach()
+
+file(STRINGS ${SOURCE} annotations REGEX "CODEGEN [A-Za-z0-9_]+:")
+set(failures 0)
+foreach(annotation IN LISTS annotations)
+    string(REGEX MATCH "CODEGEN ([A-Za-z0-9_]+):(.*)$" _ "${annotation}")
+    set(probe "${CMAKE_MATCH_1}")
+    set(options "${CMAKE_MATCH_2}")
+
+    if(NOT DEFINED code_${probe})
+        message(SEND_ERROR "${probe}: not found in the disassembly")
+        math(EXPR failures "${failures} + 1")
+        continue()
+    endif()
+
+    set(code "${code_${probe}}")
+    list(LENGTH code count)
+    list(JOIN code "\n" listing)
+    set(errors "")
+
+    if(options MATCHES "max=([0-9]+)" AND count GREATER CMAKE_MATCH_1)
+        list(APPEND errors "${count} instructions, expected at most ${CMAKE_MATCH_1}")
+    endif()
+
+    set(required "")
+    if(options MATCHES "require=([^ ]+)")
+        string(REPLACE "," ";" required "${CMAKE_MATCH_1}")
+    endif()
+    foreach(opcode IN LISTS required)
+        if(NOT listing MATCHES "${opcode}")
+            list(APPEND errors "missing ${opcode}")
+        endif()
+    endforeach()
+
+    set(forbidden "call" "__throw_out_of_range" "std::array<[^>]*>::at")
+    if(options MATCHES "forbid=([^ ]+)")
+        string(REPLACE "," ";" extra "${CMAKE_MATCH_1}")
+        list(APPEND forbidden ${extra})
+    endif()
+    foreach(pattern IN LISTS forbidden)
+        if(listing MATCHES "${pattern}")
+            list(APPEND errors "contains ${pattern}")
+        endif()
+    endforeach()
+
+    if(errors)
+        list(JOIN errors "; " errors)
+        message(SEND_ERROR "${probe}: ${errors}\n${listing}")
+        math(EXPR failures "${failures} + 1")
+    else()
+        message(STATUS "${probe}: ${count} instructions")
+    endif()
+endforeach()
+
+if(failures GREATER 0)
+    message(FATAL_ERROR "${failures} codegen probe(s) failed")
+endif()
@@ -0,0 +1,38 @@
+#include <glsl/glsl.h>
+
+/**
+ * Probes of the fused builtins, built with -mfma (FP_FAST_FMA and FP_FAST_FMAF defined) and checked by
+ * check.cmake like probes.cpp: fma, mix, dot and smoothstep must contract to vfmadd on FMA hardware. The
+ * object is only disassembled, never run, so the test machine needs no FMA support.
+ */
+
+using namespace glsl;
+
+extern "C" {
+
+// CODEGEN vec4_fma: max=18 require=vfmadd forbid=vmulps
+void vec4_fma(vec4* out, const vec4* a, const vec4* b, const vec4* c) {
+    *out = fma(*a, *b, *c);
+}
+
+// CODEGEN dvec2_fma: max=10 require=vfmadd forbid=vmulpd
+void dvec2_fma(dvec2* out, const dvec2* a, const dvec2* b, const dvec2* c) {
+    *out = fma(*a, *b, *c);
+}
+
+// CODEGEN vec4_mix: max=10 require=vfmadd
+void vec4_mix(vec4* out, const vec4* x, const vec4* y, const vec4* a) {
+    *out = mix(*x, *y, *a);
+}
+
+// CODEGEN vec4_dot_fused: max=14 require=vfmadd
+float vec4_dot_fused(const vec4* a, const vec4* b) {
+    return dot(*a, *b);
+}
+
+// CODEGEN vec4_smoothstep: max=80 require=vfmadd
+void vec4_smoothstep(vec4* out, const vec4* edge0, const vec4* edge1, const vec4* x) {
+    *out = smoothstep(*edge0, *edge1, *x);
+}
+
+}
@@ -0,0 +1,81 @@
+#include <glsl/glsl.h>
+
+/**
+ * Probe functions inspected by check.cmake after an -O2 build.
+ * Each `CODEGEN <function>:` line lists the expectations of the probe that follows it:
+ * max=<instructions> (padding excluded), require=<regex>[,<regex>] and forbid=<regex>[,<regex>].
+ * Calls, std::array::at and __throw_out_of_range are forbidden for every probe.
+ */
+
+using namespace glsl;
+
+using simd_vec4 = Vector<float, 4, SimdVectorTrait>;
+
+extern "C" {
+
+// CODEGEN vec4_add: max=6 require=addps
+void vec4_add(vec4* out, const vec4* a, const vec4* b) {
+    *out = *a + *b;
+}
+
+// CODEGEN vec4_mul_scalar: max=7 require=mulps
+void vec4_mul_scalar(vec4* out, const vec4* a, float s) {
+    *out = *a * s;
+}
+
+// CODEGEN vec4_dot: max=14 require=(mulss|fmadd[0-9]*ss) forbid=divss
+float vec4_dot(const vec4* a, const vec4* b) {
+    return dot(*a, *b);
+}
+
+// CODEGEN simd_vec4_dot: max=10 require=mulps
+float simd_vec4_dot(const simd_vec4* a, const simd_vec4* b) {
+    return dot(*a, *b);
+}
+
+// CODEGEN vec4_swizzle_assign: max=9
+void vec4_swizzle_assign(vec4* v, const vec4* u) {
+    v->zyxw = *u;
+}
+
+// CODEGEN vec4_from_vec3: max=9
+void vec4_from_vec3(vec4* out, const vec3* v, float w) {
+    *out = vec4(*v, w);
+}
+
+// CODEGEN uvec4_bitCount: max=28 require=paddd,psrld
+void uvec4_bitCount(ivec4* out, const uvec4* v) {
+    *out = bitCount(*v);
+}
+
+// CODEGEN uvec4_uaddCarry: max=18 require=paddd,psrld
+void uvec4_uaddCarry(uvec4* out, uvec4* carry, const uvec4* a, const uvec4* b) {
+    *out = uaddCarry(*a, *b, *carry);
+}
+
+// CODEGEN uvec4_umulExtended: max=22 require=pmuludq
+void uvec4_umulExtended(uvec4* msb, uvec4* lsb, const uvec4* a, const uvec4* b) {
+    umulExtended(*a, *b, *msb, *lsb);
+}
+
+// CODEGEN float_radians: max=3 require=mulss forbid=cvtss2sd,mulsd
+float float_radians(float degrees) {
+    return radians(degrees);
+}
+
+// CODEGEN float_degrees: max=3 require=mulss forbid=cvtss2sd,mulsd
+float float_degrees(float radians) {
+    return degrees(radians);
+}
+
+// CODEGEN quad_dFdx: max=7 require=shufps,subps
+void quad_dFdx(Quad<float>* out, const Quad<float>* q) {
+    *out = dFdx(*q);
+}
+
+// CODEGEN mat4_mul_vec4: max=24 require=mulps,(addps|fmadd[0-9]*ps)
+void mat4_mul_vec4(vec4* out, const mat4* m, const vec4* v) {
+    *out = *m * *v;
+}
+
+}
@@ -0,0 +1,230 @@
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <glsl/glsl.h>
+#include "bench.h"
+
+using namespace glsl;
+using namespace glsl::bench;
+
+/**
+ * Performance regression gate.
+ * Every kernel is timed against a hand-written scalar loop doing the same work in the same process,
+ * the ratio (library / reference) is compared with the checked-in baseline so the gate does not
+ * depend on the speed of the machine. A kernel fails when its ratio exceeds baseline * tolerance.
+ *
+ * usage: Perf <baseline.csv> [--tolerance=<factor>] [--update]
+ */
+
+namespace {
+
+constexpr size_t Count = 1024;
+
+using raw3 = std::array<float, 3>;
+using raw4 = std::array<float, 4>;
+using raw16 = std::array<float, 16>;
+
+float value(size_t i) {
+    return 0.1f + 0.8f * float((i * 7919u) % 1000u) / 1000.0f;
+}
+
+template<class T>
+std::vector<T> values(size_t seed) {
+    constexpr size_t N = sizeof(T) / sizeof(float);
+    std::vector<T> result(Count);
+    for (size_t i = 0; i < Count; ++i) {
+        float* p = reinterpret_cast<float*>(&result[i]);
+        for (size_t k = 0; k < N; ++k) {
+            p[k] = value(seed + i * N + k) + (N == 16 && k % 5 == 0 ? 2.0f : 0.0f);
+        }
+    }
+    return result;
+}
+
+template<class Out, class Func, class... In>
+Case map_case(Func func, const std::vector<In>&... in) {
+    auto out = std::make_shared<std::vector<Out>>(Count);
+    return { "", "", Count, [=, ...in = in]() {
+        for (size_t i = 0; i < Count; ++i) {
+            (*out)[i] = func(in[i]...);
+        }
+        do_not_optimize(*out->data());
+    } };
+}
+
+raw16 reference_inverse(const raw16& m) {
+    float b00 = m[0] * m[5] - m[1] * m[4], b01 = m[0] * m[6] - m[2] * m[4];
+    float b02 = m[0] * m[7] - m[3] * m[4], b03 = m[1] * m[6] - m[2] * m[5];
+    float b04 = m[1] * m[7] - m[3] * m[5], b05 = m[2] * m[7] - m[3] * m[6];
+    float b06 = m[8] * m[13] - m[9] * m[12], b07 = m[8] * m[14] - m[10] * m[12];
+    float b08 = m[8] * m[15] - m[11] * m[12], b09 = m[9] * m[14] - m[10] * m[13];
+    float b10 = m[9] * m[15] - m[11] * m[13], b11 = m[10] * m[15] - m[11] * m[14];
+
+    float det = 1.0f / (b00 * b11 - b01 * b10 + b02 * b09 + b03 * b08 - b04 * b07 + b05 * b06);
+
+    return {
+        (m[5] * b11 - m[6] * b10 + m[7] * b09) * det, (m[2] * b10 - m[1] * b11 - m[3] * b09) * det,
+        (m[13] * b05 - m[14] * b04 + m[15] * b03) * det, (m[10] * b04 - m[9] * b05 - m[11] * b03) * det,
+        (m[6] * b08 - m[4] * b11 - m[7] * b07) * det, (m[0] * b11 - m[2] * b08 + m[3] * b07) * det,
+        (m[14] * b02 - m[12] * b05 - m[15] * b01) * det, (m[8] * b05 - m[10] * b02 + m[11] * b01) * det,
+        (m[4] * b10 - m[5] * b08 + m[7] * b06) * det, (m[1] * b08 - m[0] * b10 - m[3] * b06) * det,
+        (m[12] * b04 - m[13] * b02 + m[15] * b00) * det, (m[9] * b02 - m[8] * b04 - m[11] * b00) * det,
+        (m[5] * b07 - m[4] * b09 - m[6] * b06) * det, (m[0] * b09 - m[1] * b07 + m[2] * b06) * det,
+        (m[13] * b01 - m[12] * b03 - m[14] * b00) * det, (m[8] * b03 - m[9] * b01 + m[10] * b00) * det,
+    };
+}
+
+struct Kernel {
+    std::string name;
+    Case library;
+    Case reference;
+};
+
+std::vector<Kernel> kernels() {
+    std::vector<Kernel> result;
+
+    {
+        auto a = values<vec4>(1), b = values<vec4>(2), c = values<vec4>(3);
+        auto ra = values<raw4>(1), rb = values<raw4>(2), rc = values<raw4>(3);
+        result.push_back({ "vec4_arithmetic",
+            map_case<vec4>([](const vec4& x, const vec4& y, const vec4& z) { return x * y + z - x / y; }, a, b, c),
+            map_case<raw4>([](const raw4& x, const raw4& y, const raw4& z) {
+                raw4 r;
+                for (size_t i = 0; i < 4; ++i) r[i] = x[i] * y[i] + z[i] - x[i] / y[i];
+                return r;
+            }, ra, rb, rc) });
+    }
+
+    {
+        auto m = values<mat4>(4);
+        auto rm = values<raw16>(4);
+        result.push_back({ "mat4_inverse",
+            map_case<mat4>([](const mat4& x) { return inverse(x); }, m),
+            map_case<raw16>(reference_inverse, rm) });
+
+        auto out = std::make_shared<std::vector<mat4>>(Count);
+        result.push_back({ "mat4_inverse_span",
+            { "", "", Count, [=]() {
+                inverse<mat4>(m, *out);
+                do_not_optimize(*out->data());
+            } },
+            map_case<raw16>(reference_inverse, rm) });
+    }
+
+    {
+        auto points = std::make_shared<std::vector<vec3>>(values<vec3>(5));
+        auto out = std::make_shared<std::vector<vec3>>(Count);
+        auto rpoints = values<raw3>(5);
+        auto rout = std::make_shared<std::vector<raw3>>(Count);
+        mat4 m = values<mat4>(6)[0];
+        raw16 rm = values<raw16>(6)[0];
+
+        result.push_back({ "transform_points",
+            { "", "", Count, [=]() {
+                transform_points(*points, m, *out);
+                do_not_optimize(*out->data());
+            } },
+            { "", "", Count, [=]() {
+                for (size_t i = 0; i < Count; ++i) {
+                    const raw3& p = rpoints[i];
+                    for (size_t k = 0; k < 3; ++k)
+                        (*rout)[i][k] = rm[k] * p[0] + rm[4 + k] * p[1] + rm[8 + k] * p[2] + rm[12 + k];
+                }
+                do_not_optimize(*rout->data());
+            } } });
+    }
+
+    {
+        auto a = values<vec4>(7), b = values<vec4>(8);
+        auto ra = values<raw4>(7), rb = values<raw4>(8);
+        result.push_back({ "swizzle_assignment",
+            map_case<vec4>([](const vec4& x, const vec4& y) {
+                vec4 r(x);
+                r.zyxw = y;
+                return r;
+            }, a, b),
+            map_case<raw4>([](const raw4& x, const raw4& y) {
+                raw4 r(x);
+                r[2] = y[0], r[1] = y[1], r[0] = y[2], r[3] = y[3];
+                return r;
+            }, ra, rb) });
+    }
+
+    return result;
+}
+
+std::map<std::string, double> read_baseline(const std::string& path) {
+    std::map<std::string, double> result;
+    std::ifstream file(path);
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#')
+            continue;
+        auto comma = line.find(',');
+        if (comma == std::string::npos || line.substr(0, comma) == "name")
+            continue;
+        result[line.substr(0, comma)] = std::stod(line.substr(comma + 1));
+    }
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "usage: Perf <baseline.csv> [--tolerance=<factor>] [--update]\n";
+        return 1;
+    }
+
+    std::string path = argv[1];
+    double tolerance = 1.5;
+    bool update = false;
+
+    for (int i = 2; i < argc; ++i) {
+        std::string_view arg = argv[i];
+        if (arg.starts_with("--tolerance=")) {
+            tolerance = std::stod(std::string(arg.substr(12)));
+        } else if (arg == "--update") {
+            update = true;
+        }
+    }
+
+    auto baseline = read_baseline(path);
+    std::ostringstream updated;
+    updated << "# library ns/op divided by a hand-written scalar loop, regenerate with Perf <file> --update\n"
+            << "name,ratio\n";
+
+    bool failed = false;
+    for (const auto& kernel : kernels()) {
+        double library = measure(kernel.library, 0.02, 5);
+        double reference = measure(kernel.reference, 0.02, 5);
+        double ratio = library / reference;
+
+        char line[64];
+        std::snprintf(line, sizeof(line), "%.3f", ratio);
+        updated << kernel.name << ',' << line << '\n';
+
+        auto it = baseline.find(kernel.name);
+        if (update) {
+            std::cout << kernel.name << ": " << line << std::endl;
+        } else if (it == baseline.end()) {
+            std::cout << kernel.name << ": " << line << " (no baseline)" << std::endl;
+            failed = true;
+        } else {
+            bool regressed = ratio > it->second * tolerance;
+            std::cout << kernel.name << ": " << line << " baseline " << it->second << " limit "
+                      << it->second * tolerance << (regressed ? " REGRESSED" : "") << std::endl;
+            failed |= regressed;
+        }
+    }
+
+    if (update) {
+        std::ofstream(path) << updated.str();
+        return 0;
+    }
+    return failed ? 1 : 0;
+}
@@ -1,4 +1,5 @@
 #include "test.h"
+#include "glsl/volume.h"
 
 using namespace glsl;
 using namespace glsl::test;
@@ -22,6 +23,8 @@ static_assert(std::constructible_from<vec4, float, int, double, bool>);
 static_assert(std::constructible_from<vec4, vec2, float, vec2> == false);
 static_assert(std::constructible_from<vec4, vec3, float>);
 static_assert(std::constructible_from<vec4, float, vec2, int>);
+static_assert(vec4(vec3(1, 2, 3), 4) + vec4(1) == vec4(2, 3, 4, 5));
+static_assert(dot(vec2(1, 2), vec2(3, 4)) == 11);
 
 void test_vector_default() {
     CHECK(vec3(1), vec3(1, 1, 1));
@@ -81,6 +84,19 @@ void test_vector_functions() {
 
     CHECK(length(-5), 5);
     CHECK(length(ivec2(3, 4).xy), 5);
+    CHECK(normalize(vec4(3, 7, 4, 0).xzw), vec3(0.6f, 0.8f, 0));
+    CHECK(normalize(dvec3(0, 0, -2).zx), dvec2(-1, 0));
+
+    CHECK(fma(2.0f, 3.0f, 1.0f), 7.0f);
+    CHECK(fma(vec3(1, 2, 3), vec3(2), vec3(1)), vec3(3, 5, 7));
+    CHECK(smoothstep(vec3(0), vec3(2), vec3(-1, 1, 3)), vec3(0, 0.5f, 1));
+    CHECK(reflect(vec3(1, -1, 0), vec3(0, 1, 0)), vec3(1, 1, 0));
+    CHECK(faceforward(vec2(0, 1), vec2(1, -1), vec2(0, 1)), vec2(0, 1));
+    CHECK(faceforward(vec2(0, 1), vec2(-1, 1), vec2(0, 1)), vec2(0, -1));
+#if defined(FP_FAST_FMA) && defined(FP_FAST_FMAF)
+    // (1 + 2^-12)(1 - 2^-12) - 1 is -2^-24 exactly, the unfused product rounds to 1.
+    CHECK(fma(vec2(1 + 0x1p-12f), vec2(1 - 0x1p-12f), vec2(-1)), vec2(-0x1p-24f));
+#endif
 }
 
 void test_matrix() {
@@ -97,12 +113,1048 @@ void test_matrix() {
     CHECK(determinant(mat2(1, 2, 3, 4)), -2.0);
     CHECK(determinant(mat3(vec3(1), vec3(2), vec3(3))), 0.0);
     CHECK(determinant(mat4(3)), 81.0);
+
+    CHECK(mat2(1, 2, 3, 4) * mat2(5, 6, 7, 8), mat2(23, 34, 31, 46));
+    CHECK(mat3(1, 2, 3, 4, 5, 6, 7, 8, 9) * mat3(1, 0, 0, 0, 0, 1, 0, 1, 0), mat3(1, 2, 3, 7, 8, 9, 4, 5, 6));
+    CHECK(mat4(2) * mat4(vec4(1), vec4(2), vec4(3), vec4(4)), mat4(vec4(2), vec4(4), vec4(6), vec4(8)));
+    CHECK(mat4(1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16) * vec4(1, 0, 2, 1), vec4(32, 36, 40, 44));
+    CHECK(mat3x2(1, 2, 3, 4, 5, 6) * vec2(1, 1), vec3(5, 7, 9));
+    CHECK(mat2x3(1, 2, 3, 4, 5, 6) * mat3x2(1, 0, 0, 1, 1, 1), mat2(1, 2, 9, 12));
+    CHECK(vec2(1, 1) * mat2(1, 2, 3, 4), vec2(3, 7));
+    CHECK((Matrix<double, 4, 4>(2) * Vector<double, 4>(1, 2, 3, 4)), (Vector<double, 4>(2, 4, 6, 8)));
+    CHECK((Matrix<float, 3, 3, SimdVectorTrait>(2) * simd_vec3(1, 2, 3)), simd_vec3(2, 4, 6));
+    CHECK(matrixCompMult(mat2(1, 2, 3, 4), mat2(5, 6, 7, 8)), mat2(5, 12, 21, 32));
+    CHECK(fma(mat2(1, 2, 3, 4), mat2(2), mat2(1)), mat2(3, 0, 0, 9));
+    CHECK_BLOCK({
+        mat2 m(1, 2, 3, 4);
+        m *= mat2(0, 1, 1, 0);
+        return m;
+    }, mat2(3, 4, 1, 2));
+
+    using dmat5 = Matrix<double, 5, 5>;
+    using dvec5 = Vector<double, 5>;
+    CHECK(determinant(mat4(0, 1, 0, 0, 1, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 2)), -2.0f);
+    CHECK(lu(mat3(vec3(1), vec3(2), vec3(3))).singular(), true);
+    CHECK(lu(mat3(1, 2, 4, 2, 0, 0, 0, 1, 0)).solve(vec3(5, 5, 4)), vec3(1, 2, 3));
+    CHECK_BLOCK({
+        dmat5 m;
+        for (size_t row = 0; row < 5; ++row) {
+            for (size_t col = 0; col < 5; ++col)
+                m.at(row, col) = row == col ? 0.5 : double(int(row * 3 + col * 7) % 5) - 2;
+        }
+        auto f = lu(m);
+        dmat5 identity = f.inverse() * m;
+        bool inverts = true;
+        for (size_t col = 0; col < 5; ++col)
+            inverts &= all(lessThan(abs(identity[col] - dmat5(1)[col]), dvec5(1e-12)));
+        dvec5 x = f.solve(m * dvec5(1, -2, 3, -4, 5));
+        return inverts && all(lessThan(abs(x - dvec5(1, -2, 3, -4, 5)), dvec5(1e-12))) &&
+               std::abs(f.determinant() - determinant(m)) < 1e-9 && std::abs(determinant(inverse(m)) * f.determinant() - 1) < 1e-12;
+    }, true);
+}
+
+void test_simd_vector() {
+    static_assert(alignof(simd_vec3) == alignof(simd_vec4));
+    static_assert(sizeof(simd_vec3) == sizeof(simd_vec4));
+
+    CHECK(simd_vec4(1, 2, 3, 4) + simd_vec4(1), simd_vec4(2, 3, 4, 5));
+    CHECK(simd_vec4(1, 2, 3, 4) * 2, simd_vec4(2, 4, 6, 8));
+    CHECK(simd_vec3(2, 4, 6) / simd_vec3(2), simd_vec3(1, 2, 3));
+    CHECK(simd_vec3(2, 4, 6) - 1, simd_vec3(1, 3, 5));
+    CHECK(-simd_vec2(1, -2), simd_vec2(-1, 2));
+    CHECK(simd_vec3(1, 2, 3) == simd_vec3(1, 2, 4), false);
+    CHECK(simd_vec3(1, 2, 3).zyx, simd_vec3(3, 2, 1));
+    CHECK_BLOCK({
+        simd_vec4 v(1, 2, 3, 4);
+        v.xw = v.yz * 2;
+        return v;
+    }, simd_vec4(4, 2, 3, 6));
+
+    CHECK(dot(simd_vec3(1, 2, 3), simd_vec3(4, 5, 6)), 32.0f);
+    CHECK(dot(simd_vec3(2, 4, 6) / simd_vec3(2), simd_vec3(1)), 6.0f);
+    CHECK(length(simd_vec4(2)), 4.0f);
+    CHECK(normalize(simd_vec3(0, 3, 0)), simd_vec3(0, 1, 0));
+    CHECK(min(simd_vec4(1, 5, 2, 8), simd_vec4(4, 3, 2, 1)), simd_vec4(1, 3, 2, 1));
+    CHECK(max(simd_vec4(1, 5, 2, 8), simd_vec4(4, 3, 2, 1)), simd_vec4(4, 5, 2, 8));
+    CHECK(clamp(simd_vec3(0, 5, 9), simd_vec3(3), simd_vec3(6)), simd_vec3(3, 5, 6));
+    CHECK(lessThan(simd_vec3(1, 5, 3), simd_vec3(3)), simd_vec3(1, 0, 0));
+    CHECK(sqrt(simd_dvec2(4, 9)), simd_dvec2(2, 3));
+    CHECK(dot(simd_dvec4(1, 2, 3, 4), simd_dvec4(1)), 10.0);
+    CHECK(fma(simd_vec4(1, 2, 3, 4), simd_vec4(2), simd_vec4(1)), simd_vec4(3, 5, 7, 9));
+    CHECK(simd_dvec4(1, 2, 3, 4) * simd_dvec4(2), simd_dvec4(2, 4, 6, 8));
+}
+
+void test_batch() {
+    CHECK(batch4(1, 2, 3, 4) + 1, batch4(2, 3, 4, 5));
+    CHECK(batch4(1, 2, 3, 4) * batch4(2), batch4(2, 4, 6, 8));
+    CHECK(batch4(1, 2, 3, 4) < 3, bbatch4(true, true, false, false));
+    CHECK(ibatch4(7, 8, 9, 10) % 4, ibatch4(3, 0, 1, 2));
+    CHECK(batch8(2) - batch8(0, 1, 2, 3, 4, 5, 6, 7), batch8(2, 1, 0, -1, -2, -3, -4, -5));
+
+    CHECK(batch4_vec3(batch4(1, 2, 3, 4), 0, 1).x, batch4(1, 2, 3, 4));
+    CHECK((batch4_vec3(1, 2, 3) * batch4(1, 2, 3, 4)).z, batch4(3, 6, 9, 12));
+    CHECK(batch4_vec2(batch4_vec3(1, 2, 3).zy).x, batch4(3));
+    CHECK(dot(batch4_vec2(batch4(1, 2, 3, 4), 1), batch4_vec2(2)), batch4(4, 6, 8, 10));
+    CHECK(length(batch4_vec2(batch4(3, 0, 6, 5), batch4(4, 2, 8, 12))), batch4(5, 2, 10, 13));
+    CHECK(normalize(batch4_vec2(batch4(3, 2, 1, 5), 0)).x, batch4(1));
+
+    CHECK(floor(batch4(1.5f, -1.5f, 2, 0.25f)), batch4(1, -2, 2, 0));
+    CHECK(fract(batch4(1.5f, -1.5f, 2, 0.25f)), batch4(0.5f, 0.5f, 0, 0.25f));
+    CHECK(abs(batch4(-1, 2, -3, 4)), batch4(1, 2, 3, 4));
+    CHECK(sign(ibatch4(-5, 0, 5, 1)), ibatch4(-1, 0, 1, 1));
+    CHECK(max(batch4(1, 5, 2, 8), batch4(4)), batch4(4, 5, 4, 8));
+    CHECK(clamp(batch4(0, 5, 9, 4), batch4(3), batch4(6)), batch4(3, 5, 6, 4));
+    CHECK(step(batch4(2), batch4(1, 2, 3, 4)), batch4(0, 1, 1, 1));
+    CHECK(smoothstep(batch4(0), batch4(2), batch4(-1, 1, 2, 3)), batch4(0, 0.5f, 1, 1));
+    CHECK(mix(batch4(0), batch4(4), batch4(0.5f, 2, 0, 1)), batch4(2, 8, 0, 4));
+    CHECK(fma(batch4(1, 2, 3, 4), batch4(2), batch4(1)), batch4(3, 5, 7, 9));
+    CHECK(mix(batch4(0), batch4(4), bbatch4(true, false, true, false)), batch4(4, 0, 4, 0));
+    CHECK(mod(batch4(5, 6, 7, -1), batch4(4)), batch4(1, 2, 3, 3));
+    CHECK(cos(batch4(0, float(pi), 0, float(pi))), batch4(1, -1, 1, -1));
+    CHECK(isnan(batch4(0) / batch4(0, 1, 0, 1)), batch4(1, 0, 1, 0));
+    CHECK(lessThan(batch4_vec2(1, 5), batch4_vec2(batch4(0, 2, 4, 6), 3)).x, batch4(0, 1, 1, 1));
+    CHECK(any(batch4(1, 2, 3, 4) > 3), true);
+    CHECK(all(batch4(1, 2, 3, 4) > 3), false);
+
+    CHECK(determinant(batch4_mat2(batch4(1, 2, 3, 4), 2, 3, 4)), batch4(-2, 2, 6, 10));
+    CHECK(inverse(batch4_mat2(batch4(1, 2, 4, 8), 0, 0, 1))[0].x, batch4(1, 0.5f, 0.25f, 0.125f));
+
+    // Whole vectors and matrices of batches compare equal when every lane of every component does.
+    CHECK(batch4_vec3(batch4(1, 2, 3, 4), 0, 1) * 2.0f, batch4_vec3(batch4(2, 4, 6, 8), batch4(0), batch4(2)));
+    CHECK(batch4_vec2(batch4(1, 2, 3, 4), 0) == batch4_vec2(batch4(1, 2, 3, 5), 0), false);
+    CHECK(batch4_vec2(batch4(1, 2, 3, 4), 0) != batch4_vec2(batch4(1, 2, 3, 4), batch4(0, 0, 1, 0)), true);
+    CHECK(inverse(batch4_mat2(batch4(1, 2, 4, 8), 0, 0, 1)),
+          batch4_mat2(batch4(1, 0.5f, 0.25f, 0.125f), 0, 0, 1));
+    CHECK(batch4_mat2(batch4(1, 2, 3, 4), 2, 3, 4) == batch4_mat2(batch4(1, 2, 3, 4), 2, 3, batch4(4, 4, 4, 0)), false);
+}
+
+void test_transform() {
+    mat4 m(1, 2, 3, 0, 4, 5, 6, 0, 7, 8, 9, 0, 10, 11, 12, 1);
+    std::vector<vec3> points;
+    for (int i = 0; i < 7; ++i)
+        points.emplace_back(i, 2 * i, -i);
+
+    std::vector<vec3> out(points.size());
+    std::vector<vec4> clip(points.size());
+
+    transform_points(points, m, out);
+    CHECK(out[5], vec3(vec4(m * vec4(points[5], 1)).xyz));
+    CHECK(out[6], vec3(vec4(m * vec4(points[6], 1)).xyz));
+
+    transform_vectors(points, m, out);
+    CHECK(out[3], vec3(vec4(m * vec4(points[3], 0)).xyz));
+    CHECK(out[6], vec3(vec4(m * vec4(points[6], 0)).xyz));
+
+    project_points(points, m, clip);
+    CHECK(clip[2], m * vec4(points[2], 1));
+    CHECK(clip[6], m * vec4(points[6], 1));
+
+    transform(clip, mat4(2), clip);
+    CHECK(clip[6], 2 * (m * vec4(points[6], 1)));
+
+    transform_points(points, m, points);
+    CHECK(points[4], vec3(vec4(m * vec4(4, 8, -4, 1)).xyz));
+
+    std::vector<vec4> large(1 << 19, vec4(1, 2, 3, 1));
+    transform(large, m, large);
+    CHECK(large.back(), m * vec4(1, 2, 3, 1));
+
+    std::vector<Vector<double, 3>> dpoints(5, Vector<double, 3>(1, 2, 3));
+    transform_points(dpoints, Matrix<double, 4, 4>(2), dpoints);
+    CHECK(dpoints[4], (Vector<double, 3>(2, 4, 6)));
+
+    // Batched inverses against the scalar ones, 19 matrices cover the packets and the scalar tail.
+    auto close = [](const auto& a, const auto& b) {
+        bool result = true;
+        for (size_t col = 0; col < a.MatrixColumns; ++col)
+            result &= all(lessThan(abs(a[col] - b[col]), decltype(abs(a[col]))(1e-5f)));
+        return result;
+    };
+    std::vector<mat4> matrices;
+    std::vector<mat3> normals;
+    for (int i = 0; i < 19; ++i) {
+        mat4 r = mat4(float(i % 3) + 1) * mat4_cast(quat::angleAxis(float(i), normalize(vec3(1, 2, float(i)))));
+        r[3] = vec4(float(i), 2, -3, 1);
+        matrices.push_back(r);
+        normals.push_back(mat3(r[0].xyz, r[1].xyz, r[2].xyz));
+    }
+    matrices[9] = mat4(1, 2, 3, 4, 2, 4, 6, 8, 0, 1, 0, 0, 0, 0, 0, 1);
+
+    std::vector<mat4> inverses(matrices.size());
+    std::vector<float> determinants(matrices.size());
+    bool singular[19];
+    CHECK(inverse<mat4>(matrices, inverses, singular), 1u);
+    CHECK(singular[9] && !singular[8] && !singular[18], true);
+    CHECK(close(inverses[4], inverse(matrices[4])) && close(inverses[18], inverse(matrices[18])), true);
+    CHECK(close(mat4(inverses[12] * matrices[12]), mat4(1)), true);
+    CHECK(determinant<mat4>(matrices, determinants), 1u);
+    CHECK(std::abs(determinants[17] - determinant(matrices[17])) < 1e-4f && determinants[9] == 0, true);
+
+    std::vector<mat3> normalMatrices(normals.size());
+    CHECK(inverseTranspose<mat3>(normals, normalMatrices), 0u);
+    CHECK(close(normalMatrices[5], transpose(inverse(normals[5]))) && close(normalMatrices[18], transpose(inverse(normals[18]))), true);
+
+    std::vector<Matrix<double, 4, 4>> dmatrices(5, Matrix<double, 4, 4>(4));
+    inverse<Matrix<double, 4, 4>>(dmatrices, dmatrices);
+    CHECK(dmatrices[4], (Matrix<double, 4, 4>(0.25)));
+}
+
+// A wide transform kernel against the scalar product: it covers the whole blocks and leaves the next vector alone.
+template<size_t InSize, size_t OutSize, int W, class T>
+bool wide_matches(size_t (*kernel)(const T*, const T*, T*, size_t), size_t elements) {
+    constexpr size_t count = 11;
+    Matrix<T, 4, 4> m(1, 2, 3, 0, 4, 5, 6, 0, 7, 8, 9, 0, 10, 11, 12, 1);
+    std::vector<Vector<T, InSize>> in(count);
+    std::vector<Vector<T, OutSize>> out(count + 1, Vector<T, OutSize>(-1));
+    for (size_t i = 0; i < count; ++i) {
+        for (size_t k = 0; k < InSize; ++k)
+            in[i][k] = T(int(i * InSize + k) - 7);
+    }
+
+    size_t done = kernel(&in.data()->data[0], &m[0].data[0], &out.data()->data[0], count);
+    bool result = done == count - count % elements && out[done] == Vector<T, OutSize>(-1);
+    for (size_t i = 0; i < done; ++i) {
+        Vector<T, 4> r;
+        if constexpr (InSize == 4) {
+            r = m * in[i];
+        } else {
+            r = m * Vector<T, 4>(in[i], W);
+        }
+        if constexpr (OutSize == 4) {
+            result &= out[i] == r;
+        } else {
+            result &= out[i] == Vector<T, 3>(r[0], r[1], r[2]);
+        }
+    }
+    return result;
+}
+
+void test_dispatch() {
+    CHECK(active_isa() <= details::dispatch::detect_isa(), true);
+    CHECK(details::dispatch::requested_isa(Isa::sse2) == Isa::sse2, true);
+
+#if GLSL_DISPATCH
+    // Every variant the CPU can run, whatever GLSL_ISA selects for the public functions.
+    if (details::dispatch::detect_isa() >= Isa::avx2) {
+        using namespace details::avx2;
+        CHECK((wide_matches<3, 3, 1>(transform<float, 3, 3, 1>, 2)), true);
+        CHECK((wide_matches<3, 3, 0>(transform<float, 3, 3, 0>, 2)), true);
+        CHECK((wide_matches<3, 4, 1>(transform<float, 3, 4, 1>, 2)), true);
+        CHECK((wide_matches<4, 4, 0>(transform<float, 4, 4, 0>, 2)), true);
+        CHECK((wide_matches<3, 3, 1>(transform<double, 3, 3, 1>, 1)), true);
+        CHECK((wide_matches<4, 4, 0>(transform<double, 4, 4, 0>, 1)), true);
+    }
+    if (details::dispatch::detect_isa() >= Isa::avx512) {
+        using namespace details::avx512;
+        CHECK((wide_matches<3, 3, 1>(transform<float, 3, 3, 1>, 4)), true);
+        CHECK((wide_matches<3, 3, 0>(transform<float, 3, 3, 0>, 4)), true);
+        CHECK((wide_matches<3, 4, 1>(transform<float, 3, 4, 1>, 4)), true);
+        CHECK((wide_matches<4, 4, 0>(transform<float, 4, 4, 0>, 4)), true);
+        CHECK((wide_matches<3, 3, 1>(transform<double, 3, 3, 1>, 2)), true);
+        CHECK((wide_matches<4, 4, 0>(transform<double, 4, 4, 0>, 2)), true);
+    }
+#endif
+}
+
+template<class V, class Func, class Ref>
+double max_error(const Func& func, const Ref& ref, double lo, double hi, bool relative = false) {
+    double result = 0;
+    for (int i = 0; i < 4096; i += 4) {
+        auto x = [&](int k) { return lo + (hi - lo) * (i + k) / 4095.0; };
+        V r = func(V(float(x(0)), float(x(1)), float(x(2)), float(x(3))));
+        for (int k = 0; k < 4; ++k) {
+            double expected = ref(double(float(x(k))));
+            double error = std::abs(double(r[size_t(k)]) - expected);
+            result = std::max(result, relative ? error / std::abs(expected) : error);
+        }
+    }
+    return result;
+}
+
+void test_precision() {
+    static_assert(std::same_as<highp::vec4, vec4>);
+    static_assert(mediump::vec3::TraitType::precision == Precision::medium);
+
+    using mvec4 = mediump::vec4;
+    using lvec4 = lowp::vec4;
+    auto sin_ = [](const auto& x) { return sin(x); };
+    auto exp_ = [](const auto& x) { return exp(x); };
+    auto log_ = [](const auto& x) { return log(x); };
+    auto rsqrt_ = [](const auto& x) { return inversesqrt(x); };
+    auto rsqrt = [](double x) { return 1 / std::sqrt(x); };
+    auto std_sin = [](double x) { return std::sin(x); };
+    auto std_exp = [](double x) { return std::exp(x); };
+    auto std_log = [](double x) { return std::log(x); };
+
+    CHECK(max_error<mvec4>(sin_, std_sin, -1e4, 1e4) < 2e-7, true);
+    CHECK(max_error<lvec4>(sin_, std_sin, -1e4, 1e4) < 5e-5, true);
+    CHECK(max_error<mvec4>(exp_, std_exp, -80, 80, true) < 2e-7, true);
+    CHECK(max_error<lvec4>(exp_, std_exp, -80, 80, true) < 1e-4, true);
+    CHECK(max_error<mvec4>(log_, std_log, 1e-3, 1e3) < 2e-7 * std::log(1e3), true);
+    CHECK(max_error<lvec4>(log_, std_log, 1e-3, 1e3) < 5e-6 * std::log(1e3), true);
+    CHECK(max_error<mvec4>(rsqrt_, rsqrt, 1e-6, 1e6, true) < 5e-6, true);
+    CHECK(max_error<lvec4>(rsqrt_, rsqrt, 1e-6, 1e6, true) < 2e-3, true);
+
+    CHECK(distance(pow(mediump::vec3(2, 4, 9), mediump::vec3(3, 0.5f, -0.5f)), mediump::vec3(8, 2, 1 / 3.0f)) < 1e-5f, true);
+    CHECK(distance(normalize(lowp::vec3(3, 0, 4)), lowp::vec3(0.6f, 0, 0.8f)) < 2e-3f, true);
+    CHECK(cos(mediump::vec2(0, float(pi))), mediump::vec2(1, -1));
+    CHECK(exp(mediump::vec4(-1000, 1000, 0, 1)).xyz, mediump::vec3(0, std::numeric_limits<float>::infinity(), 1));
+    CHECK(log(mediump::vec2(0, 1)), mediump::vec2(-std::numeric_limits<float>::infinity(), 0));
+    CHECK(isnan(log(lowp::vec2(-1))), lowp::vec2(1));
+    CHECK(distance(sin(Vector<double, 4, MediumpVectorTrait>(1, 2, 3, 4)), Vector<double, 4, MediumpVectorTrait>(sin(Vector<double, 4>(1, 2, 3, 4)))) < 1e-8, true);
+}
+
+template<class V, class Func, class Ref>
+double max_ulp(const Func& func, const Ref& ref, double lo, double hi) {
+    using T = traits::vector_item_t<V>;
+    constexpr size_t size = traits::vector_trait<V>::size;
+    double result = 0;
+    for (size_t i = 0; i < 4096; i += size) {
+        V x;
+        for (size_t k = 0; k < size; ++k)
+            x[k] = T(lo + (hi - lo) * double(i + k) / 4095.0);
+        V r = func(x);
+        for (size_t k = 0; k < size; ++k) {
+            long double expected = ref(static_cast<long double>(x[k]));
+            int exponent;
+            std::frexp(double(expected), &exponent);
+            exponent = std::max(exponent, std::numeric_limits<T>::min_exponent) - std::numeric_limits<T>::digits;
+            result = std::max(result, double(std::abs(r[k] - expected) / std::ldexp(1.0L, exponent)));
+        }
+    }
+    return result;
+}
+
+// The kernel on a register where one covers V, whether DEF_VEC_FUNC picks it or not, and lane by lane otherwise.
+template<class Kernel, class V, class... Rest>
+V kernel(const Kernel& k, const V& x, const Rest&... rest) {
+    if constexpr (details::simd::packet_supported<traits::vector_item_t<V>, details::vmath::lanes<V>()>) {
+        return details::vmath::map(k, x, rest...);
+    } else {
+        return details::apply(k, x, rest...);
+    }
+}
+
+void test_vmath() {
+    static_assert(details::vmath::vectorizable<details::vmath::Sin, vec3>());
+    static_assert(!details::vmath::vectorizable<details::vmath::Pow, Vector<double, 2>, Vector<double, 2>>());
+    static_assert(details::vmath::vectorizable<details::vmath::Exp, Vector<double, 2>>() ==
+                  details::simd::packet_supported<double, 4>);
+    static_assert(!details::vmath::vectorizable<details::vmath::Sin, ivec4>());
+    static_assert(!details::vmath::vectorizable<void, vec4>());
+
+    auto sin_ = [](const auto& x) { return kernel(details::vmath::Sin(), x); };
+    auto cos_ = [](const auto& x) { return kernel(details::vmath::Cos(), x); };
+    auto tan_ = [](const auto& x) { return kernel(details::vmath::Tan(), x); };
+    auto asin_ = [](const auto& x) { return kernel(details::vmath::Asin(), x); };
+    auto acos_ = [](const auto& x) { return kernel(details::vmath::Acos(), x); };
+    auto exp_ = [](const auto& x) { return kernel(details::vmath::Exp(), x); };
+    auto exp2_ = [](const auto& x) { return kernel(details::vmath::Exp2(), x); };
+    auto log_ = [](const auto& x) { return kernel(details::vmath::Log(), x); };
+    auto log2_ = [](const auto& x) { return kernel(details::vmath::Log2(), x); };
+    auto pow_ = [](const auto& x) { return kernel(details::vmath::Pow(), x, decltype(x)(-2.75)); };
+    auto std_sin = [](long double x) { return std::sin(x); };
+    auto std_cos = [](long double x) { return std::cos(x); };
+    auto std_tan = [](long double x) { return std::tan(x); };
+    auto std_asin = [](long double x) { return std::asin(x); };
+    auto std_acos = [](long double x) { return std::acos(x); };
+    auto std_exp = [](long double x) { return std::exp(x); };
+    auto std_exp2 = [](long double x) { return std::exp2(x); };
+    auto std_log = [](long double x) { return std::log(x); };
+    auto std_log2 = [](long double x) { return std::log2(x); };
+    auto std_pow = [](long double x) { return std::pow(x, -2.75L); };
+
+    using vec8 = Vector<float, 8>;
+
+    CHECK(max_ulp<vec4>(sin_, std_sin, -100, 100) < 2, true);
+    CHECK(max_ulp<vec4>(sin_, std_sin, -1e5, 1e5) < 2, true);
+    CHECK(max_ulp<vec4>(cos_, std_cos, -100, 100) < 2, true);
+    CHECK(max_ulp<vec4>(tan_, std_tan, -100, 100) < 3.5, true);
+    CHECK(max_ulp<vec4>(asin_, std_asin, -1, 1) < 3, true);
+    CHECK(max_ulp<vec4>(acos_, std_acos, -1, 1) < 2, true);
+    CHECK(max_ulp<vec4>(exp_, std_exp, -100, 80) < 1, true);
+    CHECK(max_ulp<vec4>(exp2_, std_exp2, -140, 120) < 1, true);
+    CHECK(max_ulp<vec4>(log_, std_log, 1e-30, 1e30) < 1, true);
+    CHECK(max_ulp<vec4>(log2_, std_log2, 1e-3, 1e3) < 1, true);
+    CHECK(max_ulp<vec4>(pow_, std_pow, 1e-6, 1e6) < 1, true);
+    CHECK(max_ulp<vec8>(sin_, std_sin, -100, 100) < 2, true);
+    CHECK(max_ulp<vec8>(log_, std_log, 1e-3, 1e3) < 1, true);
+
+    CHECK(max_ulp<dvec2>(sin_, std_sin, -1e5, 1e5) < 2, true);
+    CHECK(max_ulp<dvec2>(cos_, std_cos, -100, 100) < 2, true);
+    CHECK(max_ulp<dvec2>(tan_, std_tan, -100, 100) < 3, true);
+    CHECK(max_ulp<dvec2>(asin_, std_asin, -1, 1) < 3, true);
+    CHECK(max_ulp<dvec2>(acos_, std_acos, -1, 1) < 2, true);
+    CHECK(max_ulp<dvec2>(exp_, std_exp, -740, 700) < 1, true);
+    CHECK(max_ulp<dvec2>(exp2_, std_exp2, -1070, 1020) < 1, true);
+    CHECK(max_ulp<dvec2>(log_, std_log, 1e-300, 1e300) < 1, true);
+    CHECK(max_ulp<dvec2>(log2_, std_log2, 1e-3, 1e3) < 1, true);
+    CHECK(max_ulp<dvec2>(pow_, std_pow, 1e-6, 1e6) < 2, true);
+    CHECK(max_ulp<dvec4>(exp_, std_exp, -700, 700) < 1, true);
+    CHECK(max_ulp<dvec4>(pow_, std_pow, 1e-6, 1e6) < 2, true);
+
+    constexpr float inf = std::numeric_limits<float>::infinity();
+    CHECK(exp(vec4(-1000, 1000, 0, -inf)), vec4(0, inf, 1, 0));
+    CHECK(log(vec3(0, 1, inf)), vec3(-inf, 0, inf));
+    CHECK(isnan(log(vec2(-1, std::nanf("")))), bvec2(1, 1));
+    CHECK(isnan(sin(vec2(inf, -inf))), bvec2(1, 1));
+    CHECK(std::signbit(sin(vec2(-0.0f)).x), true);
+    CHECK(sin(vec2(1e7f, 3e9f)), vec2(std::sin(1e7f), std::sin(3e9f)));
+    CHECK(pow(vec4(-2, 0, 4, 1), vec4(3, 2, 0.5f, inf)), vec4(-8, 0, 2, 1));
+    CHECK(pow(dvec2(-2, 0), dvec2(-1, -1)), dvec2(-0.5, std::numeric_limits<double>::infinity()));
+    CHECK(kernel(details::vmath::Pow(), vec4(-2, 0, 4, 1), vec4(3, 2, 0.5f, inf)), vec4(-8, 0, 2, 1));
+    CHECK(distance(log(vec3(1, float(std::numbers::e), float(std::numbers::e * std::numbers::e))), vec3(0, 1, 2)) < 1e-6f, true);
+
+    // Swizzles go through the packed kernels as the vectors they select.
+    vec4 v(0.5f, -1, 2, 0);
+    CHECK(sin(v.xy), sin(vec2(0.5f, -1)));
+    CHECK(exp(v.zyx), exp(vec3(2, -1, 0.5f)));
+    CHECK(pow(v.xyz, vec3(2)), vec3(0.25f, 1, 4));
+    CHECK(pow(v.zzz, v.xyw), pow(vec3(2), vec3(0.5f, -1, 0)));
+    CHECK(log(dvec4(1, 2, 4, 8).wz), log(dvec2(8, 4)));
+}
+
+void test_expr() {
+#if GLSL_EXPR_TEMPLATES
+    static_assert(details::expr::Expression<decltype(vec3() * vec3() + 1)>);
+    static_assert(details::expr::Expression<decltype(vec3x3() + vec3())>);
+    static_assert(!details::expr::Expression<decltype(simd_vec3() + 1)>);
+    static_assert(!details::expr::Expression<decltype(batch4_vec3() + 1)>);
+#endif
+
+    CHECK_BLOCK({
+        vec3 a(1, 2, 3);
+        vec3 b(4, 5, 6);
+        return vec3(a * b + 0.5f - a / 2 * b);
+    }, vec3(2.5f, 5.5f, 9.5f));
+    CHECK_BLOCK({
+        vec3 v(1, 2, 4);
+        v = v + v.zyx;
+        v *= vec3(2) - v.yzx;
+        return v;
+    }, vec3(-10, -12, -15));
+    CHECK_BLOCK({
+        vec3x3 m(1, 2, 3);
+        m = m * m + vec3(1, 0, 0);
+        return m;
+    }, vec3x3(vec3(2, 1, 1), vec3(5, 4, 4), vec3(10, 9, 9)));
+
+    CHECK(dot(vec3(1, 2, 3) * 2, vec3(1)), 12.0f);
+    CHECK(distance(vec3(1, 2, 3) + vec3(2, 2, 0), vec3(0, 0, 3)), 5.0f);
+    CHECK(reflect(vec2(1, 0) - vec2(0, 1), vec2(0, 1)), vec2(1, 1));
+    CHECK(max(vec2(1, 4) * 2, vec2(3)), vec2(3, 8));
+
+#if GLSL_EXPR_TEMPLATES
+    static_assert(!details::product::is_matrix<decltype(mat4() * mat4())>::value);
+    static_assert(details::product::order<mat4, mat4, mat4, vec4>()[0][3] == 0);
+    static_assert(details::product::order<mat4, mat4, mat4, vec4>()[1][3] == 1);
+    static_assert(details::product::order<mat4x2, mat2x4, mat4x2>()[0][2] == 0);
+    static_assert(details::product::order<mat2x4, mat4x2, mat2x4>()[0][2] == 1);
+#endif
+
+    CHECK(mat4(2) * mat4(3) * mat4(1) * vec4(1, 2, 3, 4), vec4(6, 12, 18, 24));
+    CHECK(mat4x2(1) * mat2x4(1) * mat4x2(2), mat4x2(2));
+    CHECK(mat2x4(1) * mat4x2(1) * mat2x4(3), mat2x4(3));
+    CHECK(vec2(1, 1) * (mat2(2) * mat2(3)), vec2(6, 6));
+    CHECK(mat2(1) * mat2(2) + mat2(1), mat2(3));
+    CHECK(2 * (mat2(1) * mat2(3)) - mat2(2) * mat2(1), mat2(4));
+    CHECK_BLOCK({
+        mat2x3 a(1, 2, 3, 4, 5, 6);
+        mat3x2 b(1, 2, 3, 4, 5, 6);
+        return a * b * a * vec3(1, 0, -1);
+    }, vec2(-284, -368));
+    CHECK_BLOCK({
+        mat2 m(1, 2, 3, 4);
+        m = m * m * mat2(2);
+        return m;
+    }, mat2(14, 20, 30, 44));
+}
+
+void test_quaternion() {
+    using simd_quat = Quaternion<float, SimdVectorTrait>;
+    auto near = [](const auto& a, const auto& b) {
+        auto d = abs(a - b);
+        return all(lessThan(d, decltype(d)(1e-5f)));
+    };
+
+    CHECK(quat(1, 2, 3, 4) * quat(5, 6, 7, 8), quat(24, 48, 48, -6));
+    CHECK(simd_quat(1, 2, 3, 4) * simd_quat(5, 6, 7, 8), simd_quat(24, 48, 48, -6));
+    CHECK(quat(1, -1, 1, 1) * inverse(quat(1, -1, 1, 1)), quat());
+    CHECK(conjugate(quat(1, 2, 3, 4)), quat(-1, -2, -3, 4));
+    CHECK(quat(0, 0, 1, 0) * vec3(1, 2, 3), vec3(-1, -2, 3));
+    CHECK(cross(vec3(1, 0, 0), vec3(0, 1, 0)), vec3(0, 0, 1));
+
+    quat q = normalize(quat(1, -2, 3, 4));
+    quat qz = quat::angleAxis(float(pi) / 2, vec3(0, 0, 1));
+    vec3 v(3, -1, 2);
+    CHECK(near(qz * vec3(1, 0, 0), vec3(0, 1, 0)), true);
+    CHECK(near(mat3_cast(q) * v, q * v), true);
+    CHECK(near(vec4(mat4_cast(q) * vec4(v, 1)), vec4(q * v, 1)), true);
+    CHECK(near(quat_cast(mat3_cast(q)).data, q.data), true);
+    CHECK(near(quat_cast(mat4_cast(-qz)).data, qz.data), true);
+    CHECK(near((q * qz) * v, q * (qz * v)), true);
+
+    CHECK(near(slerp(quat(), qz, 0.5f).data, quat::angleAxis(float(pi) / 4, vec3(0, 0, 1)).data), true);
+    CHECK(near(slerp(quat(), -qz, 0.5f).data, quat::angleAxis(float(pi) / 4, vec3(0, 0, 1)).data), true);
+    CHECK(near(slerp(q, q, 0.3f).data, q.data), true);
+    CHECK(near(nlerp(quat(), qz, 0.5f).data, quat::angleAxis(float(pi) / 4, vec3(0, 0, 1)).data), true);
+
+    std::vector<quat> a, b;
+    std::vector<float> t;
+    std::vector<vec3> vectors;
+    for (int i = 0; i < 11; ++i) {
+        a.push_back(quat::angleAxis(0.1f * float(i), normalize(vec3(1, float(i), 2))));
+        b.push_back(quat::angleAxis(-0.3f * float(i), normalize(vec3(float(i), 1, -1))));
+        t.push_back(0.1f * float(i));
+        vectors.emplace_back(i, 1, -i);
+    }
+    b[3] = a[3];
+
+    std::vector<quat> out(a.size());
+    slerp<float>(a, b, t, out);
+    bool slerped = true;
+    for (size_t i = 0; i < a.size(); ++i)
+        slerped &= near(out[i].data, slerp(a[i], b[i], t[i]).data);
+    CHECK(slerped, true);
+
+    std::vector<vec3> turned(vectors.size());
+    rotate<float>(a, vectors, turned);
+    bool rotates = true;
+    for (size_t i = 0; i < a.size(); ++i)
+        rotates &= near(turned[i], a[i] * vectors[i]);
+    CHECK(rotates, true);
+}
+
+void test_packing() {
+    CHECK(packUnorm4x8(vec4(0, 1, 0.5f, -1)), 0x0080ff00u);
+    CHECK(packSnorm4x8(vec4(-1, 1, 0.5f, -2)), 0x81407f81u);
+    CHECK(packUnorm2x16(vec2(1, 0.25f)), 0x4000ffffu);
+    CHECK(packSnorm2x16(vec2(-1, 0.5f)), 0x40008001u);
+    CHECK(unpackUnorm4x8(0x0080ff00u), vec4(0, 1, 128.0f / 255, 0));
+    CHECK(unpackSnorm4x8(0x80407f81u), vec4(-1, 1, 64.0f / 127, -1));
+    CHECK(unpackSnorm2x16(0x40008001u), vec2(-1, 16384.0f / 32767));
+    CHECK(packHalf2x16(vec2(1, -2)), 0xc0003c00u);
+    CHECK(packHalf2x16(vec2(65520.0f, 0x1p-24f)), 0x00017c00u);
+    CHECK(packHalf2x16(vec2(1 + 0x1p-11f, 0x1p-25f)), 0x00003c00u);
+    CHECK(unpackHalf2x16(0xfc000001u), vec2(0x1p-24f, -INFINITY));
+    CHECK(isnan(unpackHalf2x16(packHalf2x16(vec2(NAN, 0))).x), true);
+
+    // The span kernels against the scalar builtins, 37 elements cover the packets and the scalar tail.
+    std::vector<vec4> colors;
+    std::vector<vec2> values;
+    for (int i = 0; i < 37; ++i) {
+        colors.emplace_back(float(i) / 15 - 1.2f, 0.3f * float(i) - 2, float(i) / 37, 1);
+        values.emplace_back(1000.5f * float(i) - 3e3f, 1e-6f * float(i));
+    }
+    std::vector<uint32_t> packed(colors.size());
+    std::vector<vec4> colorsBack(colors.size());
+    std::vector<vec2> valuesBack(values.size());
+    bool matches = true;
+
+    packUnorm4x8(colors, packed);
+    unpackUnorm4x8(packed, colorsBack);
+    for (size_t i = 0; i < colors.size(); ++i)
+        matches &= packed[i] == packUnorm4x8(colors[i]) && colorsBack[i] == unpackUnorm4x8(packed[i]);
+
+    packSnorm4x8(colors, packed);
+    unpackSnorm4x8(packed, colorsBack);
+    for (size_t i = 0; i < colors.size(); ++i)
+        matches &= packed[i] == packSnorm4x8(colors[i]) && colorsBack[i] == unpackSnorm4x8(packed[i]);
+
+    packSnorm2x16(values, packed);
+    unpackUnorm2x16(packed, valuesBack);
+    for (size_t i = 0; i < values.size(); ++i)
+        matches &= packed[i] == packSnorm2x16(values[i]) && valuesBack[i] == unpackUnorm2x16(packed[i]);
+
+    packHalf2x16(values, packed);
+    unpackHalf2x16(packed, valuesBack);
+    for (size_t i = 0; i < values.size(); ++i)
+        matches &= packed[i] == packHalf2x16(values[i]) && valuesBack[i] == unpackHalf2x16(packed[i]);
+
+    CHECK(matches, true);
+}
+
+static_assert(bitCount(0xf0f0u) == 8 && bitCount(-1) == 32);
+static_assert(findLSB(0u) == -1 && findLSB(0x50) == 4);
+static_assert(findMSB(0x80000000u) == 31 && findMSB(-1) == -1 && findMSB(-5) == 2);
+static_assert(bitfieldReverse(0x12345678u) == 0x1e6a2c48u);
+// Empty fields at the top end of the value, offset + bits == 32.
+static_assert(bitfieldExtract(0xffffffffu, 32, 0) == 0u && bitfieldExtract(-1, 32, 0) == 0);
+static_assert(bitfieldInsert(0x12345678u, ~0u, 32, 0) == 0x12345678u);
+
+void test_integer() {
+    CHECK(bitCount(uvec3(7, 0, 0xffffffffu)), ivec3(3, 0, 32));
+    CHECK(findLSB(uvec2(0, 12)), ivec2(-1, 2));
+    CHECK(findMSB(ivec4(0, -1, 5, -6)), ivec4(-1, -1, 2, 2));
+    CHECK(bitfieldExtract(uvec2(0xabcdu, 0xffffffffu), 4, 8), uvec2(0xbc, 0xff));
+    CHECK(bitfieldExtract(ivec3(0xf0, 0x70, -1), 4, 4), ivec3(-1, 7, -1));
+    CHECK(bitfieldExtract(-1, 0, 32), -1);
+    CHECK(bitfieldExtract(5u, 3, 0), 0u);
+    CHECK(bitfieldInsert(uvec2(0xffffu, 0), uvec2(0, ~0u), 4, 8), uvec2(0xf00fu, 0xff0u));
+    CHECK(bitfieldInsert(0u, ~0u, 0, 32), ~0u);
+    CHECK(bitfieldExtract(uvec2(0xffffffffu, 7), 32, 0), uvec2(0));
+    CHECK(bitfieldInsert(ivec2(-1, 5), ivec2(0), 32, 0), ivec2(-1, 5));
+    CHECK(bitfieldExtract(0x80000000u, 31, 1), 1u);
+    CHECK(bitfieldInsert(0u, 1u, 31, 1), 0x80000000u);
+    CHECK(bitfieldReverse(uvec2(1, 0x0f)), uvec2(0x80000000u, 0xf0000000u));
+    CHECK(bitfieldReverse(uint8_t(1)) == 0x80, true);
+
+    CHECK_BLOCK({
+        uvec3 carry;
+        uvec3 sum = uaddCarry(uvec3(0xffffffffu, 1, 0x80000000u), uvec3(1, 2, 0x80000000u), carry);
+        return sum == uvec3(0, 3, 0) && carry == uvec3(1, 0, 1);
+    }, true);
+    CHECK_BLOCK({
+        uvec2 borrow;
+        uvec2 difference = usubBorrow(uvec2(1, 5), uvec2(2, 5), borrow);
+        return difference == uvec2(0xffffffffu, 0) && borrow == uvec2(1, 0);
+    }, true);
+    CHECK_BLOCK({
+        uvec2 msb;
+        uvec2 lsb;
+        umulExtended(uvec2(0xffffffffu, 3), uvec2(0xffffffffu, 5), msb, lsb);
+        return msb == uvec2(0xfffffffeu, 0) && lsb == uvec2(1, 15);
+    }, true);
+    CHECK_BLOCK({
+        int msb;
+        int lsb;
+        imulExtended(1 << 30, -8, msb, lsb);
+        return msb == -2 && lsb == 0;
+    }, true);
+    CHECK_BLOCK({
+        // The out vector aliasing an operand.
+        uvec2 x(0xffffffffu, 7);
+        uvec2 sum = uaddCarry(x, uvec2(1), x);
+        return sum == uvec2(0, 8) && x == uvec2(1, 0);
+    }, true);
+}
+
+void test_half() {
+    static_assert(sizeof(hvec3) == 6 && sizeof(hmat4) == 32 && sizeof(bf16vec4) == 8);
+    static_assert(half(1.0f).bits == 0x3c00 && bfloat16(-2.0f).bits == 0xc000);
+
+    CHECK(half(65520.0f).bits, uint16_t(0x7c00));
+    CHECK(half(1 + 0x1p-11f).bits, uint16_t(0x3c00));
+    CHECK(float(half(0x1p-24f)), 0x1p-24f);
+    CHECK(bfloat16(1 + 0x1p-8f).bits, uint16_t(0x3f80));
+    CHECK(bfloat16(1 + 0x1p-8f + 0x1p-16f).bits, uint16_t(0x3f81));
+    CHECK(float(std::numeric_limits<half>::max()), 65504.0f);
+    CHECK(isnan(float(bfloat16(NAN))), true);
+
+    // Arithmetic widens to float and rounds back on storing.
+    CHECK(hvec3(1, 2, 3) + hvec3(0.5f), hvec3(1.5f, 2.5f, 3.5f));
+    CHECK(hvec3(1, 2, 3).zyx * 2.0f, hvec3(6, 4, 2));
+    CHECK(vec3(hvec3(1.0f / 3)), vec3(0.333251953125f));
+    CHECK(dot(hvec3(1, 2, 3), hvec3(4, 5, 6)), 32.0f);
+    CHECK((std::same_as<decltype(dot(hvec3(1), hvec3(1))), float>), true);
+    CHECK(hmat4(2) * hvec4(1, 2, 3, 4), hvec4(2, 4, 6, 8));
+    CHECK(sqrt(bf16vec2(4, 9)), bf16vec2(2, 3));
+    CHECK(max(hvec2(1, 4), hvec2(3, 2)), hvec2(3, 4));
+
+    // The span kernels against the scalar conversions, 37 vectors cover the registers and the scalar tail.
+    std::vector<vec3> normals;
+    for (int i = 0; i < 37; ++i)
+        normals.emplace_back(float(i) / 37 - 0.5f, 1000.5f * float(i) - 3e4f, 1e-6f * float(i));
+    normals[3].x = NAN;
+    std::vector<hvec3> halves(normals.size());
+    std::vector<bf16vec3> bfloats(normals.size());
+    std::vector<vec3> back(normals.size());
+    bool matches = true;
+
+    narrow<hvec3>(normals, halves);
+    widen<hvec3>(halves, back);
+    for (size_t i = 0; i < normals.size(); ++i) {
+        for (size_t k = 0; k < 3; ++k)
+            matches &= halves[i][k].bits == half(normals[i][k]).bits &&
+                       std::bit_cast<uint32_t>(back[i][k]) == std::bit_cast<uint32_t>(float(halves[i][k]));
+    }
+
+    narrow<bf16vec3>(normals, bfloats);
+    widen<bf16vec3>(bfloats, back);
+    for (size_t i = 0; i < normals.size(); ++i) {
+        for (size_t k = 0; k < 3; ++k)
+            matches &= bfloats[i][k].bits == bfloat16(normals[i][k]).bits &&
+                       std::bit_cast<uint32_t>(back[i][k]) == std::bit_cast<uint32_t>(float(bfloats[i][k]));
+    }
+
+    CHECK(matches, true);
+}
+
+void test_double() {
+    static_assert(std::same_as<dmat4x3::ColumnType, dvec4> && std::same_as<dmat3, Matrix<double, 3, 3>>);
+    static_assert(determinant(dmat4(2)) == 16 && inverse(dmat4(4)) == dmat4(0.25));
+    static_assert(std::same_as<decltype(radians(1.0f)), float> && radians(180.0f) == std::numbers::pi_v<float>);
+
+    CHECK(degrees(dvec2(pi, -pi / 2)), dvec2(180, -90));
+    CHECK(dmat2(1, 2, 3, 4) * dvec2(1, 1), dvec2(4, 6));
+    CHECK(dmat4x3(1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12) * dvec3(1, 0, 2), dvec4(19, 22, 25, 28));
+    CHECK(dmat4x2(1, 2, 3, 4, 5, 6, 7, 8) * dmat2(1, 0, 1, 1), dmat4x2(1, 2, 3, 4, 6, 8, 10, 12));
+    CHECK(determinant(dmat4(0, 1, 0, 0, 1, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 2)), -2.0);
+    CHECK(determinant(dmat4(dvec4(1), dvec4(2), dvec4(3), dvec4(4))), 0.0);
+
+    // The AVX2 kernels (under GLSL_ISA=sse2 the build's own path) against the scalar closed forms and LU.
+    CHECK_BLOCK({
+        bool matches = true;
+        for (int k = 0; k < 16; ++k) {
+            dmat4 m;
+            dmat4 n;
+            for (size_t i = 0; i < 16; ++i) {
+                m.at(i) = double(int(i * 7 + size_t(k) * 5) % 11) - 5 + (i % 5 == 0 ? 12 : 0);
+                n.at(i) = double(int(i * 3 + size_t(k)) % 7) * 0.5 - 1;
+            }
+            dmat4 product = m * n;
+            dvec4 v = m * n[1];
+            for (size_t col = 0; col < 4; ++col) {
+                for (size_t row = 0; row < 4; ++row) {
+                    double sum = 0;
+                    for (size_t i = 0; i < 4; ++i)
+                        sum += m.at(row, i) * n.at(i, col);
+                    matches &= product.at(row, col) == sum && (col != 1 || v[row] == sum);
+                }
+            }
+            auto f = lu(m);
+            dmat4 identity = inverse(m) * m;
+            for (size_t col = 0; col < 4; ++col)
+                matches &= all(lessThan(abs(identity[col] - dmat4(1)[col]), dvec4(1e-12)));
+            matches &= std::abs(determinant(m) - f.determinant()) < 1e-9 * std::abs(f.determinant());
+        }
+        return matches;
+    }, true);
+}
+
+void test_noise() {
+    static_assert(std::same_as<decltype(noise1(vec3(0))), float> && std::same_as<decltype(noise3(dvec2(0))), dvec3>);
+    static_assert(std::same_as<decltype(noise4(1.0f)), vec4>);
+
+    CHECK(perlin(vec3(1, -2, 3)), 0.0f);
+    CHECK(perlin(dvec4(-7, 0, 5, 288)), 0.0);
+    CHECK(perlin(-5.0f), 0.0f);
+    CHECK(noise1(vec2(0.3f, 1.7f)), simplex(vec2(0.3f, 1.7f)));
+    CHECK(noise2(0.5f).y, simplex(0.5f + 19.19f));
+    // Period 289 on every axis.
+    CHECK(std::abs(simplex(dvec3(0.25, 1.5, -2.75)) - simplex(dvec3(289.25, 1.5, -291.75))) < 1e-9, true);
+
+    // In [-1, 1], close to the ends, and the analytic gradients against central differences.
+    bool matches = true;
+    double low = 0;
+    double high = 0;
+    for (int i = 0; i < 2000; ++i) {
+        dvec4 p(std::sin(i * 12.9898) * 40, std::sin(i * 78.233) * 40, std::sin(i * 37.719) * 40, i * 0.0137);
+        dvec3 p3(p.x, p.y, p.z);
+        dvec2 p2(p.x, p.y);
+        dvec4 g4;
+        dvec3 g3;
+        dvec2 g2;
+        double g1;
+        double values[] = {simplex(p, g4), simplex(p3, g3), simplex(p2, g2), simplex(p.x, g1),
+                           perlin(p), perlin(p3), perlin(p2), perlin(p.x)};
+        for (double v : values) {
+            low = std::min(low, v);
+            high = std::max(high, v);
+        }
+        for (size_t k = 0; k < 4; ++k) {
+            dvec4 e(0);
+            e[k] = 1e-6;
+            dvec4 above = p + e;
+            dvec4 below = p - e;
+            matches &= std::abs((perlin(above) - perlin(below)) / 2e-6 - (perlin(p, g4), g4[k])) < 1e-6;
+            matches &= std::abs((simplex(above) - simplex(below)) / 2e-6 - (simplex(p, g4), g4[k])) < 1e-6;
+        }
+        matches &= std::abs((simplex(dvec3(p3 + dvec3(0, 1e-6, 0))) - simplex(dvec3(p3 - dvec3(0, 1e-6, 0)))) / 2e-6 - g3.y) < 1e-6;
+        matches &= std::abs((simplex(dvec2(p2 + dvec2(1e-6, 0))) - simplex(dvec2(p2 - dvec2(1e-6, 0)))) / 2e-6 - g2.x) < 1e-6;
+        matches &= std::abs((simplex(p.x + 1e-6) - simplex(p.x - 1e-6)) / 2e-6 - g1) < 1e-6;
+    }
+    CHECK(matches, true);
+    CHECK(low >= -1 && high <= 1 && low < -0.6 && high > 0.6, true);
+
+    // The packet kernels of the spans and grids (split across threads under GLSL_THREADS) against the builtins,
+    // within the rounding of float coordinates near 100 (FMA builds contract the scalar and packet code differently).
+    uvec3 size(37, 16, 16);
+    vec3 origin(-3.5f, 2.25f, 100.0f);
+    vec3 step(0.173f, 0.091f, 0.25f);
+    size_t count = size.x * size.y * size.z;
+    std::vector<vec3> points(count);
+    std::vector<float> values(count);
+    std::vector<float> grid(count);
+    std::vector<vec3> gradients(count);
+    std::vector<vec3> grid_gradients(count);
+    for (size_t i = 0; i < count; ++i)
+        points[i] = origin + vec3(float(i % size.x), float(i / size.x % size.y), float(i / size.x / size.y)) * step;
+
+    matches = true;
+    simplex<vec3>(points, values, gradients);
+    simplex(origin, step, size, grid, grid_gradients);
+    for (size_t i = 0; i < count; ++i) {
+        vec3 g;
+        float v = simplex(points[i], g);
+        matches &= std::abs(values[i] - v) < 1e-4f && std::abs(grid[i] - v) < 1e-4f &&
+                   all(lessThan(abs(gradients[i] - g), vec3(1e-3f))) && all(lessThan(abs(grid_gradients[i] - g), vec3(1e-3f)));
+    }
+
+    perlin<vec3>(points, values);
+    perlin(origin, step, size, grid);
+    for (size_t i = 0; i < count; ++i)
+        matches &= std::abs(values[i] - perlin(points[i])) < 1e-4f && std::abs(grid[i] - perlin(points[i])) < 1e-4f;
+
+    std::vector<vec2> plane(101);
+    std::vector<float> heights(101);
+    for (size_t i = 0; i < plane.size(); ++i)
+        plane[i] = vec2(float(i) * 0.37f, -float(i) * 0.11f);
+    simplex<vec2>(plane, heights);
+    for (size_t i = 0; i < plane.size(); ++i)
+        matches &= std::abs(heights[i] - simplex(plane[i])) < 1e-5f;
+    CHECK(matches, true);
+}
+
+void test_fragment() {
+    // Tiles cut at the right and top edges, every pixel once, in each pixel format.
+    unsigned width = 67;
+    unsigned height = 45;
+    auto shader = [&](vec2 fragCoord) {
+        return vec4(fragCoord.x / float(width), fragCoord.y / float(height), 0.25f, 1);
+    };
+    std::vector<vec4> colors(width * height);
+    std::vector<uint32_t> packed(width * height);
+    std::vector<hvec4> halves(width * height);
+    run_fragment<vec4>(width, height, shader, colors);
+    run_fragment<uint32_t>(width, height, shader, packed);
+    run_fragment<hvec4>(width, height, shader, halves);
+
+    bool matches = true;
+    for (unsigned y = 0; y < height; ++y) {
+        for (unsigned x = 0; x < width; ++x) {
+            vec4 expected = shader(vec2(float(x) + 0.5f, float(y) + 0.5f));
+            size_t i = x + y * width;
+            matches &= all(equal(colors[i], expected)) && packed[i] == packUnorm4x8(expected) &&
+                       all(equal(vec4(halves[i]), vec4(hvec4(expected))));
+        }
+    }
+    CHECK(matches, true);
+    CHECK(packed[0], packUnorm4x8(vec4(0.5f / 67, 0.5f / 45, 0.25f, 1)));
+
+    // A run issued from a task runs on its own thread instead of waiting for the busy pool.
+    std::vector<int> counts(64);
+    auto& pool = details::parallel::ThreadPool::shared();
+    pool.run(16, [&](size_t i) {
+        pool.run(4, [&](size_t j) {
+            ++counts[i * 4 + j];
+        });
+    });
+    CHECK(std::count(counts.begin(), counts.end(), 1), 64l);
+}
+
+void test_quad() {
+    static_assert(dFdx(Quad<float>(1, 3, 5, 9))[1] == 2 && dFdx(Quad<float>(1, 3, 5, 9))[2] == 4);
+
+    CHECK(dFdx(Quad<float>(1, 3, 5, 9)), Quad<float>(2, 2, 4, 4));
+    CHECK(dFdy(Quad<float>(1, 3, 5, 9)), Quad<float>(4, 6, 4, 6));
+    CHECK(dFdxCoarse(Quad<float>(1, 3, 5, 9)), Quad<float>(2));
+    CHECK(dFdyCoarse(Quad<float>(1, 3, 5, 9)), Quad<float>(4));
+    CHECK(fwidth(Quad<float>(1, -3, 5, 9)), Quad<float>(8, 16, 8, 16));
+    CHECK(fwidthCoarse(Quad<double>(1, -3, 5, 9)), Quad<double>(8));
+
+    // d(x^2 + 3y)/dx along each row is (x + 1)^2 - x^2; a vector differentiates per component.
+    CHECK(run_quad(vec2(10.5f, 20.5f), [](auto p) { return dFdx(p.x * p.x + p.y * 3.0f); }), Quad<float>(22, 22, 22, 22));
+    CHECK(run_quad(vec2(0.5f, 0.5f), [](auto p) { return dFdy(p.yx * 2.0f).x; }), Quad<float>(2));
+    CHECK(run_quad(vec2(0.5f, 0.5f), [](auto p) { return fwidth(Vector<Quad<float>, 3>(p.x, p.y * 2.0f, p.x + p.y * 3.0f)).z; }), Quad<float>(4));
+
+    // The quad shader against its analytic derivatives, on an odd framebuffer that cuts quads at the edges.
+    unsigned width = 67;
+    unsigned height = 45;
+    std::vector<vec4> colors(width * height);
+    run_fragment_quads<vec4>(width, height, [](auto p) {
+        return Vector<Quad<float>, 4>(p.x, p.y, dFdx(p.x * p.x), fwidth(p.y * 3.0f));
+    }, colors);
+
+    bool matches = true;
+    for (unsigned y = 0; y < height; ++y) {
+        for (unsigned x = 0; x < width; ++x) {
+            float left = float(x & ~1u) + 0.5f;
+            vec4 expected(float(x) + 0.5f, float(y) + 0.5f, 2 * left + 1, 3);
+            matches &= all(equal(colors[x + y * width], expected));
+        }
+    }
+    CHECK(matches, true);
+}
+
+void test_texture() {
+    // A size that is not a whole number of tiles reads back what it was given, wherever the tiles cut it.
+    std::vector<vec4> image(13 * 11);
+    for (size_t i = 0; i < image.size(); ++i)
+        image[i] = vec4(float(i % 13), float(i / 13), 0, 1);
+    Texture2D<vec4> colors(13, 11, image);
+    bool matches = true;
+    for (int y = 0; y < 11; ++y) {
+        for (int x = 0; x < 13; ++x)
+            matches &= all(equal(texelFetch(colors, ivec2(x, y), 0), image[size_t(x + y * 13)]));
+    }
+    CHECK(matches, true);
+    CHECK(textureSize(colors, 0), ivec2(13, 11));
+    CHECK(colors.levels(), 1);
+
+    // Texel centers, the bilinear mix between them, and the wrap modes one texel left of the image.
+    CHECK(texture(colors, vec2(2.5f / 13, 3.5f / 11)), vec4(2, 3, 0, 1));
+    CHECK(texture(colors, vec2(3.0f / 13, 4.25f / 11)), vec4(2.5f, 3.75f, 0, 1));
+    colors.sampler.magFilter = Filter::nearest;
+    CHECK(texture(colors, vec2(-0.5f / 13, 0.5f / 11)).x, 12.0f);
+    colors.sampler.wrapS = Wrap::mirrored_repeat;
+    CHECK(texture(colors, vec2(-0.5f / 13, 0.5f / 11)).x, 0.0f);
+    CHECK(texture(colors, vec2(-13.5f / 13, 0.5f / 11)).x, 12.0f);
+    colors.sampler.wrapS = Wrap::clamp_to_edge;
+    CHECK(texture(colors, vec2(-5.0f, 0.5f / 11)).x, 0.0f);
+    CHECK(texture(colors, vec2(5.0f, 0.5f / 11)).x, 12.0f);
+    CHECK(texture(colors, vec2(std::nanf(""), 0.5f / 11)).x, 0.0f);
+
+    // The mip chain of x + 16 y: each level the 2x2 means of the one above, down to the mean of the image.
+    std::vector<float> ramp(16 * 8);
+    for (size_t i = 0; i < ramp.size(); ++i)
+        ramp[i] = float(i % 16) + 16.0f * float(i / 16);
+    Texture2D<float> tex(16, 8, ramp);
+    tex.generateMipmap();
+    CHECK(tex.levels(), 5);
+    CHECK(textureSize(tex, 2), ivec2(4, 2));
+    CHECK(texelFetch(tex, ivec2(3, 1), 1), 6.5f + 16 * 2.5f);
+    CHECK(texelFetch(tex, ivec2(0, 0), 4), 7.5f + 16 * 3.5f);
+
+    // Trilinear filtering mixes two levels, nearest picks one; a quad takes its level from its derivatives.
+    vec2 uv(0.3f, 0.6f);
+    CHECK(textureLod(tex, uv, 1.25f), 0.75f * textureLod(tex, uv, 1) + 0.25f * textureLod(tex, uv, 2));
+    CHECK(textureLod(tex, uv, 9), texelFetch(tex, ivec2(0, 0), 4));
+    CHECK(textureGrad(tex, uv, vec2(4.0f / 16, 0), vec2(0, 1.0f / 8)), textureLod(tex, uv, 2));
+    auto sampled = run_quad(vec2(3.5f, 1.5f), [&](auto p) {
+        return texture(tex, Vector<Quad<float>, 2>(p.x * (2.0f / 16), p.y * (2.0f / 8)));
+    });
+    CHECK(sampled[3], textureLod(tex, vec2(4.5f * 2 / 16, 2.5f * 2 / 8), 1));
+    CHECK(texture(colors, Vector<Quad<float>, 2>(Quad<float>(0.5f / 13), Quad<float>(1.5f / 11))).y, Quad<float>(1));
+    tex.sampler.mipFilter = MipFilter::nearest;
+    CHECK(textureLod(tex, uv, 1.25f), textureLod(tex, uv, 1));
+
+    // Batched lookups split across threads match one at a time, half texels sample as float.
+    std::vector<vec2> uvs(40000);
+    for (size_t i = 0; i < uvs.size(); ++i)
+        uvs[i] = vec2(float(i % 211) * 0.013f - 0.7f, float(i % 307) * 0.0071f);
+    std::vector<hvec4> halves(image.size());
+    narrow<hvec4>(image, halves);
+    Texture2D<hvec4> packed(13, 11, halves, Sampler{ .wrapS = Wrap::mirrored_repeat });
+    std::vector<vec4> batched(uvs.size());
+    texture(packed, uvs, batched, 0.5f);
+    std::vector<float> levels(uvs.size());
+    textureLod(tex, uvs, 1.5f, levels);
+    matches = true;
+    for (size_t i = 0; i < uvs.size(); ++i)
+        matches &= all(equal(batched[i], texture(packed, uvs[i], 0.5f))) && levels[i] == textureLod(tex, uvs[i], 1.5f);
+    CHECK(matches, true);
+}
+
+void test_volume_file(const std::filesystem::path& path) {
+    // A volume cut by the brick edges on every axis, written brick by brick and mapped back.
+    auto linear = [](ivec3 p) { return vec2(float(p.x + 40 * p.y), float(p.z)); };
+    Texture3D<vec2>::create(path, uvec3(37, 20, 18), linear);
+    Texture3D<vec2> volume(path, Sampler{ .wrapS = Wrap::clamp_to_edge, .wrapT = Wrap::clamp_to_edge,
+                                          .wrapR = Wrap::clamp_to_edge });
+    CHECK(textureSize(volume, 0), ivec3(37, 20, 18));
+    bool matches = true;
+    for (int z = 0; z < 18; ++z) {
+        for (int y = 0; y < 20; ++y) {
+            for (int x = 0; x < 37; ++x)
+                matches &= all(equal(texelFetch(volume, ivec3(x, y, z), 0), linear(ivec3(x, y, z))));
+        }
+    }
+    CHECK(matches, true);
+
+    // Trilinear filtering reproduces a linear function between texel centers, across bricks, and clamps.
+    CHECK(texture(volume, vec3(16.25f / 37, 15.5f / 20, 16.75f / 18)), vec2(15.75f + 40 * 15, 16.25f));
+    CHECK(texture(volume, vec3(-1.0f, 2.0f, 0.5f / 18)), vec2(40 * 19, 0));
+    volume.sampler.magFilter = Filter::nearest;
+    CHECK(texture(volume, vec3(16.25f / 37, 15.5f / 20, 16.75f / 18)), vec2(16 + 40 * 15, 16));
+    volume.sampler = Sampler{};
+    CHECK(texture(volume, vec3(-0.5f / 37, 0.5f / 20, 0.5f / 18)).x, 36.0f);
+
+    // Lookups sorted by brick land where they came from.
+    std::vector<vec3> uvw(30000);
+    for (size_t i = 0; i < uvw.size(); ++i)
+        uvw[i] = vec3(float(i * 7919 % 1000) * 0.0013f - 0.2f, float(i % 307) * 0.0037f, float(i * 31 % 101) * 0.011f);
+    std::vector<vec2> batched(uvw.size());
+    texture(volume, uvw, batched);
+    matches = true;
+    for (size_t i = 0; i < uvw.size(); ++i)
+        matches &= all(equal(batched[i], texture(volume, uvw[i])));
+    CHECK(matches, true);
+
+    Texture3D<vec2> moved = std::move(volume);
+    CHECK(texelFetch(moved, ivec3(36, 19, 17), 0), vec2(36 + 40 * 19, 17));
+    bool rejected = false;
+    try {
+        Texture3D<vec4> wrong(path);
+    } catch (const std::runtime_error&) {
+        rejected = true;
+    }
+    CHECK(rejected, true);
+
+    // Empty volumes are refused when written, and when a header claims one.
+    rejected = false;
+    try {
+        Texture3D<vec2>::create(path, uvec3(4, 0, 4), linear);
+    } catch (const std::runtime_error&) {
+        rejected = true;
+    }
+    CHECK(rejected, true);
+    Texture3D<vec2>::create(path, uvec3(1, 1, 1), linear);
+    {
+        std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+        uint32_t zero = 0;
+        file.seekp(offsetof(details::volume::Header, depth));
+        file.write(reinterpret_cast<const char*>(&zero), sizeof(zero));
+    }
+    rejected = false;
+    try {
+        Texture3D<vec2> empty(path);
+    } catch (const std::runtime_error&) {
+        rejected = true;
+    }
+    CHECK(rejected, true);
+}
+
+void test_volume() {
+    // ctest runs the test binaries in parallel: each maps a file of its own, removed however the test ends.
+    struct TemporaryFile {
+        std::filesystem::path path = std::filesystem::temp_directory_path() /
+                                     ("glsl_test_volume_" + std::to_string(::getpid()) + ".vol");
+        ~TemporaryFile() {
+            std::error_code ignored;
+            std::filesystem::remove(path, ignored);
+        }
+    } file;
+
+    try {
+        test_volume_file(file.path);
+    } catch (const std::exception& e) {
+        test::error("check: test_volume threw ", e.what());
+        test::has_error = true;
+    }
 }
 
 int main() {
     test_vector_default();
     test_vector_functions();
     test_matrix();
+    test_simd_vector();
+    test_batch();
+    test_transform();
+    test_dispatch();
+    test_precision();
+    test_vmath();
+    test_expr();
+    test_quaternion();
+    test_packing();
+    test_integer();
+    test_half();
+    test_double();
+    test_noise();
+    test_fragment();
+    test_quad();
+    test_texture();
+    test_volume();
 
     return glsl::test::has_error ? 1 : 0;
 }
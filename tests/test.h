@@ -3,6 +3,7 @@
 #include <iostream>
 #include <numeric>
 #include <ranges>
+#include <vector>
 
 #include "glsl/glsl.h"
 
@@ -34,7 +35,7 @@ template<class T, class TE>
 constexpr void check(T &&result, TE &&expected, std::string_view msg = "")
 requires requires { result != expected; } {
     println("check: ", msg, " -> ", result);
-    if (result != expected) {
+    if (glsl::any(result != expected)) {
         error("    expected: ", expected);
         has_error = true;
     }
@@ -50,4 +51,18 @@ using vec4x2 = glsl::Vector<vec2, 4>;
 using vec4x3 = glsl::Vector<vec3, 4>;
 using vec4x4 = glsl::Vector<vec4, 4>;
 
+using simd_vec2 = glsl::Vector<float, 2, SimdVectorTrait>;
+using simd_vec3 = glsl::Vector<float, 3, SimdVectorTrait>;
+using simd_vec4 = glsl::Vector<float, 4, SimdVectorTrait>;
+using simd_dvec2 = glsl::Vector<double, 2, SimdVectorTrait>;
+using simd_dvec4 = glsl::Vector<double, 4, SimdVectorTrait>;
+
+using batch4 = glsl::Batch<float, 4>;
+using batch8 = glsl::Batch<float, 8>;
+using ibatch4 = glsl::Batch<int, 4>;
+using bbatch4 = glsl::Batch<bool, 4>;
+using batch4_vec2 = glsl::Vector<batch4, 2>;
+using batch4_vec3 = glsl::Vector<batch4, 3>;
+using batch4_mat2 = glsl::Matrix<batch4, 2, 2>;
+
 } // namespace glsl::test